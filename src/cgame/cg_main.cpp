@@ -1809,6 +1809,9 @@ void CG_Init(int serverMessageNum, int serverCommandSequence, int clientNum)
 
     CG_RegisterCvars();
 
+    // let the server batch configstring updates, see CG_ConfigStringBatch
+    Cvar_Set("cl_csBatch", "1");
+
     CG_InitConsoleCommands();
 
     String_Init();
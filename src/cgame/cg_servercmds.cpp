@@ -258,20 +258,14 @@ static void CG_AnnounceHumanStageTransistion(stage_t from, stage_t to)
 
 /*
 ================
-CG_ConfigStringModified
+CG_ConfigStringChanged
 
+Acts on configstring num, cgs.gameState must already hold the new value
 ================
 */
-static void CG_ConfigStringModified(void)
+static void CG_ConfigStringChanged(int num)
 {
     const char *str;
-    int num;
-
-    num = atoi(CG_Argv(1));
-
-    // get the gamestate from the client system, which will have the
-    // new configstring already integrated
-    CL_GetGameState(&cgs.gameState);
 
     // look up the individual string that was modified
     str = CG_ConfigString(num);
@@ -373,6 +367,44 @@ static void CG_ConfigStringModified(void)
     }
 }
 
+/*
+================
+CG_ConfigStringModified
+
+================
+*/
+static void CG_ConfigStringModified(void)
+{
+    // get the gamestate from the client system, which will have the
+    // new configstring already integrated
+    CL_GetGameState(&cgs.gameState);
+
+    CG_ConfigStringChanged(atoi(CG_Argv(1)));
+}
+
+/*
+================
+CG_ConfigStringBatch
+
+A batch of configstring updates, the client system has applied all of them
+================
+*/
+static void CG_ConfigStringBatch(void)
+{
+    int nums[MAX_STRING_TOKENS];
+    int count = 0;
+
+    // the arguments are pairs of an index (with an optional delta header)
+    // and a string, collect them first since acting on a change can retokenize
+    for (int i = 1; i + 1 < Cmd_Argc() && count < MAX_STRING_TOKENS; i += 2)
+        nums[count++] = atoi(CG_Argv(i));
+
+    CL_GetGameState(&cgs.gameState);
+
+    for (int i = 0; i < count; i++)
+        CG_ConfigStringChanged(nums[i]);
+}
+
 /*
 ===============
 CG_MapRestart
@@ -1263,6 +1295,7 @@ static consoleCommand_t svcommands[] = {
     {"cmds", CG_GameCmds_f},
     {"cp", CG_CenterPrint_f},
     {"cs", CG_ConfigStringModified},
+    {"csb", CG_ConfigStringBatch},
     {"map_restart", CG_MapRestart},
     {"poisoncloud", CG_PoisonCloud_f},
     {"print", CG_Print_f},
@@ -176,21 +176,14 @@ void CL_SetUserCmdValue( int userCmdValue, float sensitivityScale ) {
 
 /*
 =====================
-CL_ConfigstringModified
+CL_SetConfigstrings
+
+Rebuilds the gameState with the non-NULL entries of values replacing
+the current configstrings
 =====================
 */
-void CL_ConfigstringModified( void )
+static void CL_SetConfigstrings( const char **values )
 {
-	int idx = atoi( Cmd_Argv(1) );
-	if ( idx < 0 || idx >= MAX_CONFIGSTRINGS )
-		Com_Error( ERR_DROP, "CL_ConfigstringModified: bad index %i", idx );
-
-	// get everything after "cs <num>"
-	const char* s = Cmd_ArgsFrom(2);
-	const char* old = cl.gameState.stringData + cl.gameState.stringOffsets[ idx ];
-	if ( !strcmp(old, s) )
-		return;
-
 	// build the new gameState_t
 	gameState_t	oldGs = cl.gameState;
 
@@ -202,8 +195,8 @@ void CL_ConfigstringModified( void )
     const char* dup;
 	for ( int i = 0 ; i < MAX_CONFIGSTRINGS ; i++ )
     {
-		if ( i == idx )
-			dup = s;
+		if ( values[ i ] )
+			dup = values[ i ];
         else
 			dup = oldGs.stringData + oldGs.stringOffsets[ i ];
 
@@ -220,13 +213,79 @@ void CL_ConfigstringModified( void )
 		cl.gameState.dataCount += len + 1;
 	}
 
-	if ( idx == CS_SYSTEMINFO )
+	if ( values[ CS_SYSTEMINFO ] )
     {
 		// parse serverId and other cvars
 		CL_SystemInfoChanged();
 	}
 }
 
+/*
+=====================
+CL_ConfigstringModified
+=====================
+*/
+void CL_ConfigstringModified( void )
+{
+	const char *values[ MAX_CONFIGSTRINGS ] = {};
+
+	int idx = atoi( Cmd_Argv(1) );
+	if ( idx < 0 || idx >= MAX_CONFIGSTRINGS )
+		Com_Error( ERR_DROP, "CL_ConfigstringModified: bad index %i", idx );
+
+	// get everything after "cs <num>"
+	const char* s = Cmd_ArgsFrom(2);
+	const char* old = cl.gameState.stringData + cl.gameState.stringOffsets[ idx ];
+	if ( !strcmp(old, s) )
+		return;
+
+	values[ idx ] = s;
+	CL_SetConfigstrings( values );
+}
+
+/*
+=====================
+CL_ConfigstringBatch
+
+Applies a csb command, see SV_FlushConfigstrings
+=====================
+*/
+static void CL_ConfigstringBatch( void )
+{
+	static char data[ MAX_GAMESTATE_CHARS ];
+	const char *values[ MAX_CONFIGSTRINGS ] = {};
+	int used = 0;
+
+	for ( int i = 1; i + 1 < Cmd_Argc(); i += 2 )
+    {
+		int idx, keep = 0, tail = 0;
+
+		if ( sscanf( Cmd_Argv(i), "%d:%d:%d", &idx, &keep, &tail ) < 1 || idx < 0 || idx >= MAX_CONFIGSTRINGS )
+			Com_Error( ERR_DROP, "CL_ConfigstringBatch: bad index %s", Cmd_Argv(i) );
+
+		const char *old = values[ idx ] ? values[ idx ] : cl.gameState.stringData + cl.gameState.stringOffsets[ idx ];
+		const char *middle = Cmd_Argv( i + 1 );
+		int oldLen = strlen( old );
+		int middleLen = strlen( middle );
+
+		if ( keep < 0 || tail < 0 || keep + tail > oldLen )
+			Com_Error( ERR_DROP, "CL_ConfigstringBatch: bad delta for %i", idx );
+
+		if ( used + keep + middleLen + tail + 1 > (int)sizeof( data ) )
+			Com_Error( ERR_DROP, "CL_ConfigstringBatch: batch too large" );
+
+		char *out = data + used;
+		::memcpy( out, old, keep );
+		::memcpy( out + keep, middle, middleLen );
+		::memcpy( out + keep + middleLen, old + oldLen - tail, tail );
+		out[ keep + middleLen + tail ] = '\0';
+
+		values[ idx ] = out;
+		used += keep + middleLen + tail + 1;
+	}
+
+	CL_SetConfigstrings( values );
+}
 
 /*
 ===================
@@ -316,6 +375,15 @@ rescan:
 		return true;
 	}
 
+	if ( !strcmp( cmd, "csb" ) )
+    {
+		// deltas sent before the last gamestate are older than what it holds
+		if ( serverCommandNumber > clc.gamestateCommandSequence )
+			CL_ConfigstringBatch();
+		Cmd_TokenizeString2(s, false);
+		return true;
+	}
+
 	if ( !strcmp( cmd, "map_restart" ) )
     {
 		// clear notify lines and outgoing commands before passing
@@ -379,6 +447,9 @@ void CL_ShutdownCGame( void ) {
 	cls.cgame->Call( CG_SHUTDOWN );
 	delete cls.cgame;
 	cls.cgame = nullptr;
+
+	// the next cgame has to say it understands csb again
+	Cvar_Set( "cl_csBatch", "0" );
 }
 
 static int	FloatAsInt( float f ) {
@@ -414,6 +485,33 @@ intptr_t CL_CgameSystemCalls( intptr_t *args )
 			args[0] = CG_PARSE_SOURCE_FILE_AND_LINE - 1337 - args[0] ;
 	}
 
+	// demo_seek runs frames that are never seen or heard
+	if( clc.demoFastForward )
+	{
+		switch( args[0] )
+		{
+			case CG_S_STARTSOUND:
+			case CG_S_STARTLOCALSOUND:
+			case CG_S_ADDLOOPINGSOUND:
+			case CG_S_ADDREALLOOPINGSOUND:
+			case CG_S_UPDATEENTITYPOSITION:
+			case CG_S_RESPATIALIZE:
+			case CG_R_CLEARSCENE:
+			case CG_R_ADDREFENTITYTOSCENE:
+			case CG_R_ADDPOLYTOSCENE:
+			case CG_R_ADDPOLYSTOSCENE:
+			case CG_R_ADDLIGHTTOSCENE:
+			case CG_R_ADDADDITIVELIGHTTOSCENE:
+			case CG_R_RENDERSCENE:
+			case CG_R_SETCOLOR:
+			case CG_R_SETCLIPREGION:
+			case CG_R_DRAWSTRETCHPIC:
+				return 0;
+			default:
+				break;
+		}
+	}
+
 	switch( args[0] )
     {
         case CG_PRINT:
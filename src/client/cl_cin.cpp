@@ -1802,13 +1802,12 @@ void CIN_DrawCinematic(int handle)
         (cinTable[handle].CIN_WIDTH != cinTable[handle].drawX
          || cinTable[handle].CIN_HEIGHT != cinTable[handle].drawY))
     {
-        int *buf2 = (int *)Hunk_AllocateTempMemory(256 * 256 * 4);
+        int *buf2 = (int *)Com_FrameAlloc(256 * 256 * 4);
 
         CIN_ResampleCinematic(handle, buf2);
 
         re.DrawStretchRaw(x, y, w, h, 256, 256, (byte *)buf2, handle, true);
         cinTable[handle].dirty = false;
-        Hunk_FreeTempMemory(buf2);
         return;
     }
 
@@ -1910,14 +1909,13 @@ void CIN_UploadCinematic(int handle)
         if (cinTable[handle].dirty && (cinTable[handle].CIN_WIDTH != cinTable[handle].drawX ||
                                           cinTable[handle].CIN_HEIGHT != cinTable[handle].drawY))
         {
-            int *buf2 = (int *)Hunk_AllocateTempMemory(256 * 256 * 4);
+            int *buf2 = (int *)Com_FrameAlloc(256 * 256 * 4);
 
             CIN_ResampleCinematic(handle, buf2);
 
             re.UploadCinematic(
                 cinTable[handle].CIN_WIDTH, cinTable[handle].CIN_HEIGHT, 256, 256, (byte *)buf2, handle, true);
             cinTable[handle].dirty = false;
-            Hunk_FreeTempMemory(buf2);
         }
         else
         {
@@ -229,7 +229,7 @@ void Con_Dump_f (void)
 	bufferlen = con.linewidth + 2 * sizeof ( char );
 #endif
 
-	buffer = (char*)Hunk_AllocateTempMemory( bufferlen );
+	buffer = (char*)Com_FrameAlloc( bufferlen );
 
 	// write the remaining lines
 	buffer[bufferlen-1] = 0;
@@ -253,7 +253,6 @@ void Con_Dump_f (void)
 		FS_Write(buffer, strlen(buffer), f);
 	}
 
-	Hunk_FreeTempMemory( buffer );
 	FS_FCloseFile( f );
 }
 
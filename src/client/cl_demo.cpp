@@ -0,0 +1,799 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2018 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#include "client.h"
+
+#include "zlib.h"
+
+/*
+=======================================================================
+
+INDEXED DEMOS
+
+An indexed demo (.dmi_) holds the same messages as a classic .dm_ demo,
+grouped into chunks that can be compressed:
+
+16	header: magic, version, protocol, reserved
+<chunks>
+4	-1
+<index>	count, then a (serverTime, offset) pair per keyframe chunk
+8	index offset, magic
+
+Each chunk has a 20 byte header (raw length, stored length, flags,
+serverTime, keyframe message count) followed by the stored bytes.  The raw
+bytes are a run of [sequence] [length] [message] records.
+
+A keyframe chunk starts with a gamestate and a non-delta snapshot rebuilt
+from the client state, so playback can start there.  Normal playback skips
+those messages.  If the index is missing, because the recording was cut
+short, it is rebuilt by walking the chunk headers.
+
+=======================================================================
+*/
+
+#define DEMO_MAGIC (('1' << 24) | ('M' << 16) | ('D' << 8) | 'I')
+#define DEMO_VERSION 1
+#define DEMO_HEADER_SIZE 16
+#define DEMO_CHUNK_HEADER_SIZE 20
+
+#define DEMO_CHUNK_SIZE 0x10000  // flush once this many raw bytes are queued
+#define DEMO_CHUNK_MAX 0x20000
+#define DEMO_MAX_KEYFRAMES 4096
+
+#define DEMO_CHUNK_KEYFRAME 1
+#define DEMO_CHUNK_DEFLATE 2
+
+#define DEMO_SEEK_STEP 50  // msec of demo time per skipped cgame frame
+#define DEMO_SEEK_FRAME_MSEC 50  // real time spent fast forwarding per frame
+
+struct demoKeyframe_t {
+    int serverTime;
+    int offset;
+};
+
+static struct {
+    byte raw[DEMO_CHUNK_MAX];
+    int rawLen;
+    int flags;
+    int serverTime;
+    int keyMessages;
+    int nextKeyframeTime;
+
+    demoKeyframe_t keyframes[DEMO_MAX_KEYFRAMES];
+    int numKeyframes;
+} demoWriter;
+
+static struct {
+    byte raw[DEMO_CHUNK_MAX];
+    int rawLen;
+    int readPos;
+    bool playKeyframe;  // don't skip the keyframe messages of the next chunk
+
+    demoKeyframe_t keyframes[DEMO_MAX_KEYFRAMES];
+    int numKeyframes;
+} demoReader;
+
+static byte demoStored[DEMO_CHUNK_MAX + DEMO_CHUNK_MAX / 8];
+
+static cvar_t *cl_demoIndexed;
+static cvar_t *cl_demoKeyframeInterval;
+static cvar_t *cl_demoCompression;
+
+/*
+====================
+CL_IndexedDemoFlush
+
+Writes out the queued chunk
+====================
+*/
+static void CL_IndexedDemoFlush(void)
+{
+    int header[5];
+    const byte *data = demoWriter.raw;
+    int stored = demoWriter.rawLen;
+
+    if (!demoWriter.rawLen)
+    {
+        return;
+    }
+
+#ifdef USE_DEMO_DEFLATE
+    if (cl_demoCompression->integer)
+    {
+        uLongf len = sizeof(demoStored);
+
+        if (compress2(demoStored, &len, demoWriter.raw, demoWriter.rawLen, Z_BEST_SPEED) == Z_OK &&
+            (int)len < demoWriter.rawLen)
+        {
+            data = demoStored;
+            stored = len;
+            demoWriter.flags |= DEMO_CHUNK_DEFLATE;
+        }
+    }
+#endif
+
+    if ((demoWriter.flags & DEMO_CHUNK_KEYFRAME) && demoWriter.numKeyframes < DEMO_MAX_KEYFRAMES)
+    {
+        demoKeyframe_t *key = &demoWriter.keyframes[demoWriter.numKeyframes++];
+
+        key->serverTime = demoWriter.serverTime;
+        key->offset = FS_FTell(clc.demofile);
+    }
+
+    header[0] = LittleLong(demoWriter.rawLen);
+    header[1] = LittleLong(stored);
+    header[2] = LittleLong(demoWriter.flags);
+    header[3] = LittleLong(demoWriter.serverTime);
+    header[4] = LittleLong(demoWriter.keyMessages);
+    FS_Write(header, sizeof(header), clc.demofile);
+    FS_Write(data, stored, clc.demofile);
+
+    demoWriter.rawLen = 0;
+    demoWriter.flags = 0;
+    demoWriter.keyMessages = 0;
+}
+
+/*
+====================
+CL_IndexedDemoBegin
+
+Called when a recording has been opened
+====================
+*/
+void CL_IndexedDemoBegin(void)
+{
+    int header[4];
+
+    demoWriter.rawLen = 0;
+    demoWriter.flags = 0;
+    demoWriter.serverTime = 0;
+    demoWriter.keyMessages = 0;
+    demoWriter.nextKeyframeTime = 0;
+    demoWriter.numKeyframes = 0;
+
+    header[0] = LittleLong(DEMO_MAGIC);
+    header[1] = LittleLong(DEMO_VERSION);
+    header[2] = LittleLong(PROTOCOL_VERSION);
+    header[3] = 0;
+    FS_Write(header, sizeof(header), clc.demofile);
+}
+
+/*
+====================
+CL_IndexedDemoAppend
+
+Queues a message in the current chunk, returns false if it doesn't fit
+====================
+*/
+static bool CL_IndexedDemoAppend(int sequence, const byte *data, int len)
+{
+    int swlen;
+
+    if (demoWriter.rawLen + 8 + len > DEMO_CHUNK_MAX)
+    {
+        return false;
+    }
+
+    swlen = LittleLong(sequence);
+    ::memcpy(demoWriter.raw + demoWriter.rawLen, &swlen, 4);
+    swlen = LittleLong(len);
+    ::memcpy(demoWriter.raw + demoWriter.rawLen + 4, &swlen, 4);
+    ::memcpy(demoWriter.raw + demoWriter.rawLen + 8, data, len);
+    demoWriter.rawLen += 8 + len;
+    return true;
+}
+
+/*
+====================
+CL_IndexedDemoWrite
+====================
+*/
+bool CL_IndexedDemoWrite(int sequence, const byte *data, int len)
+{
+    bool ok;
+
+    if (demoWriter.rawLen + 8 + len > DEMO_CHUNK_MAX)
+    {
+        CL_IndexedDemoFlush();
+    }
+
+    if (!demoWriter.rawLen)
+    {
+        demoWriter.serverTime = cl.snap.serverTime;
+    }
+
+    ok = CL_IndexedDemoAppend(sequence, data, len);
+
+    if (demoWriter.rawLen >= DEMO_CHUNK_SIZE)
+    {
+        CL_IndexedDemoFlush();
+    }
+    return ok;
+}
+
+/*
+====================
+CL_IndexedDemoDropKeyframe
+
+Gives up on a keyframe that doesn't fit in a chunk
+====================
+*/
+static void CL_IndexedDemoDropKeyframe(void)
+{
+    // the chunk was flushed before the keyframe, so it only holds the keyframe
+    Com_DPrintf("CL_IndexedDemoKeyframe: keyframe didn't fit\n");
+    demoWriter.rawLen = 0;
+    demoWriter.flags = 0;
+    demoWriter.keyMessages = 0;
+}
+
+/*
+====================
+CL_IndexedDemoKeyframe
+
+Starts a new chunk with the current gamestate and snapshot.  Commands the
+cgame hasn't executed yet are repeated so nothing is lost after a seek.
+====================
+*/
+static void CL_IndexedDemoKeyframe(void)
+{
+    byte bufData[MAX_MSGLEN];
+    msg_t buf;
+
+    CL_IndexedDemoFlush();
+    demoWriter.flags = DEMO_CHUNK_KEYFRAME;
+    demoWriter.serverTime = cl.snap.serverTime;
+
+    // the gamestate and the commands still waiting for the cgame
+    demoWriter.keyMessages = CL_WriteDemoGamestate(CL_IndexedDemoAppend);
+    if (!demoWriter.keyMessages)
+    {
+        CL_IndexedDemoDropKeyframe();
+        return;
+    }
+
+    // the snapshot, delta compressed from the baselines
+    MSG_Init(&buf, bufData, sizeof(bufData));
+    MSG_Bitstream(&buf);
+    MSG_WriteLong(&buf, clc.reliableSequence);
+    MSG_WriteByte(&buf, svc_snapshot);
+    MSG_WriteLong(&buf, cl.snap.serverTime);
+    MSG_WriteByte(&buf, 0);
+    MSG_WriteByte(&buf, cl.snap.snapFlags);
+    MSG_WriteByte(&buf, sizeof(cl.snap.areamask));
+    MSG_WriteData(&buf, cl.snap.areamask, sizeof(cl.snap.areamask));
+    MSG_WriteDeltaPlayerstate(0, &buf, NULL, &cl.snap.ps);
+    for (int i = 0; i < cl.snap.numEntities; i++)
+    {
+        entityState_t *es = &cl.parseEntities[(cl.snap.parseEntitiesNum + i) & (MAX_PARSE_ENTITIES - 1)];
+
+        MSG_WriteDeltaEntity(0, &buf, &cl.entityBaselines[es->number], es, true);
+    }
+    MSG_WriteBits(&buf, MAX_GENTITIES - 1, GENTITYNUM_BITS);
+    MSG_WriteByte(&buf, svc_EOF);
+
+    if (buf.overflowed || !CL_IndexedDemoAppend(clc.serverMessageSequence, buf.data, buf.cursize))
+    {
+        CL_IndexedDemoDropKeyframe();
+        return;
+    }
+    demoWriter.keyMessages++;
+}
+
+/*
+====================
+CL_IndexedDemoSnapshot
+
+Called after each recorded message, adds a keyframe when one is due
+====================
+*/
+void CL_IndexedDemoSnapshot(void)
+{
+    if (!cl.snap.valid || cl.snap.messageNum != clc.serverMessageSequence)
+    {
+        return;
+    }
+
+    if (cl.snap.serverTime < demoWriter.nextKeyframeTime &&
+        cl.snap.serverTime >= demoWriter.nextKeyframeTime - cl_demoKeyframeInterval->integer * 1000)
+    {
+        return;
+    }
+
+    // the first snapshot after the gamestate is a starting point already
+    if (demoWriter.nextKeyframeTime)
+    {
+        CL_IndexedDemoKeyframe();
+    }
+    demoWriter.nextKeyframeTime = cl.snap.serverTime + MAX(cl_demoKeyframeInterval->integer, 1) * 1000;
+}
+
+/*
+====================
+CL_IndexedDemoEnd
+
+Writes the index and trailer
+====================
+*/
+void CL_IndexedDemoEnd(void)
+{
+    int indexOffset;
+    int value;
+
+    CL_IndexedDemoFlush();
+
+    value = -1;
+    FS_Write(&value, 4, clc.demofile);
+
+    indexOffset = FS_FTell(clc.demofile);
+    value = LittleLong(demoWriter.numKeyframes);
+    FS_Write(&value, 4, clc.demofile);
+    for (int i = 0; i < demoWriter.numKeyframes; i++)
+    {
+        value = LittleLong(demoWriter.keyframes[i].serverTime);
+        FS_Write(&value, 4, clc.demofile);
+        value = LittleLong(demoWriter.keyframes[i].offset);
+        FS_Write(&value, 4, clc.demofile);
+    }
+
+    value = LittleLong(indexOffset);
+    FS_Write(&value, 4, clc.demofile);
+    value = LittleLong(DEMO_MAGIC);
+    FS_Write(&value, 4, clc.demofile);
+}
+
+/*
+====================
+CL_IndexedDemoLoadChunk
+====================
+*/
+static bool CL_IndexedDemoLoadChunk(void)
+{
+    int header[5];
+    int rawLen, stored, flags, keyMessages;
+
+    demoReader.rawLen = demoReader.readPos = 0;
+
+    if (FS_Read(header, 4, clc.demofile) != 4 || LittleLong(header[0]) == -1)
+    {
+        return false;
+    }
+    if (FS_Read(header + 1, sizeof(header) - 4, clc.demofile) != sizeof(header) - 4)
+    {
+        Com_Printf("Demo file was truncated.\n");
+        return false;
+    }
+
+    rawLen = LittleLong(header[0]);
+    stored = LittleLong(header[1]);
+    flags = LittleLong(header[2]);
+    keyMessages = LittleLong(header[4]);
+
+    if (rawLen < 0 || rawLen > DEMO_CHUNK_MAX || stored < 0 || stored > (int)sizeof(demoStored))
+    {
+        Com_Error(ERR_DROP, "CL_IndexedDemoLoadChunk: bad chunk size %d/%d", rawLen, stored);
+    }
+
+    if (flags & DEMO_CHUNK_DEFLATE)
+    {
+        z_stream zs;
+        int err;
+
+        if (FS_Read(demoStored, stored, clc.demofile) != stored)
+        {
+            Com_Printf("Demo file was truncated.\n");
+            return false;
+        }
+
+        ::memset(&zs, 0, sizeof(zs));
+        zs.next_in = demoStored;
+        zs.avail_in = stored;
+        zs.next_out = demoReader.raw;
+        zs.avail_out = rawLen;
+        if (inflateInit(&zs) != Z_OK)
+        {
+            Com_Error(ERR_DROP, "CL_IndexedDemoLoadChunk: inflateInit failed");
+        }
+        err = inflate(&zs, Z_FINISH);
+        inflateEnd(&zs);
+        if (err != Z_STREAM_END || (int)zs.total_out != rawLen)
+        {
+            Com_Error(ERR_DROP, "CL_IndexedDemoLoadChunk: corrupt chunk");
+        }
+    }
+    else
+    {
+        if (stored != rawLen || FS_Read(demoReader.raw, rawLen, clc.demofile) != rawLen)
+        {
+            Com_Printf("Demo file was truncated.\n");
+            return false;
+        }
+    }
+    demoReader.rawLen = rawLen;
+
+    if (demoReader.playKeyframe)
+    {
+        demoReader.playKeyframe = false;
+        return true;
+    }
+
+    // the keyframe repeats what was already played
+    for (int i = 0; i < keyMessages && demoReader.readPos + 8 <= rawLen; i++)
+    {
+        int len;
+
+        ::memcpy(&len, demoReader.raw + demoReader.readPos + 4, 4);
+        demoReader.readPos += 8 + LittleLong(len);
+    }
+    return true;
+}
+
+/*
+====================
+CL_IndexedDemoRead
+
+Fills buf with the next message, returns false at the end of the demo
+====================
+*/
+bool CL_IndexedDemoRead(msg_t *buf)
+{
+    int sequence, len;
+
+    while (demoReader.readPos >= demoReader.rawLen)
+    {
+        if (!CL_IndexedDemoLoadChunk())
+        {
+            return false;
+        }
+    }
+
+    if (demoReader.readPos + 8 > demoReader.rawLen)
+    {
+        Com_Error(ERR_DROP, "CL_IndexedDemoRead: truncated message header");
+    }
+    ::memcpy(&sequence, demoReader.raw + demoReader.readPos, 4);
+    ::memcpy(&len, demoReader.raw + demoReader.readPos + 4, 4);
+    sequence = LittleLong(sequence);
+    len = LittleLong(len);
+    demoReader.readPos += 8;
+
+    if (len < 0 || len > buf->maxsize || demoReader.readPos + len > demoReader.rawLen)
+    {
+        Com_Error(ERR_DROP, "CL_IndexedDemoRead: bad message length %d", len);
+    }
+
+    ::memcpy(buf->data, demoReader.raw + demoReader.readPos, len);
+    demoReader.readPos += len;
+
+    buf->cursize = len;
+    buf->readcount = 0;
+    clc.serverMessageSequence = sequence;
+    return true;
+}
+
+/*
+====================
+CL_IndexedDemoScanIndex
+
+Rebuilds the keyframe list of a demo that has no index
+====================
+*/
+static void CL_IndexedDemoScanIndex(void)
+{
+    int header[5];
+    int offset = DEMO_HEADER_SIZE;
+
+    FS_Seek(clc.demofile, offset, FS_SEEK_SET);
+    while (demoReader.numKeyframes < DEMO_MAX_KEYFRAMES &&
+           FS_Read(header, sizeof(header), clc.demofile) == sizeof(header) && LittleLong(header[0]) != -1)
+    {
+        int stored = LittleLong(header[1]);
+
+        if (stored < 0)
+        {
+            break;
+        }
+
+        if (LittleLong(header[2]) & DEMO_CHUNK_KEYFRAME)
+        {
+            demoKeyframe_t *key = &demoReader.keyframes[demoReader.numKeyframes++];
+
+            key->serverTime = LittleLong(header[3]);
+            key->offset = offset;
+        }
+
+        offset += DEMO_CHUNK_HEADER_SIZE + stored;
+        FS_Seek(clc.demofile, offset, FS_SEEK_SET);
+    }
+}
+
+/*
+====================
+CL_IndexedDemoOpen
+
+Reads the header and the keyframe index of clc.demofile
+====================
+*/
+bool CL_IndexedDemoOpen(void)
+{
+    int header[4];
+    int trailer[2];
+    int count;
+
+    demoReader.rawLen = demoReader.readPos = 0;
+    demoReader.playKeyframe = false;
+    demoReader.numKeyframes = 0;
+
+    if (FS_Read(header, sizeof(header), clc.demofile) != sizeof(header) ||
+        LittleLong(header[0]) != DEMO_MAGIC || LittleLong(header[1]) != DEMO_VERSION)
+    {
+        return false;
+    }
+
+    if (LittleLong(header[2]) != PROTOCOL_VERSION)
+    {
+        Com_Printf("Indexed demo protocol %d not supported\n", LittleLong(header[2]));
+        return false;
+    }
+
+    if (FS_Seek(clc.demofile, -(int)sizeof(trailer), FS_SEEK_END) >= 0 &&
+        FS_Read(trailer, sizeof(trailer), clc.demofile) == sizeof(trailer) &&
+        LittleLong(trailer[1]) == DEMO_MAGIC)
+    {
+        FS_Seek(clc.demofile, LittleLong(trailer[0]), FS_SEEK_SET);
+        FS_Read(&count, 4, clc.demofile);
+        count = LittleLong(count);
+        if (count < 0 || count > DEMO_MAX_KEYFRAMES)
+        {
+            count = 0;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            int entry[2];
+
+            if (FS_Read(entry, sizeof(entry), clc.demofile) != sizeof(entry))
+            {
+                break;
+            }
+            demoReader.keyframes[i].serverTime = LittleLong(entry[0]);
+            demoReader.keyframes[i].offset = LittleLong(entry[1]);
+            demoReader.numKeyframes++;
+        }
+    }
+    else
+    {
+        Com_Printf("Demo has no index, scanning it.\n");
+        CL_IndexedDemoScanIndex();
+    }
+
+    FS_Seek(clc.demofile, DEMO_HEADER_SIZE, FS_SEEK_SET);
+    return true;
+}
+
+/*
+====================
+CL_DemoRestartAt
+
+Plays the demo again from offset, through the gamestate it starts with
+====================
+*/
+static void CL_DemoRestartAt(int offset)
+{
+    FS_Seek(clc.demofile, offset, FS_SEEK_SET);
+    if (clc.demoIndexed)
+    {
+        demoReader.rawLen = demoReader.readPos = 0;
+        demoReader.playKeyframe = true;
+    }
+
+    S_StopAllSounds();
+    clc.state = CA_CONNECTED;
+
+    // read demo messages until connected
+    while (clc.state >= CA_CONNECTED && clc.state < CA_PRIMED)
+    {
+        CL_ReadDemoMessage();
+    }
+    clc.firstDemoFrameSkipped = false;
+}
+
+/*
+====================
+CL_DemoSeek_f
+
+demo_seek [+|-]<seconds|minutes:seconds>
+====================
+*/
+static void CL_DemoSeek_f(void)
+{
+    const char *arg;
+    const char *colon;
+    int msec, target;
+    int offset;
+
+    if (!clc.demoplaying || clc.state != CA_ACTIVE)
+    {
+        Com_Printf("Not playing a demo.\n");
+        return;
+    }
+
+    if (Cmd_Argc() != 2)
+    {
+        Com_Printf("demo_seek [+|-]<seconds|minutes:seconds>\n");
+        Com_Printf("at %d seconds\n", (cl.serverTime - clc.demoStartTime) / 1000);
+        return;
+    }
+
+    arg = Cmd_Argv(1);
+    colon = strchr(arg, ':');
+    msec = (int)(atof(colon ? colon + 1 : arg) * 1000.0f);
+    if (colon)
+    {
+        msec += abs(atoi(arg + (*arg == '+' || *arg == '-'))) * 60000;
+    }
+
+    if (*arg == '+')
+    {
+        target = cl.serverTime + msec;
+    }
+    else if (*arg == '-')
+    {
+        target = cl.serverTime - abs(msec);
+    }
+    else
+    {
+        target = clc.demoStartTime + msec;
+    }
+
+    if (target < clc.demoStartTime)
+    {
+        target = clc.demoStartTime;
+    }
+
+    // going forwards without passing a keyframe is cheapest by replaying
+    offset = -1;
+    if (clc.demoIndexed)
+    {
+        int keyTime = INT_MIN;
+
+        offset = DEMO_HEADER_SIZE;
+        for (int i = 0; i < demoReader.numKeyframes; i++)
+        {
+            if (demoReader.keyframes[i].serverTime > target)
+            {
+                break;
+            }
+            keyTime = demoReader.keyframes[i].serverTime;
+            offset = demoReader.keyframes[i].offset;
+        }
+
+        if (target >= cl.serverTime && keyTime <= cl.serverTime)
+        {
+            offset = -1;
+        }
+    }
+    else if (target < cl.serverTime)
+    {
+        offset = 0;
+    }
+
+    clc.demoSeekTime = target;
+    if (offset >= 0)
+    {
+        CL_DemoRestartAt(offset);
+    }
+}
+
+/*
+====================
+CL_DemoFastForward
+
+Called every frame before the cgame time is set
+====================
+*/
+void CL_DemoFastForward(void)
+{
+    int start;
+
+    if (!clc.demoplaying || clc.state != CA_ACTIVE)
+    {
+        return;
+    }
+
+    if (!clc.demoStartTime)
+    {
+        clc.demoStartTime = cl.snap.serverTime;
+    }
+
+    if (!clc.demoSeekTime)
+    {
+        return;
+    }
+
+    start = Sys_Milliseconds();
+    clc.demoFastForward = true;
+    while (cl.serverTime < clc.demoSeekTime)
+    {
+        int oldTime = cl.serverTime;
+
+        cl.serverTimeDelta += MIN(clc.demoSeekTime - cl.serverTime, DEMO_SEEK_STEP);
+        CL_SetCGameTime();
+        if (clc.state != CA_ACTIVE)
+        {
+            // end of the demo
+            clc.demoFastForward = false;
+            return;
+        }
+
+        CL_CGameRendering(STEREO_CENTER);
+
+        if (cl.serverTime == oldTime || Sys_Milliseconds() - start >= DEMO_SEEK_FRAME_MSEC)
+        {
+            break;
+        }
+    }
+    clc.demoFastForward = false;
+
+    if (cl.serverTime >= clc.demoSeekTime || cl_freezeDemo->integer)
+    {
+        clc.demoSeekTime = 0;
+    }
+}
+
+/*
+====================
+CL_DemoInit
+====================
+*/
+void CL_DemoInit(void)
+{
+    cl_demoIndexed = Cvar_Get("cl_demoIndexed", "0", CVAR_ARCHIVE);
+    cl_demoKeyframeInterval = Cvar_Get("cl_demoKeyframeInterval", "10", CVAR_ARCHIVE);
+    cl_demoCompression = Cvar_Get("cl_demoCompression", "0", CVAR_ARCHIVE);
+
+    Cmd_AddCommand("demo_seek", CL_DemoSeek_f);
+}
+
+/*
+====================
+CL_DemoShutdown
+====================
+*/
+void CL_DemoShutdown(void)
+{
+    Cmd_RemoveCommand("demo_seek");
+}
+
+/*
+====================
+CL_DemoRecordIndexed
+
+Whether a new recording should use the indexed container
+====================
+*/
+bool CL_DemoRecordIndexed(void)
+{
+    return cl_demoIndexed->integer && clc.netchan.alternateProtocol == 0;
+}
@@ -0,0 +1,19 @@
+#ifndef CL_DEMO_H
+#define CL_DEMO_H
+
+void CL_DemoInit(void);
+void CL_DemoShutdown(void);
+
+void CL_IndexedDemoBegin(void);
+bool CL_IndexedDemoWrite(int sequence, const byte *data, int len);
+void CL_IndexedDemoSnapshot(void);
+void CL_IndexedDemoEnd(void);
+
+bool CL_IndexedDemoOpen(void);
+bool CL_IndexedDemoRead(msg_t *buf);
+bool CL_DemoRecordIndexed(void);
+
+// runs cgame frames without drawing until a demo_seek target is reached
+void CL_DemoFastForward(void);
+
+#endif
@@ -656,6 +656,13 @@ void CL_WriteDemoMessage(msg_t *msg, int headerBytes)
 {
     int len, swlen;
 
+    if (clc.demoIndexed)
+    {
+        CL_IndexedDemoWrite(clc.serverMessageSequence, msg->data + headerBytes, msg->cursize - headerBytes);
+        CL_IndexedDemoSnapshot();
+        return;
+    }
+
     // write the packet sequence
     len = clc.serverMessageSequence;
     swlen = LittleLong(len);
@@ -685,9 +692,16 @@ void CL_StopRecord_f(void)
     }
 
     // finish up
-    len = -1;
-    FS_Write(&len, 4, clc.demofile);
-    FS_Write(&len, 4, clc.demofile);
+    if (clc.demoIndexed)
+    {
+        CL_IndexedDemoEnd();
+    }
+    else
+    {
+        len = -1;
+        FS_Write(&len, 4, clc.demofile);
+        FS_Write(&len, 4, clc.demofile);
+    }
     FS_FCloseFile(clc.demofile);
     clc.demofile = 0;
     clc.demorecording = false;
@@ -717,6 +731,151 @@ static void CL_DemoFilename(int number, char *fileName, int fileNameSize)
     Com_sprintf(fileName, fileNameSize, "demo%i%i%i%i", a, b, c, d);
 }
 
+/*
+====================
+CL_WriteDemoGamestateMessage
+====================
+*/
+static void CL_WriteDemoGamestateMessage(msg_t *buf, int serverCommandSequence)
+{
+    int i;
+    entityState_t *ent;
+    entityState_t nullstate;
+
+    // NOTE, MRE: all server->client messages now acknowledge
+    MSG_WriteLong(buf, clc.reliableSequence);
+
+    MSG_WriteByte(buf, svc_gamestate);
+    MSG_WriteLong(buf, serverCommandSequence);
+
+    // configstrings
+    for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        if (!cl.gameState.stringOffsets[i])
+        {
+            continue;
+        }
+        const char *s = cl.gameState.stringData + cl.gameState.stringOffsets[i];
+        MSG_WriteByte(buf, svc_configstring);
+        MSG_WriteShort(buf, i);
+        MSG_WriteBigString(buf, s);
+    }
+
+    // baselines
+    ::memset(&nullstate, 0, sizeof(nullstate));
+    for (i = 0; i < MAX_GENTITIES; i++)
+    {
+        ent = &cl.entityBaselines[i];
+        if (!ent->number)
+        {
+            continue;
+        }
+        MSG_WriteByte(buf, svc_baseline);
+        MSG_WriteDeltaEntity(clc.netchan.alternateProtocol, buf, &nullstate, ent, true);
+    }
+
+    MSG_WriteByte(buf, svc_EOF);
+
+    // finished writing the gamestate stuff
+
+    // write the client num
+    MSG_WriteLong(buf, clc.clientNum);
+    // write the checksum feed
+    MSG_WriteLong(buf, clc.checksumFeed);
+
+    // finished writing the client packet
+    MSG_WriteByte(buf, svc_EOF);
+}
+
+/*
+====================
+CL_WriteDemoGamestate
+
+Writes the messages that start a demo at the current state.  cl.gameState
+only reflects the commands the cgame has executed, so the gamestate is
+marked with lastExecutedServerCommand and the commands received after it
+are repeated.  Returns the number of messages written, or 0 if one of
+them couldn't be written.
+====================
+*/
+int CL_WriteDemoGamestate(bool (*write)(int sequence, const byte *data, int len))
+{
+    byte bufData[MAX_MSGLEN];
+    msg_t buf;
+    int sequence;
+    int count;
+
+    sequence = clc.lastExecutedServerCommand;
+    if (sequence < clc.serverCommandSequence - MAX_RELIABLE_COMMANDS)
+    {
+        sequence = clc.serverCommandSequence - MAX_RELIABLE_COMMANDS;
+    }
+
+    MSG_Init(&buf, bufData, sizeof(bufData));
+    MSG_Bitstream(&buf);
+    CL_WriteDemoGamestateMessage(&buf, sequence);
+    if (buf.overflowed || !write(clc.serverMessageSequence - 1, buf.data, buf.cursize))
+    {
+        return 0;
+    }
+    count = 1;
+
+    // commands still waiting for the cgame
+    MSG_Init(&buf, bufData, sizeof(bufData));
+    MSG_Bitstream(&buf);
+    MSG_WriteLong(&buf, clc.reliableSequence);
+    for (int i = sequence + 1; i <= clc.serverCommandSequence; i++)
+    {
+        if (buf.cursize > MAX_MSGLEN - MAX_STRING_CHARS - 16)
+        {
+            MSG_WriteByte(&buf, svc_EOF);
+            if (!write(clc.serverMessageSequence - 1, buf.data, buf.cursize))
+            {
+                return 0;
+            }
+            count++;
+
+            MSG_Init(&buf, bufData, sizeof(bufData));
+            MSG_Bitstream(&buf);
+            MSG_WriteLong(&buf, clc.reliableSequence);
+        }
+        MSG_WriteByte(&buf, svc_serverCommand);
+        MSG_WriteLong(&buf, i);
+        MSG_WriteString(&buf, clc.serverCommands[i & (MAX_RELIABLE_COMMANDS - 1)]);
+    }
+
+    if (sequence < clc.serverCommandSequence)
+    {
+        MSG_WriteByte(&buf, svc_EOF);
+        if (!write(clc.serverMessageSequence - 1, buf.data, buf.cursize))
+        {
+            return 0;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/*
+====================
+CL_WriteDemoFileMessage
+
+Writes a message to a classic demo, prefixed by its sequence and length
+====================
+*/
+static bool CL_WriteDemoFileMessage(int sequence, const byte *data, int len)
+{
+    int swlen;
+
+    swlen = LittleLong(sequence);
+    FS_Write(&swlen, 4, clc.demofile);
+    swlen = LittleLong(len);
+    FS_Write(&swlen, 4, clc.demofile);
+    FS_Write(data, len, clc.demofile);
+    return true;
+}
+
 /*
 ====================
 CL_Record_f
@@ -731,12 +890,7 @@ static char demoName[MAX_QPATH];  // compiler bug workaround
 static void CL_Record_f(void)
 {
     char name[MAX_OSPATH];
-    byte bufData[MAX_MSGLEN];
-    msg_t buf;
-    int i;
-    int len;
-    entityState_t *ent;
-    entityState_t nullstate;
+    const char *ext;
 
     if (Cmd_Argc() > 2)
     {
@@ -765,11 +919,14 @@ static void CL_Record_f(void)
         Com_Printf(S_COLOR_YELLOW "WARNING: You should set 'g_synchronousClients 1' for smoother demo recording\n");
     }
 
+    clc.demoIndexed = CL_DemoRecordIndexed();
+    ext = clc.demoIndexed ? DEMOEXT_INDEXED : DEMOEXT;
+
     if (Cmd_Argc() == 2)
     {
         const char *s = Cmd_Argv(1);
         Q_strncpyz(demoName, s, sizeof(demoName));
-        Com_sprintf(name, sizeof(name), "demos/%s.%s%d", demoName, DEMOEXT, PROTOCOL_VERSION);
+        Com_sprintf(name, sizeof(name), "demos/%s.%s%d", demoName, ext, PROTOCOL_VERSION);
     }
     else
     {
@@ -779,7 +936,7 @@ static void CL_Record_f(void)
         for (number = 0; number <= 9999; number++)
         {
             CL_DemoFilename(number, demoName, sizeof(demoName));
-            Com_sprintf(name, sizeof(name), "demos/%s.%s%d", demoName, DEMOEXT, PROTOCOL_VERSION);
+            Com_sprintf(name, sizeof(name), "demos/%s.%s%d", demoName, ext, PROTOCOL_VERSION);
 
             if (!FS_FileExists(name)) break;  // file doesn't exist
         }
@@ -809,61 +966,13 @@ static void CL_Record_f(void)
     // don't start saving messages until a non-delta compressed message is received
     clc.demowaiting = true;
 
-    // write out the gamestate message
-    MSG_Init(&buf, bufData, sizeof(bufData));
-    MSG_Bitstream(&buf);
-
-    // NOTE, MRE: all server->client messages now acknowledge
-    MSG_WriteLong(&buf, clc.reliableSequence);
-
-    MSG_WriteByte(&buf, svc_gamestate);
-    MSG_WriteLong(&buf, clc.serverCommandSequence);
-
-    // configstrings
-    for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+    if (clc.demoIndexed)
     {
-        if (!cl.gameState.stringOffsets[i])
-        {
-            continue;
-        }
-        const char *s = cl.gameState.stringData + cl.gameState.stringOffsets[i];
-        MSG_WriteByte(&buf, svc_configstring);
-        MSG_WriteShort(&buf, i);
-        MSG_WriteBigString(&buf, s);
+        CL_IndexedDemoBegin();
     }
 
-    // baselines
-    ::memset(&nullstate, 0, sizeof(nullstate));
-    for (i = 0; i < MAX_GENTITIES; i++)
-    {
-        ent = &cl.entityBaselines[i];
-        if (!ent->number)
-        {
-            continue;
-        }
-        MSG_WriteByte(&buf, svc_baseline);
-        MSG_WriteDeltaEntity(clc.netchan.alternateProtocol, &buf, &nullstate, ent, true);
-    }
-
-    MSG_WriteByte(&buf, svc_EOF);
-
-    // finished writing the gamestate stuff
-
-    // write the client num
-    MSG_WriteLong(&buf, clc.clientNum);
-    // write the checksum feed
-    MSG_WriteLong(&buf, clc.checksumFeed);
-
-    // finished writing the client packet
-    MSG_WriteByte(&buf, svc_EOF);
-
-    // write it to the demo file
-    len = LittleLong(clc.serverMessageSequence - 1);
-    FS_Write(&len, 4, clc.demofile);
-
-    len = LittleLong(buf.cursize);
-    FS_Write(&len, 4, clc.demofile);
-    FS_Write(buf.data, buf.cursize, clc.demofile);
+    // write out the gamestate message
+    CL_WriteDemoGamestate(clc.demoIndexed ? CL_IndexedDemoWrite : CL_WriteDemoFileMessage);
 
     // the rest of the demo file will be copied from net messages
 }
@@ -982,6 +1091,20 @@ void CL_ReadDemoMessage(void)
         return;
     }
 
+    if (clc.demoIndexed)
+    {
+        MSG_Init(&buf, bufData, sizeof(bufData));
+        if (!CL_IndexedDemoRead(&buf))
+        {
+            CL_DemoCompleted();
+            return;
+        }
+
+        clc.lastPacketTime = cls.realtime;
+        CL_ParseServerMessage(&buf);
+        return;
+    }
+
     // get the sequence number
     r = FS_Read(&s, 4, clc.demofile);
     if (r != 4)
@@ -1034,6 +1157,15 @@ static int CL_WalkDemoExt(const char *arg, char *name, int *demofile)
     int i;
     *demofile = 0;
 
+    Com_sprintf(name, MAX_OSPATH, "demos/%s.%s%d", arg, DEMOEXT_INDEXED, PROTOCOL_VERSION);
+    FS_FOpenFileRead(name, demofile, true);
+
+    if (*demofile)
+    {
+        Com_Printf("Demo file: %s\n", name);
+        return PROTOCOL_VERSION;
+    }
+
     Com_sprintf(name, MAX_OSPATH, "demos/%s.%s%d", arg, DEMOEXT, PROTOCOL_VERSION);
     FS_FOpenFileRead(name, demofile, true);
 
@@ -1073,10 +1205,8 @@ static void CL_CompleteDemoName(char *args, int argNum)
 {
     if (argNum == 2)
     {
-        char demoExt[16];
-
-        Com_sprintf(demoExt, sizeof(demoExt), ".%s%d", DEMOEXT, PROTOCOL_VERSION);
-        Field_CompleteFilename("demos", demoExt, true, true);
+        // keep the extension, classic and indexed demos can share a name
+        Field_CompleteFilename("demos", "", false, true);
     }
 }
 
@@ -1113,7 +1243,14 @@ void CL_PlayDemo_f(void)
     // check for an extension .DEMOEXT_?? (?? is protocol)
     ext_test = strrchr(arg, '.');
 
-    if (ext_test && !Q_stricmpn(ext_test + 1, DEMOEXT, ARRAY_LEN(DEMOEXT) - 1))
+    if (ext_test && !Q_stricmpn(ext_test + 1, DEMOEXT_INDEXED, ARRAY_LEN(DEMOEXT_INDEXED) - 1))
+    {
+        protocol = atoi(ext_test + ARRAY_LEN(DEMOEXT_INDEXED));
+
+        Com_sprintf(name, sizeof(name), "demos/%s", arg);
+        FS_FOpenFileRead(name, &clc.demofile, true);
+    }
+    else if (ext_test && !Q_stricmpn(ext_test + 1, DEMOEXT, ARRAY_LEN(DEMOEXT) - 1))
     {
         protocol = atoi(ext_test + ARRAY_LEN(DEMOEXT));
 
@@ -1151,6 +1288,15 @@ void CL_PlayDemo_f(void)
     }
     Q_strncpyz(clc.demoName, arg, sizeof(clc.demoName));
 
+    clc.demoIndexed = Q_stristr(name, "." DEMOEXT_INDEXED) != NULL;
+    if (clc.demoIndexed && !CL_IndexedDemoOpen())
+    {
+        FS_FCloseFile(clc.demofile);
+        clc.demofile = 0;
+        Com_Error(ERR_DROP, "%s is not a valid indexed demo", name);
+        return;
+    }
+
     clc.state = CA_CONNECTED;
     clc.demoplaying = true;
     Q_strncpyz(clc.servername, arg, sizeof(clc.servername));
@@ -3032,6 +3178,9 @@ void CL_Frame(int msec)
     // resend a connection request if necessary
     CL_CheckForResend();
 
+    // skip ahead to a demo_seek target
+    CL_DemoFastForward();
+
     // decide on the serverTime to render
     CL_SetCGameTime();
 
@@ -4950,6 +5099,9 @@ void CL_Init(void)
     cl_voipProtocol = Cvar_Get("cl_voipProtocol", cl_voip->integer ? "opus" : "", CVAR_USERINFO | CVAR_ROM);
 #endif
 
+    // a cgame that applies csb configstring batches sets this to 1
+    Cvar_Get("cl_csBatch", "0", CVAR_USERINFO | CVAR_ROM);
+
     // cgame might not be initialized before menu is used
     Cvar_Get("cg_viewsize", "100", CVAR_ARCHIVE);
     // Make sure cg_stereoSeparation is zero as that variable is deprecated and should not be used anymore.
@@ -4987,6 +5139,8 @@ void CL_Init(void)
     Cmd_AddCommand("installUpdate", CL_InstallUpdate_f);
     Cmd_AddCommand("checkForUpdate", CL_CheckForUpdate_f);
 
+    CL_DemoInit();
+
     CL_InitRef();
 
     SCR_Init();
@@ -5044,6 +5198,7 @@ void CL_Shutdown(const char *finalmsg, bool disconnect, bool quit)
     Cmd_RemoveCommand("demo");
     Cmd_RemoveCommand("cinematic");
     Cmd_RemoveCommand("stoprecord");
+    CL_DemoShutdown();
     Cmd_RemoveCommand("connect");
     Cmd_RemoveCommand("reconnect");
     Cmd_RemoveCommand("localservers");
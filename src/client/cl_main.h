@@ -8,6 +8,7 @@ void CL_InitDownloads(void);
 void CL_NextDemo(void);
 void CL_NextDownload(void);
 void CL_ReadDemoMessage(void);
+int CL_WriteDemoGamestate(bool (*write)(int sequence, const byte *data, int len));
 void CL_StartHunkUsers(bool rendererOnly);
 void CL_StopRecord_f(void);
 
@@ -481,6 +481,14 @@ void CL_ParseGamestate( msg_t *msg ) {
 
 	// a gamestate always marks a server command sequence
 	clc.serverCommandSequence = MSG_ReadLong( msg );
+	clc.gamestateCommandSequence = clc.serverCommandSequence;
+
+	// a demo gamestate can come from a seek, so the commands from before it
+	// mustn't be executed or skipped by the new cgame
+	if ( clc.demoplaying ) {
+		clc.lastExecutedServerCommand = clc.serverCommandSequence;
+		::memset( clc.serverCommands, 0, sizeof( clc.serverCommands ) );
+	}
 
 	// parse all the configstrings and baselines
 	cl.gameState.dataCount = 1;	// leave a 0 at the beginning for uninitialized configstrings
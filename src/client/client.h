@@ -48,6 +48,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "cl_cgame.h"
 #include "cl_curl.h"
+#include "cl_demo.h"
 #include "cl_keys.h"
 #include "cl_main.h"
 #include "cl_screen.h"
@@ -270,6 +271,7 @@ struct clientConnection_t {
     // reliable messages received from server
     int serverCommandSequence;
     int lastExecutedServerCommand;  // last server command grabbed or executed with CL_GetServerCommand
+    int gamestateCommandSequence;  // serverCommandSequence of the last gamestate
     char serverCommands[MAX_RELIABLE_COMMANDS][MAX_STRING_CHARS];
 
     // file transfer from server
@@ -305,6 +307,10 @@ struct clientConnection_t {
     bool demowaiting;  // don't record until a non-delta message is received
     bool firstDemoFrameSkipped;
     fileHandle_t demofile;
+    bool demoIndexed;  // demofile is an indexed (.dmi_) demo
+    bool demoFastForward;  // cgame frames aren't drawn while seeking
+    int demoSeekTime;  // serverTime demo_seek is heading for
+    int demoStartTime;  // serverTime of the first played snapshot
 
     int timeDemoFrames;  // counter of rendered frames
     int timeDemoStart;  // cls.realtime before first frame
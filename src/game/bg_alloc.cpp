@@ -33,6 +33,18 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define FREEMEMCOOKIE ((int)0xDEADBE3F)  // Any unlikely to be used value
 #define ROUNDBITS 31  // Round to 32 bytes
 
+// Small allocations are served from fixed size chunks carved out of
+// pages of the general arena, so the long lived lists that get rebuilt
+// on every map change (namelogs, admin data, map rotations, voices) stop
+// breaking the arena up into unusable slivers.
+#define POOL_PAGESIZE (8 * 1024)
+#define POOL_ARENA -1  // memHeader_t.pool of blocks that come from the arena
+
+struct memHeader_t {
+    int size;  // arena block: size including header, pool chunk: offset to its page
+    int pool;  // POOL_ARENA or the index of the chunk size class
+};
+
 struct freeMemNode_t {
     // Size of ROUNDBITS
     int cookie, size;  // Size includes node (obviously)
@@ -40,21 +52,56 @@ struct freeMemNode_t {
     freeMemNode_t *next;
 };
 
-static char memoryPool[POOLSIZE];
+struct poolChunk_t {
+    memHeader_t header;
+    poolChunk_t *next;  // only valid while the chunk is free
+};
+
+struct poolPage_t {
+    memHeader_t header;  // arena block header
+    poolPage_t *prev;    // pages that still have free chunks
+    poolPage_t *next;
+    poolChunk_t *freeList;
+    int pool;
+    int used;
+    int total;
+};
+
+#define POOL_FIRSTCHUNK PAD((int)sizeof(poolPage_t), 16)
+
+struct memPool_t {
+    int chunkSize;  // including header
+    poolPage_t *partial;
+    int pages;
+    int used;
+    int highwater;
+};
+
+// chunk sizes include the header, chunks are 16 byte aligned so the data
+// after the 8 byte header is only 8 byte aligned
+static memPool_t memPools[] = {
+    {32}, {48}, {64}, {96}, {128}, {192}, {256}, {384}, {512},
+};
+static const int numMemPools = ARRAY_LEN(memPools);
+
+alignas(32) static char memoryPool[POOLSIZE];
 static freeMemNode_t *freeHead;
 static int freeMem;
 
-void *BG_Alloc(int size)
-{
-    // Find a free block and allocate.
-    // Does two passes, attempts to fill same-sized free slot first.
+/*
+================
+BG_ArenaAlloc
 
+Best fit from the address ordered free list, returns a zero filled
+block including its header or NULL
+================
+*/
+static memHeader_t *BG_ArenaAlloc(int allocsize)
+{
     freeMemNode_t *fmn, *prev, *next, *smallest;
-    int allocsize, smallestsize;
-    char *endptr;
-    int *ptr;
+    int smallestsize;
+    char *ptr;
 
-    allocsize = (size + (int)sizeof(int) + ROUNDBITS) & ~ROUNDBITS;  // Round to 32-byte boundary
     ptr = NULL;
 
     smallest = NULL;
@@ -79,7 +126,7 @@ void *BG_Alloc(int size)
                     next->prev = prev;  // Point next node to previous
                 if (fmn == freeHead)
                     freeHead = next;  // Set head pointer to next
-                ptr = (int *)fmn;
+                ptr = (char *)fmn;
                 break;  // Stop the loop, this is fine
             }
             else
@@ -96,61 +143,262 @@ void *BG_Alloc(int size)
 
     if (!ptr && smallest)
     {
-        // We found a slot big enough
+        // We found a slot big enough, take the tail so the node stays put
         smallest->size -= allocsize;
-        endptr = (char *)smallest + smallest->size;
-        ptr = (int *)endptr;
+        ptr = (char *)smallest + smallest->size;
     }
 
-    if (ptr)
+    if (!ptr)
+        return NULL;
+
+    freeMem -= allocsize;
+    memset(ptr, 0, allocsize);
+    ((memHeader_t *)ptr)->size = allocsize;
+    ((memHeader_t *)ptr)->pool = POOL_ARENA;
+    return (memHeader_t *)ptr;
+}
+
+/*
+================
+BG_ArenaFree
+
+Insert the block in address order and merge it with its neighbours,
+so the free list never holds two adjacent nodes
+================
+*/
+static void BG_ArenaFree(memHeader_t *block)
+{
+    freeMemNode_t *fmn, *prev, *next;
+    int size;
+
+    size = block->size;
+    if (size <= 0 || size & ROUNDBITS || (char *)block + size > memoryPool + POOLSIZE)
+        Com_Error(ERR_DROP, "BG_Free: Memory corruption detected!");
+
+    freeMem += size;
+
+    prev = NULL;
+    for (next = freeHead; next && next < (freeMemNode_t *)block; next = next->next)
+        prev = next;
+
+    if (prev && (char *)prev + prev->size == (char *)block)
+    {
+        // Released block can be merged onto the previous node
+        prev->size += size;
+        fmn = prev;
+    }
+    else
     {
-        freeMem -= allocsize;
-        memset(ptr, 0, allocsize);
-        *ptr++ = allocsize;  // Store a copy of size for deallocation
-        return ((void *)ptr);
+        fmn = (freeMemNode_t *)block;
+        fmn->cookie = FREEMEMCOOKIE;
+        fmn->size = size;
+        fmn->prev = prev;
+        fmn->next = next;
+        if (prev)
+            prev->next = fmn;
+        else
+            freeHead = fmn;
+        if (next)
+            next->prev = fmn;
     }
 
-    Com_Error(ERR_DROP, "BG_Alloc: failed on allocation of %i bytes", size);
-    return (NULL);
+    if (next && (char *)fmn + fmn->size == (char *)next)
+    {
+        // And the following node onto it
+        fmn->size += next->size;
+        fmn->next = next->next;
+        if (next->next)
+            next->next->prev = fmn;
+        memset(next, 0, sizeof(freeMemNode_t));
+    }
 }
 
-void BG_Free(void *ptr)
+/*
+================
+BG_PoolForSize
+================
+*/
+static int BG_PoolForSize(int allocsize)
 {
-    // Release allocated memory, add it to the free list.
+    int i;
 
-    freeMemNode_t *fmn;
-    char *freeend;
-    int *freeptr;
+    for (i = 0; i < numMemPools; i++)
+    {
+        if (allocsize <= memPools[i].chunkSize)
+            return i;
+    }
 
-    freeptr = (int *)ptr;
-    freeptr--;
+    return POOL_ARENA;
+}
+
+/*
+================
+BG_PoolNewPage
+================
+*/
+static poolPage_t *BG_PoolNewPage(int pool)
+{
+    memPool_t *mp = &memPools[pool];
+    poolPage_t *page;
+    poolChunk_t *chunk;
+    int offset;
 
-    freeMem += *freeptr;
+    page = (poolPage_t *)BG_ArenaAlloc(POOL_PAGESIZE);
+    if (!page)
+        return NULL;
 
-    for (fmn = freeHead; fmn; fmn = fmn->next)
+    page->pool = pool;
+    for (offset = POOL_PAGESIZE - mp->chunkSize; offset >= POOL_FIRSTCHUNK; offset -= mp->chunkSize)
     {
-        freeend = ((char *)fmn) + fmn->size;
-        if (freeend == (char *)freeptr)
-        {
-            // Released block can be merged to an existing node
+        chunk = (poolChunk_t *)((char *)page + offset);
+        chunk->header.size = offset;
+        chunk->header.pool = pool;
+        chunk->next = page->freeList;
+        page->freeList = chunk;
+        page->total++;
+    }
 
-            fmn->size += *freeptr;  // Add size of node.
-            return;
-        }
+    page->next = mp->partial;
+    if (mp->partial)
+        mp->partial->prev = page;
+    mp->partial = page;
+    mp->pages++;
+
+    return page;
+}
+
+/*
+================
+BG_PoolUnlinkPage
+================
+*/
+static void BG_PoolUnlinkPage(memPool_t *mp, poolPage_t *page)
+{
+    if (page->prev)
+        page->prev->next = page->next;
+    else
+        mp->partial = page->next;
+    if (page->next)
+        page->next->prev = page->prev;
+    page->prev = page->next = NULL;
+}
+
+/*
+================
+BG_PoolAlloc
+================
+*/
+static void *BG_PoolAlloc(int pool)
+{
+    memPool_t *mp = &memPools[pool];
+    poolPage_t *page;
+    poolChunk_t *chunk;
+
+    page = mp->partial;
+    if (!page && !(page = BG_PoolNewPage(pool)))
+        return NULL;
+
+    chunk = page->freeList;
+    page->freeList = chunk->next;
+    if (!page->freeList)
+        BG_PoolUnlinkPage(mp, page);  // full
+
+    page->used++;
+    mp->used++;
+    if (mp->used > mp->highwater)
+        mp->highwater = mp->used;
+
+    memset(chunk, 0, mp->chunkSize);
+    chunk->header.size = (char *)chunk - (char *)page;
+    chunk->header.pool = pool;
+    return &chunk->header + 1;
+}
+
+/*
+================
+BG_PoolFree
+================
+*/
+static void BG_PoolFree(memHeader_t *header)
+{
+    memPool_t *mp = &memPools[header->pool];
+    poolChunk_t *chunk = (poolChunk_t *)header;
+    poolPage_t *page = (poolPage_t *)((char *)header - header->size);
+
+    if (header->size < POOL_FIRSTCHUNK || header->size >= POOL_PAGESIZE ||
+        page->pool != header->pool || page->used <= 0)
+        Com_Error(ERR_DROP, "BG_Free: Memory corruption detected!");
+
+    if (!page->freeList)
+    {
+        // was full, make it available again
+        page->next = mp->partial;
+        if (mp->partial)
+            mp->partial->prev = page;
+        mp->partial = page;
+    }
+
+    chunk->next = page->freeList;
+    page->freeList = chunk;
+    page->used--;
+    mp->used--;
+
+    // hand empty pages back to the arena, but keep the last one around
+    // so alternating alloc/free doesn't keep carving new pages
+    if (!page->used && (page->prev || page->next))
+    {
+        BG_PoolUnlinkPage(mp, page);
+        mp->pages--;
+        BG_ArenaFree(&page->header);
     }
-    // No merging, add to head of list
+}
+
+void *BG_Alloc(int size)
+{
+    memHeader_t *header;
+    void *ptr;
+    int allocsize;
+    int pool;
+
+    allocsize = size + (int)sizeof(memHeader_t);
+    pool = BG_PoolForSize(allocsize);
+
+    if (pool != POOL_ARENA)
+    {
+        ptr = BG_PoolAlloc(pool);
+        if (ptr)
+            return ptr;
+    }
+    else
+    {
+        allocsize = (allocsize + ROUNDBITS) & ~ROUNDBITS;  // Round to 32-byte boundary
+        header = BG_ArenaAlloc(allocsize);
+        if (header)
+            return header + 1;
+    }
+
+    Com_Error(ERR_DROP, "BG_Alloc: failed on allocation of %i bytes", size);
+    return (NULL);
+}
 
-    fmn = (freeMemNode_t *)freeptr;
-    fmn->size = *freeptr;  // Set this first to avoid corrupting *freeptr
-    fmn->cookie = FREEMEMCOOKIE;
-    fmn->prev = NULL;
-    fmn->next = freeHead;
-    freeHead->prev = fmn;
-    freeHead = fmn;
+void BG_Free(void *ptr)
+{
+    memHeader_t *header;
+
+    header = (memHeader_t *)ptr - 1;
+
+    if (header->pool == POOL_ARENA)
+        BG_ArenaFree(header);
+    else if (header->pool >= 0 && header->pool < numMemPools)
+        BG_PoolFree(header);
+    else
+        Com_Error(ERR_DROP, "BG_Free: Memory corruption detected!");
 }
 
 void BG_InitMemory(void)
 {
+    int i;
+
     // Set up the initial node
 
     freeHead = (freeMemNode_t *)memoryPool;
@@ -159,47 +407,27 @@ void BG_InitMemory(void)
     freeHead->next = NULL;
     freeHead->prev = NULL;
     freeMem = sizeof(memoryPool);
+
+    for (i = 0; i < numMemPools; i++)
+    {
+        memPools[i].partial = NULL;
+        memPools[i].pages = 0;
+        memPools[i].used = 0;
+        memPools[i].highwater = 0;
+    }
 }
 
 void BG_DefragmentMemory(void)
 {
-    // If there's a frenzy of deallocation and we want to
-    // allocate something big, this is useful. Otherwise...
-    // not much use.
+    // Free blocks are coalesced as they are released, so all that is
+    // left to do is make sure the free list is still sane.
 
-    freeMemNode_t *startfmn, *endfmn, *fmn;
+    freeMemNode_t *fmn;
 
-    for (startfmn = freeHead; startfmn;)
+    for (fmn = freeHead; fmn; fmn = fmn->next)
     {
-        endfmn = (freeMemNode_t *)(((char *)startfmn) + startfmn->size);
-        for (fmn = freeHead; fmn;)
-        {
-            if (fmn->cookie != FREEMEMCOOKIE)
-                Com_Error(ERR_DROP, "BG_DefragmentMemory: Memory corruption detected!");
-
-            if (fmn == endfmn)
-            {
-                // We can add fmn onto startfmn.
-
-                if (fmn->prev)
-                    fmn->prev->next = fmn->next;
-                if (fmn->next)
-                {
-                    if (!(fmn->next->prev = fmn->prev))
-                        freeHead = fmn->next;  // We're removing the head node
-                }
-                startfmn->size += fmn->size;
-                memset(fmn, 0, sizeof(freeMemNode_t));  // A redundant call, really.
-
-                startfmn = freeHead;
-                endfmn = fmn = NULL;  // Break out of current loop
-            }
-            else
-                fmn = fmn->next;
-        }
-
-        if (endfmn)
-            startfmn = startfmn->next;  // endfmn acts as a 'restart' flag here
+        if (fmn->cookie != FREEMEMCOOKIE || (fmn->next && fmn->next <= fmn))
+            Com_Error(ERR_DROP, "BG_DefragmentMemory: Memory corruption detected!");
     }
 }
 
@@ -209,8 +437,11 @@ void BG_MemoryInfo(void)
 
     freeMemNode_t *fmn = (freeMemNode_t *)memoryPool;
     int size, chunks;
+    int freeBlocks, largestFree;
     freeMemNode_t *end = (freeMemNode_t *)(memoryPool + POOLSIZE);
+    memPool_t *mp;
     void *p;
+    int i;
 
     Com_Printf("%p-%p: %d out of %d bytes allocated\n", fmn, end, POOLSIZE - freeMem, POOLSIZE);
 
@@ -237,4 +468,23 @@ void BG_MemoryInfo(void)
         if (size)
             Com_Printf("  %p: %d bytes allocated (%d chunks)\n", p, size, chunks);
     }
+
+    freeBlocks = largestFree = 0;
+    for (fmn = freeHead; fmn; fmn = fmn->next)
+    {
+        freeBlocks++;
+        if (fmn->size > largestFree)
+            largestFree = fmn->size;
+    }
+    Com_Printf("%d bytes free in %d blocks, largest %d, %d%% fragmented\n", freeMem, freeBlocks, largestFree,
+        freeMem ? 100 - (int)(100LL * largestFree / freeMem) : 0);
+
+    Com_Printf("pool   pages   used  total  highwater  bytes\n");
+    for (i = 0; i < numMemPools; i++)
+    {
+        mp = &memPools[i];
+        chunks = (POOL_PAGESIZE - POOL_FIRSTCHUNK) / mp->chunkSize;
+        Com_Printf("%4d  %6d %6d %6d  %9d %6d\n", mp->chunkSize, mp->pages, mp->used, mp->pages * chunks,
+            mp->highwater, mp->pages * POOL_PAGESIZE);
+    }
 }
@@ -40,11 +40,28 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define FALLING_THRESHOLD -900.0f //what vertical speed to start falling sound at
 
 
+// class parameters used while moving, looked up
+// once per pmove instead of in every move function
+typedef struct
+{
+  int       abilities;
+  float     bobCycle;
+  float     acceleration;
+  float     airAcceleration;
+  float     friction;
+  float     stopSpeed;
+  float     jumpMagnitude;
+  int       viewheight;
+  int       crouchViewheight;
+} pmClass_t;
+
 // all of the locals will be zeroed before each
 // pmove, just to make damn sure we don't have
 // any differences when running on client or server
 typedef struct
 {
+  pmClass_t klass;
+
   vec3_t    forward, right, up;
   float     frametime;
 
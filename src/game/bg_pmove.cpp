@@ -254,8 +254,8 @@ static void PM_Friction(void)
             // if getting knocked back, no friction
             if (!(pm->ps->pm_flags & PMF_TIME_KNOCKBACK))
             {
-                float stopSpeed = BG_Class(pm->ps->stats[STAT_CLASS])->stopSpeed;
-                float friction = BG_Class(pm->ps->stats[STAT_CLASS])->friction;
+                float stopSpeed = pml.klass.stopSpeed;
+                float friction = pml.klass.friction;
 
                 control = speed < stopSpeed ? stopSpeed : speed;
                 drop += control * friction * pml.frametime;
@@ -601,7 +601,7 @@ static bool PM_CheckWallJump(void)
     float upFraction = 1.5f;
     trace_t trace;
 
-    if (!(BG_Class(pm->ps->stats[STAT_CLASS])->abilities & SCA_WALLJUMPER))
+    if (!(pml.klass.abilities & SCA_WALLJUMPER))
         return false;
 
     ProjectPointOnPlane(movedir, pml.forward, refNormal);
@@ -674,7 +674,7 @@ static bool PM_CheckWallJump(void)
     VectorMA(dir, upFraction, refNormal, dir);
     VectorNormalize(dir);
 
-    VectorMA(pm->ps->velocity, BG_Class(pm->ps->stats[STAT_CLASS])->jumpMagnitude, dir, pm->ps->velocity);
+    VectorMA(pm->ps->velocity, pml.klass.jumpMagnitude, dir, pm->ps->velocity);
 
     // for a long run of wall jumps the velocity can get pretty large, this caps it
     if (VectorLength(pm->ps->velocity) > LEVEL2_WALLJUMP_MAXSPEED)
@@ -719,7 +719,7 @@ static bool PM_CheckJump(void)
     if (pm->ps->groundEntityNum == ENTITYNUM_NONE)
         return false;
 
-    if (BG_Class(pm->ps->stats[STAT_CLASS])->jumpMagnitude == 0.0f)
+    if (pml.klass.jumpMagnitude == 0.0f)
         return false;
 
     // can't jump and pounce at the same time
@@ -754,7 +754,7 @@ static bool PM_CheckJump(void)
         return false;
 
     // don't allow walljump for a short while after jumping from the ground
-    if (BG_ClassHasAbility(pm->ps->stats[STAT_CLASS], SCA_WALLJUMPER))
+    if (pml.klass.abilities & SCA_WALLJUMPER)
     {
         pm->ps->pm_flags |= PMF_TIME_WALLJUMP;
         pm->ps->pm_time = 200;
@@ -776,7 +776,7 @@ static bool PM_CheckJump(void)
     if (pm->ps->velocity[2] < 0)
         pm->ps->velocity[2] = 0;
 
-    VectorMA(pm->ps->velocity, BG_Class(pm->ps->stats[STAT_CLASS])->jumpMagnitude, normal, pm->ps->velocity);
+    VectorMA(pm->ps->velocity, pml.klass.jumpMagnitude, normal, pm->ps->velocity);
 
     PM_AddEvent(EV_JUMP);
 
@@ -895,7 +895,7 @@ static bool PM_CheckDodge(void)
     forward[2] = 0.0f;
 
     // Dodge magnitude is based on the jump magnitude scaled by the modifiers
-    jump = BG_Class(pm->ps->stats[STAT_CLASS])->jumpMagnitude;
+    jump = pml.klass.jumpMagnitude;
     if (pm->cmd.rightmove && pm->cmd.forwardmove)
         jump *= (0.5f * M_SQRT2);
 
@@ -1167,7 +1167,7 @@ static void PM_AirMove(void)
     wishspeed *= scale;
 
     // not on ground, so little effect on velocity
-    PM_Accelerate(wishdir, wishspeed, BG_Class(pm->ps->stats[STAT_CLASS])->airAcceleration);
+    PM_Accelerate(wishdir, wishspeed, pml.klass.airAcceleration);
 
     // we may have a ground plane that is very steep, even
     // though we don't have a groundentity
@@ -1263,9 +1263,9 @@ static void PM_ClimbMove(void)
     // when a player gets hit, they temporarily lose
     // full control, which allows them to be moved a bit
     if ((pml.groundTrace.surfaceFlags & SURF_SLICK) || pm->ps->pm_flags & PMF_TIME_KNOCKBACK)
-        accelerate = BG_Class(pm->ps->stats[STAT_CLASS])->airAcceleration;
+        accelerate = pml.klass.airAcceleration;
     else
-        accelerate = BG_Class(pm->ps->stats[STAT_CLASS])->acceleration;
+        accelerate = pml.klass.acceleration;
 
     PM_Accelerate(wishdir, wishspeed, accelerate);
 
@@ -1379,9 +1379,9 @@ static void PM_WalkMove(void)
     // when a player gets hit, they temporarily lose
     // full control, which allows them to be moved a bit
     if ((pml.groundTrace.surfaceFlags & SURF_SLICK) || pm->ps->pm_flags & PMF_TIME_KNOCKBACK)
-        accelerate = BG_Class(pm->ps->stats[STAT_CLASS])->airAcceleration;
+        accelerate = pml.klass.airAcceleration;
     else
-        accelerate = BG_Class(pm->ps->stats[STAT_CLASS])->acceleration;
+        accelerate = pml.klass.acceleration;
 
     PM_Accelerate(wishdir, wishspeed, accelerate);
 
@@ -1469,7 +1469,7 @@ static void PM_CheckLadder(void)
     trace_t trace;
 
     // test if class can use ladders
-    if (!BG_ClassHasAbility(pm->ps->stats[STAT_CLASS], SCA_CANUSELADDERS))
+    if (!(pml.klass.abilities & SCA_CANUSELADDERS))
     {
         pml.ladder = false;
         return;
@@ -1793,7 +1793,7 @@ static void PM_GroundTraceMissed(void)
         }
     }
 
-    if (BG_ClassHasAbility(pm->ps->stats[STAT_CLASS], SCA_TAKESFALLDAMAGE))
+    if (pml.klass.abilities & SCA_TAKESFALLDAMAGE)
     {
         if (pm->ps->velocity[2] < FALLING_THRESHOLD && pml.previous_velocity[2] >= FALLING_THRESHOLD)
             PM_AddEvent(EV_FALLING);
@@ -2111,7 +2111,7 @@ static void PM_GroundTrace(void)
     vec3_t refNormal = {0.0f, 0.0f, 1.0f};
     trace_t trace;
 
-    if (BG_ClassHasAbility(pm->ps->stats[STAT_CLASS], SCA_WALLCLIMBER))
+    if (pml.klass.abilities & SCA_WALLCLIMBER)
     {
         if (pm->ps->persistant[PERS_STATE] & PS_WALLCLIMBINGTOGGLE)
         {
@@ -2276,7 +2276,7 @@ static void PM_GroundTrace(void)
         // communicate the fall velocity to the server
         pm->pmext->fallVelocity = pml.previous_velocity[2];
 
-        if (BG_ClassHasAbility(pm->ps->stats[STAT_CLASS], SCA_TAKESFALLDAMAGE))
+        if (pml.klass.abilities & SCA_TAKESFALLDAMAGE)
             PM_CrashLand();
     }
 
@@ -2340,8 +2340,8 @@ PM_SetViewheight
 */
 static void PM_SetViewheight(void)
 {
-    pm->ps->viewheight = (pm->ps->pm_flags & PMF_DUCKED) ? BG_ClassConfig(pm->ps->stats[STAT_CLASS])->crouchViewheight
-                                                         : BG_ClassConfig(pm->ps->stats[STAT_CLASS])->viewheight;
+    pm->ps->viewheight = (pm->ps->pm_flags & PMF_DUCKED) ? pml.klass.crouchViewheight
+                                                         : pml.klass.viewheight;
 }
 
 /*
@@ -2417,7 +2417,7 @@ static void PM_Footsteps(void)
     // calculate speed and cycle to be used for
     // all cyclic walking effects
     //
-    if (BG_ClassHasAbility(pm->ps->stats[STAT_CLASS], SCA_WALLCLIMBER) && (pml.groundPlane))
+    if ((pml.klass.abilities & SCA_WALLCLIMBER) && (pml.groundPlane))
     {
         // FIXME: yes yes i know this is wrong
         pm->xyspeed = sqrt(pm->ps->velocity[0] * pm->ps->velocity[0] + pm->ps->velocity[1] * pm->ps->velocity[1] +
@@ -2574,7 +2574,7 @@ static void PM_Footsteps(void)
         }
     }
 
-    bobmove *= BG_Class(pm->ps->stats[STAT_CLASS])->bobCycle;
+    bobmove *= pml.klass.bobCycle;
 
     if (pm->ps->stats[STAT_STATE] & SS_SPEEDBOOST)
         bobmove *= HUMAN_SPRINT_MODIFIER;
@@ -3472,6 +3472,29 @@ void PM_UpdateViewAngles(playerState_t *ps, const usercmd_t *cmd)
     }
 }
 
+/*
+================
+PM_SetupClass
+
+Look up the class parameters the move functions need
+================
+*/
+static void PM_SetupClass(void)
+{
+    const classAttributes_t *ca = BG_Class(pm->ps->stats[STAT_CLASS]);
+    const classConfig_t *cc = BG_ClassConfig(pm->ps->stats[STAT_CLASS]);
+
+    pml.klass.abilities = ca->abilities;
+    pml.klass.bobCycle = ca->bobCycle;
+    pml.klass.acceleration = ca->acceleration;
+    pml.klass.airAcceleration = ca->airAcceleration;
+    pml.klass.friction = ca->friction;
+    pml.klass.stopSpeed = ca->stopSpeed;
+    pml.klass.jumpMagnitude = ca->jumpMagnitude;
+    pml.klass.viewheight = cc->viewheight;
+    pml.klass.crouchViewheight = cc->crouchViewheight;
+}
+
 /*
 ================
 PmoveSingle
@@ -3545,6 +3568,8 @@ void PmoveSingle(pmove_t *pmove)
     // clear all pmove local vars
     memset(&pml, 0, sizeof(pml));
 
+    PM_SetupClass();
+
     // determine the time
     pml.msec = pmove->cmd.serverTime - pm->ps->commandTime;
 
@@ -3641,7 +3666,7 @@ void PmoveSingle(pmove_t *pmove)
         PM_LadderMove();
     else if (pml.walking)
     {
-        if (BG_ClassHasAbility(pm->ps->stats[STAT_CLASS], SCA_WALLCLIMBER) &&
+        if ((pml.klass.abilities & SCA_WALLCLIMBER) &&
             (pm->ps->stats[STAT_STATE] & SS_WALLCLIMBING))
             PM_ClimbMove();  // walking on any surface
         else
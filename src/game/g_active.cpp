@@ -269,8 +269,8 @@ void ClientImpacts(gentity_t *ent, pmove_t *pm)
         // if our movement is blocked by another player's real position,
         // don't use the unlagged position for them because they are
         // blocking or server-side Pmove() from reaching it
-        if (other->client && other->client->unlaggedCalc.used)
-            other->client->unlaggedCalc.used = false;
+        if (other->client)
+            level.unlaggedCalc.used[other->s.number] = false;
 
         // tyrant impact attacks
         if (ent->client->ps.weapon == WP_ALEVEL4)
@@ -300,41 +300,78 @@ Spectators will only interact with teleporters.
 void G_TouchTriggers(gentity_t *ent)
 {
     int i, num;
-    int touch[MAX_GENTITIES];
+    gentity_t *touch[MAX_GENTITIES];
+    gentity_t **list;
     gentity_t *hit;
+    gclient_t *client = ent->client;
     trace_t trace;
     vec3_t mins, maxs;
     vec3_t pmins, pmaxs;
+    int cell[3];
+    int klass;
     static vec3_t range = {10, 10, 10};
 
-    if (!ent->client)
+    if (!client)
         return;
 
     // noclipping clients don't activate triggers!
-    if (ent->client->noclip)
+    if (client->noclip)
         return;
 
     // dead clients don't activate triggers!
-    if (ent->client->ps.stats[STAT_HEALTH] <= 0)
+    if (client->ps.stats[STAT_HEALTH] <= 0)
         return;
 
-    BG_ClassBoundingBox(ent->client->ps.stats[STAT_CLASS], pmins, pmaxs, NULL, NULL, NULL);
+    klass = client->ps.stats[STAT_CLASS];
+    BG_ClassBoundingBox(klass, pmins, pmaxs, NULL, NULL, NULL);
 
-    VectorAdd(ent->client->ps.origin, pmins, mins);
-    VectorAdd(ent->client->ps.origin, pmaxs, maxs);
+    for (i = 0; i < 3; i++)
+        cell[i] = (int)floor(client->ps.origin[i] / TRIGGER_CELL);
 
-    VectorSubtract(mins, range, mins);
-    VectorAdd(maxs, range, maxs);
+    // the triggers near the cell the client is in are reused until it
+    // leaves the cell, changes class or any trigger changes
+    if (client->triggersCached && client->triggerGeneration == level.triggerGeneration &&
+        client->triggerClass == klass && client->triggerCell[0] == cell[0] && client->triggerCell[1] == cell[1] &&
+        client->triggerCell[2] == cell[2])
+    {
+        list = client->triggers;
+        num = client->numTriggers;
+    }
+    else
+    {
+        for (i = 0; i < 3; i++)
+        {
+            mins[i] = cell[i] * TRIGGER_CELL + pmins[i] - range[i];
+            maxs[i] = (cell[i] + 1) * TRIGGER_CELL + pmaxs[i] + range[i];
+        }
 
-    num = SV_AreaEntities(mins, maxs, touch, MAX_GENTITIES);
+        num = G_TriggersInBox(mins, maxs, touch, MAX_GENTITIES);
+        list = touch;
+
+        client->triggersCached = (num <= MAX_CACHED_TRIGGERS);
+        if (client->triggersCached)
+        {
+            memcpy(client->triggers, touch, num * sizeof(touch[0]));
+            client->numTriggers = num;
+            client->triggerGeneration = level.triggerGeneration;
+            client->triggerClass = klass;
+            for (i = 0; i < 3; i++)
+                client->triggerCell[i] = cell[i];
+            list = client->triggers;
+        }
+    }
 
     // can't use ent->absmin, because that has a one unit pad
-    VectorAdd(ent->client->ps.origin, ent->r.mins, mins);
-    VectorAdd(ent->client->ps.origin, ent->r.maxs, maxs);
+    VectorAdd(client->ps.origin, ent->r.mins, mins);
+    VectorAdd(client->ps.origin, ent->r.maxs, maxs);
 
     for (i = 0; i < num; i++)
     {
-        hit = &g_entities[touch[i]];
+        hit = list[i];
+
+        // an earlier touch may have freed it
+        if (!hit->inuse || !hit->r.linked)
+            continue;
 
         if (!hit->touch && !ent->touch)
             continue;
@@ -894,8 +931,8 @@ void SendPendingPredictableEvents(playerState_t *ps)
 ==============
  G_UnlaggedStore
 
- Called on every server frame.  Stores position data for the client at that
- into client->unlaggedHist[] and the time into level.unlaggedTimes[].
+ Called on every server frame.  Stores position data for all clients
+ and the time into the next level.unlaggedHist[] frame.
  This data is used by G_UnlaggedCalc()
 ==============
 */
@@ -903,7 +940,7 @@ void G_UnlaggedStore(void)
 {
     int i = 0;
     gentity_t *ent;
-    unlagged_t *save;
+    unlaggedFrame_t *save;
 
     if (!g_unlagged.integer)
         return;
@@ -911,21 +948,24 @@ void G_UnlaggedStore(void)
     if (level.unlaggedIndex >= MAX_UNLAGGED_MARKERS)
         level.unlaggedIndex = 0;
 
-    level.unlaggedTimes[level.unlaggedIndex] = level.time;
+    // the markers G_UnlaggedCalc picks for a given time have moved on
+    level.unlaggedCalcCached = false;
+
+    save = &level.unlaggedHist[level.unlaggedIndex];
+    save->time = level.time;
 
     for (i = 0; i < level.maxclients; i++)
     {
         ent = &g_entities[i];
-        save = &ent->client->unlaggedHist[level.unlaggedIndex];
-        save->used = false;
+        save->used[i] = false;
         if (!ent->r.linked || !(ent->r.contents & CONTENTS_BODY))
             continue;
         if (ent->client->pers.connected != CON_CONNECTED)
             continue;
-        VectorCopy(ent->r.mins, save->mins);
-        VectorCopy(ent->r.maxs, save->maxs);
-        VectorCopy(ent->s.pos.trBase, save->origin);
-        save->used = true;
+        VectorCopy(ent->r.mins, save->mins[i]);
+        VectorCopy(ent->r.maxs, save->maxs[i]);
+        VectorCopy(ent->s.pos.trBase, save->origin[i]);
+        save->used[i] = true;
     }
 }
 
@@ -940,9 +980,26 @@ void G_UnlaggedStore(void)
 void G_UnlaggedClear(gentity_t *ent)
 {
     int i;
+    int num = ent - g_entities;
 
     for (i = 0; i < MAX_UNLAGGED_MARKERS; i++)
-        ent->client->unlaggedHist[i].used = false;
+        level.unlaggedHist[i].used[num] = false;
+}
+
+/*
+==============
+ G_UnlaggedLerp
+
+ out = from + lerp * ( to - from ) over count floats.  Kept as a flat
+ loop over contiguous arrays so the compiler can vectorize it.
+==============
+*/
+static void G_UnlaggedLerp(float lerp, const float *from, const float *to, float *out, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        out[i] = from[i] + lerp * (to[i] - from[i]);
 }
 
 /*
@@ -950,7 +1007,11 @@ void G_UnlaggedClear(gentity_t *ent)
  G_UnlaggedCalc
 
  Loops through all active clients and calculates their predicted position
- for time then stores it in client->unlaggedCalc
+ for time then stores it in level.unlaggedCalc
+
+ The interpolation only depends on time and the stored history, so it is
+ done once for all clients and reused by later calls in the same frame
+ that ask for the same time.
 ==============
 */
 void G_UnlaggedCalc(int time, gentity_t *rewindEnt)
@@ -961,43 +1022,60 @@ void G_UnlaggedCalc(int time, gentity_t *rewindEnt)
     int stopIndex;
     int frameMsec;
     float lerp;
+    unlaggedFrame_t *calc = &level.unlaggedCalc;
+    unlaggedFrame_t *start, *stop;
 
     if (!g_unlagged.integer)
         return;
 
     // clear any calculated values from a previous run
     for (i = 0; i < level.maxclients; i++)
-    {
-        ent = &g_entities[i];
-        ent->client->unlaggedCalc.used = false;
-    }
+        calc->used[i] = false;
 
     // client is on the current frame, no need for unlagged
-    if (level.unlaggedTimes[level.unlaggedIndex] <= time)
+    if (level.unlaggedHist[level.unlaggedIndex].time <= time)
         return;
 
-    startIndex = level.unlaggedIndex;
-    for (i = 1; i < MAX_UNLAGGED_MARKERS; i++)
-    {
-        stopIndex = startIndex;
-        if (--startIndex < 0)
-            startIndex = MAX_UNLAGGED_MARKERS - 1;
-        if (level.unlaggedTimes[startIndex] <= time)
-            break;
-    }
-    if (i == MAX_UNLAGGED_MARKERS)
-    {
-        // if we searched all markers and the oldest one still isn't old enough
-        // just use the oldest marker with no lerping
-        lerp = 0.0f;
-    }
-    else
+    if (!level.unlaggedCalcCached || calc->time != time)
     {
-        // lerp between two markers
-        frameMsec = level.unlaggedTimes[stopIndex] - level.unlaggedTimes[startIndex];
-        lerp = (float)(time - level.unlaggedTimes[startIndex]) / (float)frameMsec;
+        startIndex = level.unlaggedIndex;
+        for (i = 1; i < MAX_UNLAGGED_MARKERS; i++)
+        {
+            stopIndex = startIndex;
+            if (--startIndex < 0)
+                startIndex = MAX_UNLAGGED_MARKERS - 1;
+            if (level.unlaggedHist[startIndex].time <= time)
+                break;
+        }
+        if (i == MAX_UNLAGGED_MARKERS)
+        {
+            // if we searched all markers and the oldest one still isn't old enough
+            // just use the oldest marker with no lerping
+            lerp = 0.0f;
+        }
+        else
+        {
+            // lerp between two markers
+            frameMsec = level.unlaggedHist[stopIndex].time - level.unlaggedHist[startIndex].time;
+            lerp = (float)(time - level.unlaggedHist[startIndex].time) / (float)frameMsec;
+        }
+
+        // between two unlagged markers, for every client at once
+        start = &level.unlaggedHist[startIndex];
+        stop = &level.unlaggedHist[stopIndex];
+        G_UnlaggedLerp(lerp, start->mins[0], stop->mins[0], calc->mins[0], 3 * level.maxclients);
+        G_UnlaggedLerp(lerp, start->maxs[0], stop->maxs[0], calc->maxs[0], 3 * level.maxclients);
+        G_UnlaggedLerp(lerp, start->origin[0], stop->origin[0], calc->origin[0], 3 * level.maxclients);
+
+        calc->time = time;
+        level.unlaggedCalcStart = startIndex;
+        level.unlaggedCalcStop = stopIndex;
+        level.unlaggedCalcCached = true;
     }
 
+    start = &level.unlaggedHist[level.unlaggedCalcStart];
+    stop = &level.unlaggedHist[level.unlaggedCalcStop];
+
     for (i = 0; i < level.maxclients; i++)
     {
         ent = &g_entities[i];
@@ -1007,20 +1085,12 @@ void G_UnlaggedCalc(int time, gentity_t *rewindEnt)
             continue;
         if (ent->client->pers.connected != CON_CONNECTED)
             continue;
-        if (!ent->client->unlaggedHist[startIndex].used)
+        if (!start->used[i])
             continue;
-        if (!ent->client->unlaggedHist[stopIndex].used)
+        if (!stop->used[i])
             continue;
 
-        // between two unlagged markers
-        VectorLerp2(lerp, ent->client->unlaggedHist[startIndex].mins, ent->client->unlaggedHist[stopIndex].mins,
-            ent->client->unlaggedCalc.mins);
-        VectorLerp2(lerp, ent->client->unlaggedHist[startIndex].maxs, ent->client->unlaggedHist[stopIndex].maxs,
-            ent->client->unlaggedCalc.maxs);
-        VectorLerp2(lerp, ent->client->unlaggedHist[startIndex].origin, ent->client->unlaggedHist[stopIndex].origin,
-            ent->client->unlaggedCalc.origin);
-
-        ent->client->unlaggedCalc.used = true;
+        calc->used[i] = true;
     }
 }
 
@@ -1052,6 +1122,55 @@ void G_UnlaggedOff(void)
     }
 }
 
+/*
+==============
+ G_UnlaggedRewind
+
+ Whether client i has an unlagged position that G_UnlaggedOn() could
+ move it to
+==============
+*/
+static bool G_UnlaggedRewind(int i)
+{
+    gentity_t *ent = &g_entities[i];
+
+    if (!level.unlaggedCalc.used[i])
+        return false;
+    if (ent->client->unlaggedBackup.used)
+        return false;
+    if (!ent->r.linked || !(ent->r.contents & CONTENTS_BODY))
+        return false;
+    if (VectorCompare(ent->r.currentOrigin, level.unlaggedCalc.origin[i]))
+        return false;
+
+    return true;
+}
+
+/*
+==============
+ G_UnlaggedMove
+
+ Backs up the real position of client i and moves it to its unlagged one
+==============
+*/
+static void G_UnlaggedMove(int i)
+{
+    gentity_t *ent = &g_entities[i];
+    unlaggedFrame_t *calc = &level.unlaggedCalc;
+
+    // create a backup of the real positions
+    VectorCopy(ent->r.mins, ent->client->unlaggedBackup.mins);
+    VectorCopy(ent->r.maxs, ent->client->unlaggedBackup.maxs);
+    VectorCopy(ent->r.currentOrigin, ent->client->unlaggedBackup.origin);
+    ent->client->unlaggedBackup.used = true;
+
+    // move the client to the calculated unlagged position
+    VectorCopy(calc->mins[i], ent->r.mins);
+    VectorCopy(calc->maxs[i], ent->r.maxs);
+    VectorCopy(calc->origin[i], ent->r.currentOrigin);
+    G_LinkEntity(ent);
+}
+
 /*
 ==============
  G_UnlaggedOn
@@ -1069,8 +1188,7 @@ void G_UnlaggedOff(void)
 void G_UnlaggedOn(gentity_t *attacker, vec3_t muzzle, float range)
 {
     int i = 0;
-    gentity_t *ent;
-    unlagged_t *calc;
+    unlaggedFrame_t *calc = &level.unlaggedCalc;
 
     if (!g_unlagged.integer)
         return;
@@ -1080,40 +1198,121 @@ void G_UnlaggedOn(gentity_t *attacker, vec3_t muzzle, float range)
 
     for (i = 0; i < level.maxclients; i++)
     {
-        ent = &g_entities[i];
-        calc = &ent->client->unlaggedCalc;
-
-        if (!calc->used)
-            continue;
-        if (ent->client->unlaggedBackup.used)
-            continue;
-        if (!ent->r.linked || !(ent->r.contents & CONTENTS_BODY))
-            continue;
-        if (VectorCompare(ent->r.currentOrigin, calc->origin))
+        if (!G_UnlaggedRewind(i))
             continue;
         if (muzzle)
         {
-            float r1 = Distance(calc->origin, calc->maxs);
-            float r2 = Distance(calc->origin, calc->mins);
+            float r1 = Distance(calc->origin[i], calc->maxs[i]);
+            float r2 = Distance(calc->origin[i], calc->mins[i]);
             float maxRadius = (r1 > r2) ? r1 : r2;
 
-            if (Distance(muzzle, calc->origin) > range + maxRadius)
+            if (Distance(muzzle, calc->origin[i]) > range + maxRadius)
                 continue;
         }
 
-        // create a backup of the real positions
-        VectorCopy(ent->r.mins, ent->client->unlaggedBackup.mins);
-        VectorCopy(ent->r.maxs, ent->client->unlaggedBackup.maxs);
-        VectorCopy(ent->r.currentOrigin, ent->client->unlaggedBackup.origin);
-        ent->client->unlaggedBackup.used = true;
+        G_UnlaggedMove(i);
+    }
+}
 
-        // move the client to the calculated unlagged position
-        VectorCopy(calc->mins, ent->r.mins);
-        VectorCopy(calc->maxs, ent->r.maxs);
-        VectorCopy(calc->origin, ent->r.currentOrigin);
-        G_LinkEntity(ent);
+/*
+==============
+ G_UnlaggedTraceHitsBox
+
+ Whether a box of mins/maxs swept from start to end can touch the box
+ absmin/absmax, by clipping the segment against the box grown by the
+ swept box
+==============
+*/
+static bool G_UnlaggedTraceHitsBox(const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end,
+    const vec3_t absmin, const vec3_t absmax)
+{
+    float enter = 0.0f, leave = 1.0f;
+    float lo, hi, delta, t0, t1;
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        // a little slack so boxes that only touch are not culled
+        lo = absmin[i] - maxs[i] - 1.0f;
+        hi = absmax[i] - mins[i] + 1.0f;
+        delta = end[i] - start[i];
+
+        if (delta == 0.0f)
+        {
+            if (start[i] < lo || start[i] > hi)
+                return false;
+            continue;
+        }
+
+        t0 = (lo - start[i]) / delta;
+        t1 = (hi - start[i]) / delta;
+        if (t0 > t1)
+        {
+            float t = t0;
+            t0 = t1;
+            t1 = t;
+        }
+
+        if (t0 > enter)
+            enter = t0;
+        if (t1 < leave)
+            leave = t1;
+        if (enter > leave)
+            return false;
     }
+
+    return true;
 }
+
+/*
+==============
+ G_UnlaggedOnTrace
+
+ Like G_UnlaggedOn(), for a single trace of a mins/maxs box from start to
+ end.  Clients are only moved if the trace can touch either their unlagged
+ or their real position, everyone else can't affect the result.  mins and
+ maxs may be NULL for a line trace.
+==============
+*/
+void G_UnlaggedOnTrace(gentity_t *attacker, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end)
+{
+    int i = 0;
+    gentity_t *ent;
+    unlaggedFrame_t *calc = &level.unlaggedCalc;
+    vec3_t absmin, absmax;
+
+    if (!g_unlagged.integer)
+        return;
+
+    if (!attacker->client->pers.useUnlagged)
+        return;
+
+    if (!mins)
+        mins = vec3_origin;
+    if (!maxs)
+        maxs = vec3_origin;
+
+    for (i = 0; i < level.maxclients; i++)
+    {
+        if (!G_UnlaggedRewind(i))
+            continue;
+
+        ent = &g_entities[i];
+
+        VectorAdd(calc->origin[i], calc->mins[i], absmin);
+        VectorAdd(calc->origin[i], calc->maxs[i], absmax);
+        if (!G_UnlaggedTraceHitsBox(start, mins, maxs, end, absmin, absmax))
+        {
+            VectorAdd(ent->r.currentOrigin, ent->r.mins, absmin);
+            VectorAdd(ent->r.currentOrigin, ent->r.maxs, absmax);
+            if (!G_UnlaggedTraceHitsBox(start, mins, maxs, end, absmin, absmax))
+                continue;
+        }
+
+        G_UnlaggedMove(i);
+    }
+}
+
 /*
 ==============
  G_UnlaggedDetectCollisions
@@ -1138,10 +1337,7 @@ void G_UnlaggedOn(gentity_t *attacker, vec3_t muzzle, float range)
 */
 static void G_UnlaggedDetectCollisions(gentity_t *ent)
 {
-    unlagged_t *calc;
     trace_t tr;
-    float r1, r2;
-    float range;
 
     if (!g_unlagged.integer)
         return;
@@ -1149,30 +1345,36 @@ static void G_UnlaggedDetectCollisions(gentity_t *ent)
     if (!ent->client->pers.useUnlagged)
         return;
 
-    calc = &ent->client->unlaggedCalc;
-
     // if the client isn't moving, this is not necessary
     if (VectorCompare(ent->client->oldOrigin, ent->client->ps.origin))
         return;
 
-    range = Distance(ent->client->oldOrigin, ent->client->ps.origin);
-
-    // increase the range by the player's largest possible radius since it's
-    // the players bounding box that collides, not their origin
-    r1 = Distance(calc->origin, calc->mins);
-    r2 = Distance(calc->origin, calc->maxs);
-    range += (r1 > r2) ? r1 : r2;
-
-    G_UnlaggedOn(ent, ent->client->oldOrigin, range);
+    G_UnlaggedOnTrace(ent, ent->client->oldOrigin, ent->r.mins, ent->r.maxs, ent->client->ps.origin);
 
     SV_Trace(&tr, ent->client->oldOrigin, ent->r.mins, ent->r.maxs,
             ent->client->ps.origin, ent->s.number, MASK_PLAYERSOLID, TT_AABB);
     if (tr.entityNum >= 0 && tr.entityNum < MAX_CLIENTS)
-        g_entities[tr.entityNum].client->unlaggedCalc.used = false;
+        level.unlaggedCalc.used[tr.entityNum] = false;
 
     G_UnlaggedOff();
 }
 
+/*
+==============
+ClientUpdateBuildPoints
+
+Build points shown on the client's HUD for where it stands
+==============
+*/
+static void ClientUpdateBuildPoints(gclient_t *client)
+{
+    client->ps.persistant[PERS_BP] = G_GetBuildPoints(client->ps.origin, client->ps.stats[STAT_TEAM]);
+    client->ps.persistant[PERS_MARKEDBP] = G_GetMarkedBuildPoints(client->ps.origin, client->ps.stats[STAT_TEAM]);
+
+    if (client->ps.persistant[PERS_BP] < 0)
+        client->ps.persistant[PERS_BP] = 0;
+}
+
 /*
 ==============
 ClientThink
@@ -1655,11 +1857,11 @@ void ClientThink_real(gentity_t *ent)
         }
     }
 
-    client->ps.persistant[PERS_BP] = G_GetBuildPoints(client->ps.origin, client->ps.stats[STAT_TEAM]);
-    client->ps.persistant[PERS_MARKEDBP] = G_GetMarkedBuildPoints(client->ps.origin, client->ps.stats[STAT_TEAM]);
-
-    if (client->ps.persistant[PERS_BP] < 0)
-        client->ps.persistant[PERS_BP] = 0;
+    // within a batch only where the client ends up matters
+    if (client->thinkBatch)
+        client->thinkBatchBuildPoints = true;
+    else
+        ClientUpdateBuildPoints(client);
 
     // perform once-a-second actions
     ClientTimerActions(ent, msec);
@@ -1695,6 +1897,58 @@ void ClientThink(int clientNum)
         ClientThink_real(ent);
 }
 
+/*
+==================
+ClientThinkBatch
+
+Several new commands have arrived from the client at once.  They are run
+in order like ClientThink would, except that work which only depends on
+where the client ends up is done once after the last one.
+==================
+*/
+int ClientThinkBatch(int clientNum, int numCmds)
+{
+    gentity_t *ent;
+    gclient_t *client;
+    usercmd_t cmds[MAX_THINK_BATCH];
+    int i;
+
+    ent = g_entities + clientNum;
+    client = ent->client;
+    numCmds = SV_GetUsercmds(clientNum, cmds, MIN(numCmds, MAX_THINK_BATCH));
+    if (numCmds <= 0)
+        return 0;
+
+    // mark the time we got info, so we can display the
+    // phone jack if they don't get any for a while
+    client->lastCmdTime = level.time;
+
+    // G_RunClient only uses the latest command
+    if (g_synchronousClients.integer)
+    {
+        client->pers.cmd = cmds[numCmds - 1];
+        return numCmds;
+    }
+
+    client->thinkBatch = true;
+    client->thinkBatchBuildPoints = false;
+
+    for (i = 0; i < numCmds; i++)
+    {
+        // a respawn during ClientThink_real reads the command being run
+        SV_SetThinkCmd(clientNum, i);
+        client->pers.cmd = cmds[i];
+        ClientThink_real(ent);
+    }
+
+    client->thinkBatch = false;
+
+    if (client->thinkBatchBuildPoints && client->pers.connected == CON_CONNECTED)
+        ClientUpdateBuildPoints(client);
+
+    return numCmds;
+}
+
 void G_RunClient(gentity_t *ent)
 {
     if (!g_synchronousClients.integer)
@@ -412,7 +412,116 @@ static void admin_writeconfig_int(int v, fileHandle_t f)
     FS_Write(buf, strlen(buf), f);
 }
 
-static void admin_writeconfig(void)
+static void admin_writeconfig_admin(g_admin_admin_t *a, fileHandle_t f)
+{
+    FS_Write("[admin]\n", 8, f);
+    FS_Write("name    = ", 10, f);
+    admin_writeconfig_string(a->name, f);
+    FS_Write("guid    = ", 10, f);
+    admin_writeconfig_string(a->guid, f);
+    FS_Write("level   = ", 10, f);
+    admin_writeconfig_int(a->level, f);
+    FS_Write("flags   = ", 10, f);
+    admin_writeconfig_string(a->flags, f);
+    FS_Write("\n", 1, f);
+}
+
+static void admin_writeconfig_ban(g_admin_ban_t *b, fileHandle_t f)
+{
+    FS_Write("[ban]\n", 6, f);
+    FS_Write("name    = ", 10, f);
+    admin_writeconfig_string(b->name, f);
+    FS_Write("guid    = ", 10, f);
+    admin_writeconfig_string(b->guid, f);
+    FS_Write("ip      = ", 10, f);
+    admin_writeconfig_string(b->ip.str, f);
+    FS_Write("reason  = ", 10, f);
+    admin_writeconfig_string(b->reason, f);
+    FS_Write("made    = ", 10, f);
+    admin_writeconfig_string(b->made, f);
+    FS_Write("expires = ", 10, f);
+    admin_writeconfig_int(b->expires, f);
+    FS_Write("banner  = ", 10, f);
+    admin_writeconfig_string(b->banner, f);
+    FS_Write("\n", 1, f);
+}
+
+/*
+===============
+Admin journal
+
+Changes made while the map runs are appended to <g_admin>.journal instead
+of rewriting g_admin.  The journal starts with the size and checksum of
+the g_admin it applies to, so a journal left behind by a crash during
+compaction is not replayed twice.  G_admin_readconfig replays it on top of
+g_admin in the same parse and compacts both into a new g_admin, which
+happens at every map change.
+===============
+*/
+static int admin_snapshot_length = -1;  // size of g_admin the journal applies to
+static int admin_snapshot_checksum;
+
+static void admin_ban_index_all(void);
+
+static const char *admin_journal_name(void) { return va("%s.journal", g_admin.string); }
+
+// FNV-1a
+static int admin_checksum(const char *data, int len)
+{
+    unsigned int hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < len; i++)
+        hash = (hash ^ (byte)data[i]) * 16777619u;
+
+    return (int)hash;
+}
+
+// checks the "[journal] snapshot = <size> checksum = <checksum>" header
+static bool admin_journal_matches(char *journal, int len, int checksum)
+{
+    char *t = journal;
+
+    if (Q_stricmp(COM_Parse(&t), "[journal]"))
+        return false;
+
+    if (Q_stricmp(COM_Parse(&t), "snapshot") || strcmp(COM_Parse(&t), "=") || atoi(COM_Parse(&t)) != len)
+        return false;
+
+    if (Q_stricmp(COM_Parse(&t), "checksum") || strcmp(COM_Parse(&t), "=") ||
+        atoi(COM_Parse(&t)) != checksum)
+        return false;
+
+    return true;
+}
+
+static void admin_journal_reset(void)
+{
+    fileHandle_t f;
+    char header[64];
+
+    if (FS_FOpenFileByMode(admin_journal_name(), &f, FS_WRITE) < 0)
+    {
+        G_Printf("admin_journal_reset: could not open admin journal \"%s\"\n", admin_journal_name());
+        admin_snapshot_length = -1;
+        return;
+    }
+    Com_sprintf(header, sizeof(header), "[journal]\nsnapshot = %d\nchecksum = %d\n\n", admin_snapshot_length,
+        admin_snapshot_checksum);
+    FS_Write(header, strlen(header), f);
+    FS_FCloseFile(f);
+}
+
+/*
+===============
+admin_writeconfig
+
+Writes a new g_admin snapshot and starts an empty journal for it.  Expired
+bans are only dropped when prune is set, since that renumbers the bans
+[banupdate] and the ban# of showbans refer to.
+===============
+*/
+static void admin_writeconfig(bool prune)
 {
     fileHandle_t f;
     int t;
@@ -451,40 +560,16 @@ static void admin_writeconfig(void)
         if (a->level == 0)
             continue;
 
-        FS_Write("[admin]\n", 8, f);
-        FS_Write("name    = ", 10, f);
-        admin_writeconfig_string(a->name, f);
-        FS_Write("guid    = ", 10, f);
-        admin_writeconfig_string(a->guid, f);
-        FS_Write("level   = ", 10, f);
-        admin_writeconfig_int(a->level, f);
-        FS_Write("flags   = ", 10, f);
-        admin_writeconfig_string(a->flags, f);
-        FS_Write("\n", 1, f);
+        admin_writeconfig_admin(a, f);
     }
     for (b = g_admin_bans; b; b = b->next)
     {
         // don't write expired bans
         // if expires is 0, then it's a perm ban
-        if (b->expires != 0 && b->expires <= t)
+        if (prune && b->expires != 0 && b->expires <= t)
             continue;
 
-        FS_Write("[ban]\n", 6, f);
-        FS_Write("name    = ", 10, f);
-        admin_writeconfig_string(b->name, f);
-        FS_Write("guid    = ", 10, f);
-        admin_writeconfig_string(b->guid, f);
-        FS_Write("ip      = ", 10, f);
-        admin_writeconfig_string(b->ip.str, f);
-        FS_Write("reason  = ", 10, f);
-        admin_writeconfig_string(b->reason, f);
-        FS_Write("made    = ", 10, f);
-        admin_writeconfig_string(b->made, f);
-        FS_Write("expires = ", 10, f);
-        admin_writeconfig_int(b->expires, f);
-        FS_Write("banner  = ", 10, f);
-        admin_writeconfig_string(b->banner, f);
-        FS_Write("\n", 1, f);
+        admin_writeconfig_ban(b, f);
     }
     for (c = g_admin_commands; c; c = c->next)
     {
@@ -500,6 +585,114 @@ static void admin_writeconfig(void)
         FS_Write("\n", 1, f);
     }
     FS_FCloseFile(f);
+
+    // [banupdate] refers to bans by ban#, so drop the expired bans that were
+    // not written to keep the numbering in sync with the new snapshot
+    for (b = prune ? g_admin_bans : NULL; b && b->next;)
+    {
+        g_admin_ban_t *n = b->next;
+
+        if (n->expires != 0 && n->expires <= t)
+        {
+            b->next = n->next;
+            BG_Free(n);
+        }
+        else
+            b = n;
+    }
+    if (prune && g_admin_bans && g_admin_bans->expires != 0 && g_admin_bans->expires <= t)
+    {
+        b = g_admin_bans;
+        g_admin_bans = b->next;
+        BG_Free(b);
+    }
+    admin_ban_index_all();
+
+    // the journal now applies to the new snapshot
+    admin_snapshot_length = FS_FOpenFileByMode(g_admin.string, &f, FS_READ);
+    if (admin_snapshot_length >= 0)
+    {
+        char *data = static_cast<char *>(BG_Alloc(admin_snapshot_length + 1));
+
+        FS_Read(data, admin_snapshot_length, f);
+        FS_FCloseFile(f);
+        admin_snapshot_checksum = admin_checksum(data, admin_snapshot_length);
+        BG_Free(data);
+    }
+    admin_journal_reset();
+}
+
+/*
+===============
+admin_journal_open
+
+Falls back to rewriting g_admin when there is no snapshot to journal
+against.  Expired bans are kept so ban#s stay the same until the next map.
+===============
+*/
+static bool admin_journal_open(fileHandle_t *f)
+{
+    if (!g_admin.string[0])
+        return false;
+
+    if (admin_snapshot_length < 0)
+    {
+        admin_writeconfig(false);
+        return false;
+    }
+
+    if (FS_FOpenFileByMode(admin_journal_name(), f, FS_APPEND) < 0)
+    {
+        admin_writeconfig(false);
+        return false;
+    }
+
+    return true;
+}
+
+static void admin_journal_admin(g_admin_admin_t *a)
+{
+    fileHandle_t f;
+
+    if (!admin_journal_open(&f))
+        return;
+
+    admin_writeconfig_admin(a, f);
+    FS_FCloseFile(f);
+}
+
+static void admin_journal_ban(g_admin_ban_t *b)
+{
+    fileHandle_t f;
+
+    if (!admin_journal_open(&f))
+        return;
+
+    admin_writeconfig_ban(b, f);
+    FS_FCloseFile(f);
+}
+
+// changes to an existing ban, which is identified by its ban#
+static void admin_journal_banupdate(g_admin_ban_t *b)
+{
+    fileHandle_t f;
+
+    if (!admin_journal_open(&f))
+        return;
+
+    FS_Write("[banupdate]\n", 12, f);
+    FS_Write("id      = ", 10, f);
+    admin_writeconfig_int(b->id, f);
+    FS_Write("ip      = ", 10, f);
+    admin_writeconfig_string(b->ip.str, f);
+    FS_Write("reason  = ", 10, f);
+    admin_writeconfig_string(b->reason, f);
+    FS_Write("expires = ", 10, f);
+    admin_writeconfig_int(b->expires, f);
+    FS_Write("banner  = ", 10, f);
+    admin_writeconfig_string(b->banner, f);
+    FS_Write("\n", 1, f);
+    FS_FCloseFile(f);
 }
 
 static void admin_readconfig_string(char **cnf, char *s, int size)
@@ -745,6 +938,209 @@ void G_admin_duration(int secs, char *duration, int dursize)
         Com_sprintf(duration, dursize, "%i seconds", secs);
 }
 
+/*
+===============
+Ban index
+
+Active bans are hashed by GUID and by masked address, with one hash table
+shared by all prefix lengths.  A lookup probes each prefix length that has
+bans, which for a typical ban list is a handful of probes rather than a walk
+over every ban.  Timed bans are also kept on a list sorted by expiry so
+expired bans drop out of the index as time passes.
+===============
+*/
+#define BAN_HASH_SIZE 4096  // power of two
+
+static g_admin_ban_t *banGuidHash[BAN_HASH_SIZE];
+static g_admin_ban_t *banAddrHash[BAN_HASH_SIZE];
+static g_admin_ban_t *banExpiry;
+static int banMaskCount[2][ADDRLEN * 8 + 1];
+
+static unsigned admin_hash_bytes(unsigned hash, const byte *data, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+
+    return hash;
+}
+
+static unsigned admin_hash_guid(const char *guid)
+{
+    unsigned hash = 2166136261u;
+
+    for (; *guid; guid++)
+        hash = (hash ^ (byte)tolower(*guid)) * 16777619u;
+
+    return hash & (BAN_HASH_SIZE - 1);
+}
+
+// the effective netmask, as G_AddressCompare applies it
+static int admin_addr_mask(const addr_t *addr)
+{
+    int max = addr->type == addr_t::IPv6 ? 128 : 32;
+
+    return addr->mask < 1 || addr->mask > max ? max : addr->mask;
+}
+
+static unsigned admin_hash_addr(const addr_t *addr, int mask)
+{
+    byte masked[ADDRLEN];
+    byte key[2];
+    int i;
+
+    memset(masked, 0, sizeof(masked));
+    for (i = 0; mask > 7; i++, mask -= 8)
+        masked[i] = addr->addr[i];
+    if (mask)
+        masked[i] = addr->addr[i] & (((1 << mask) - 1) << (8 - mask));
+
+    key[0] = addr->type;
+    key[1] = i * 8 + mask;
+
+    return admin_hash_bytes(admin_hash_bytes(2166136261u, key, 2), masked, ADDRLEN) & (BAN_HASH_SIZE - 1);
+}
+
+static void admin_ban_unlink(g_admin_ban_t **head, g_admin_ban_t *ban, size_t link)
+{
+    g_admin_ban_t **p;
+
+    for (p = head; *p; p = (g_admin_ban_t **)((char *)*p + link))
+    {
+        if (*p == ban)
+        {
+            *p = *(g_admin_ban_t **)((char *)ban + link);
+            return;
+        }
+    }
+}
+
+static void admin_ban_index(g_admin_ban_t *ban)
+{
+    int mask = admin_addr_mask(&ban->ip);
+    unsigned h;
+    g_admin_ban_t **p;
+
+    if (ban->indexed)
+        return;
+
+    h = admin_hash_guid(ban->guid);
+    ban->nextGuid = banGuidHash[h];
+    banGuidHash[h] = ban;
+
+    h = admin_hash_addr(&ban->ip, mask);
+    ban->nextAddr = banAddrHash[h];
+    banAddrHash[h] = ban;
+    banMaskCount[ban->ip.type][mask]++;
+
+    if (ban->expires)
+    {
+        for (p = &banExpiry; *p && (*p)->expires <= ban->expires; p = &(*p)->nextExpiry)
+            ;
+        ban->nextExpiry = *p;
+        *p = ban;
+    }
+
+    ban->indexed = true;
+}
+
+static void admin_ban_unindex(g_admin_ban_t *ban)
+{
+    int mask = admin_addr_mask(&ban->ip);
+
+    if (!ban->indexed)
+        return;
+
+    admin_ban_unlink(&banGuidHash[admin_hash_guid(ban->guid)], ban, offsetof(g_admin_ban_t, nextGuid));
+    admin_ban_unlink(&banAddrHash[admin_hash_addr(&ban->ip, mask)], ban, offsetof(g_admin_ban_t, nextAddr));
+    banMaskCount[ban->ip.type][mask]--;
+
+    if (ban->expires)
+        admin_ban_unlink(&banExpiry, ban, offsetof(g_admin_ban_t, nextExpiry));
+
+    ban->indexed = false;
+}
+
+// merge sort the expiry list after loading, inserting one by one is quadratic
+static g_admin_ban_t *admin_ban_sort_expiry(g_admin_ban_t *list)
+{
+    g_admin_ban_t *a, *b, *slow, *fast;
+    g_admin_ban_t *head = NULL, **tail = &head;
+
+    if (!list || !list->nextExpiry)
+        return list;
+
+    for (slow = list, fast = list->nextExpiry; fast && fast->nextExpiry; fast = fast->nextExpiry->nextExpiry)
+        slow = slow->nextExpiry;
+
+    b = slow->nextExpiry;
+    slow->nextExpiry = NULL;
+    a = admin_ban_sort_expiry(list);
+    b = admin_ban_sort_expiry(b);
+
+    while (a && b)
+    {
+        if (a->expires <= b->expires)
+            *tail = a, a = a->nextExpiry;
+        else
+            *tail = b, b = b->nextExpiry;
+        tail = &(*tail)->nextExpiry;
+    }
+    *tail = a ? a : b;
+
+    return head;
+}
+
+static void admin_ban_index_all(void)
+{
+    g_admin_ban_t *ban;
+    int t = Com_RealTime(NULL);
+    int id = 1;
+
+    memset(banGuidHash, 0, sizeof(banGuidHash));
+    memset(banAddrHash, 0, sizeof(banAddrHash));
+    memset(banMaskCount, 0, sizeof(banMaskCount));
+    banExpiry = NULL;
+
+    for (ban = g_admin_bans; ban; ban = ban->next)
+    {
+        int mask = admin_addr_mask(&ban->ip);
+        unsigned h;
+
+        ban->id = id++;
+        ban->indexed = false;
+
+        if (ban->expires != 0 && ban->expires <= t)
+            continue;
+
+        h = admin_hash_guid(ban->guid);
+        ban->nextGuid = banGuidHash[h];
+        banGuidHash[h] = ban;
+
+        h = admin_hash_addr(&ban->ip, mask);
+        ban->nextAddr = banAddrHash[h];
+        banAddrHash[h] = ban;
+        banMaskCount[ban->ip.type][mask]++;
+
+        if (ban->expires)
+        {
+            ban->nextExpiry = banExpiry;
+            banExpiry = ban;
+        }
+
+        ban->indexed = true;
+    }
+
+    banExpiry = admin_ban_sort_expiry(banExpiry);
+}
+
+static void admin_ban_expire(int t)
+{
+    while (banExpiry && banExpiry->expires <= t)
+        admin_ban_unindex(banExpiry);
+}
+
 static void G_admin_ban_message(gentity_t *ent, g_admin_ban_t *ban, char *creason, int clen, char *areason, int alen)
 {
     if (creason)
@@ -761,14 +1157,9 @@ static void G_admin_ban_message(gentity_t *ent, g_admin_ban_t *ban, char *creaso
 
     if (areason && ent)
     {
-        // we just want the ban number
-        int n = 1;
-        g_admin_ban_t *b = g_admin_bans;
-        for (; b && b != ban; b = b->next, n++)
-            ;
         Com_sprintf(areason, alen,
             S_COLOR_YELLOW "Banned player %s" S_COLOR_YELLOW " tried to connect from %s (ban #%d)",
-            ent->client->pers.netname[0] ? ent->client->pers.netname : ban->name, ent->client->pers.ip.str, n);
+            ent->client->pers.netname[0] ? ent->client->pers.netname : ban->name, ent->client->pers.ip.str, ban->id);
     }
 }
 
@@ -778,26 +1169,47 @@ static bool G_admin_ban_matches(g_admin_ban_t *ban, gentity_t *ent)
            (!G_admin_permission(ent, ADMF_IMMUNITY) && G_AddressCompare(&ban->ip, &ent->client->pers.ip));
 }
 
+/*
+===============
+G_admin_match_ban
+
+Returns the first active ban in ban# order that matches the client
+===============
+*/
 static g_admin_ban_t *G_admin_match_ban(gentity_t *ent)
 {
-    int t;
-    g_admin_ban_t *ban;
+    g_admin_ban_t *ban, *match = NULL;
+    addr_t *ip = &ent->client->pers.ip;
+    int mask, max;
 
-    t = Com_RealTime(NULL);
     if (ent->client->pers.localClient)
         return NULL;
 
-    for (ban = g_admin_bans; ban; ban = ban->next)
+    admin_ban_expire(Com_RealTime(NULL));
+
+    for (ban = banGuidHash[admin_hash_guid(ent->client->pers.guid)]; ban; ban = ban->nextGuid)
     {
-        // 0 is for perm ban
-        if (ban->expires != 0 && ban->expires <= t)
+        if ((!match || ban->id < match->id) && !Q_stricmp(ban->guid, ent->client->pers.guid))
+            match = ban;
+    }
+
+    if (G_admin_permission(ent, ADMF_IMMUNITY))
+        return match;
+
+    max = ip->type == addr_t::IPv6 ? 128 : 32;
+    for (mask = 1; mask <= max; mask++)
+    {
+        if (!banMaskCount[ip->type][mask])
             continue;
 
-        if (G_admin_ban_matches(ban, ent))
-            return ban;
+        for (ban = banAddrHash[admin_hash_addr(ip, mask)]; ban; ban = ban->nextAddr)
+        {
+            if ((!match || ban->id < match->id) && G_AddressCompare(&ban->ip, ip))
+                match = ban;
+        }
     }
 
-    return NULL;
+    return match;
 }
 
 bool G_admin_ban_check(gentity_t *ent, char *reason, int rlen)
@@ -927,16 +1339,20 @@ bool G_admin_readconfig(gentity_t *ent)
     g_admin_admin_t *a = NULL;
     g_admin_ban_t *b = NULL;
     g_admin_command_t *c = NULL;
+    g_admin_admin_t *journal_admin = NULL;
+    g_admin_ban_t *update, scratch;
     int lc = 0, ac = 0, bc = 0, cc = 0;
-    fileHandle_t f;
-    int len;
-    char *cnf, *cnf2;
+    fileHandle_t f, jf;
+    int len, jlen, jrecords = 0;
+    char *cnf, *cnf2, *journal;
     char *t;
     bool level_open, admin_open, ban_open, command_open;
-    int i;
+    bool journal_open, banupdate_open, journal_found = false, replaying = false;
+    int i, id;
     char ip[44];
 
     G_admin_cleanup();
+    admin_snapshot_length = -1;
 
     if (!g_admin.string[0])
     {
@@ -953,15 +1369,36 @@ bool G_admin_readconfig(gentity_t *ent)
         admin_default_levels();
         return false;
     }
-    cnf = static_cast<char *>(BG_Alloc(len + 1));
+    jlen = FS_FOpenFileByMode(admin_journal_name(), &jf, FS_READ);
+    cnf = static_cast<char *>(BG_Alloc(len + 1 + MAX(jlen, 0) + 1));
     cnf2 = cnf;
     FS_Read(cnf, len, f);
     *(cnf + len) = '\0';
     FS_FCloseFile(f);
+    admin_snapshot_length = len;
+    admin_snapshot_checksum = admin_checksum(cnf, len);
+
+    // replay the journal in the same parse if it was written against this
+    // g_admin, otherwise it is left over from a finished compaction
+    if (jlen >= 0)
+    {
+        journal = cnf + len + 1;
+        FS_Read(journal, jlen, jf);
+        journal[jlen] = '\0';
+        FS_FCloseFile(jf);
+
+        if (admin_journal_matches(journal, admin_snapshot_length, admin_snapshot_checksum))
+        {
+            cnf[len] = '\n';
+            journal_found = true;
+        }
+    }
 
     admin_level_maxname = 0;
 
+    update = &scratch;
     level_open = admin_open = ban_open = command_open = false;
+    journal_open = banupdate_open = false;
     COM_BeginParseSession(g_admin.string);
     while (1)
     {
@@ -977,6 +1414,7 @@ bool G_admin_readconfig(gentity_t *ent)
                 l = g_admin_levels = static_cast<g_admin_level_t *>(BG_Alloc(sizeof(g_admin_level_t)));
             level_open = true;
             admin_open = ban_open = command_open = false;
+            journal_open = banupdate_open = false;
             lc++;
         }
         else if (!Q_stricmp(t, "[admin]"))
@@ -987,7 +1425,10 @@ bool G_admin_readconfig(gentity_t *ent)
                 a = g_admin_admins = static_cast<g_admin_admin_t *>(BG_Alloc(sizeof(g_admin_admin_t)));
             admin_open = true;
             level_open = ban_open = command_open = false;
+            journal_open = banupdate_open = false;
             ac++;
+            if (replaying)
+                jrecords++;
         }
         else if (!Q_stricmp(t, "[ban]"))
         {
@@ -997,7 +1438,10 @@ bool G_admin_readconfig(gentity_t *ent)
                 b = g_admin_bans = static_cast<g_admin_ban_t *>(BG_Alloc(sizeof(g_admin_ban_t)));
             ban_open = true;
             level_open = admin_open = command_open = false;
+            journal_open = banupdate_open = false;
             bc++;
+            if (replaying)
+                jrecords++;
         }
         else if (!Q_stricmp(t, "[command]"))
         {
@@ -1007,8 +1451,23 @@ bool G_admin_readconfig(gentity_t *ent)
                 c = g_admin_commands = static_cast<g_admin_command_t *>(BG_Alloc(sizeof(g_admin_command_t)));
             command_open = true;
             level_open = admin_open = ban_open = false;
+            journal_open = banupdate_open = false;
             cc++;
         }
+        else if (!Q_stricmp(t, "[journal]"))
+        {
+            // everything after this was appended since the snapshot
+            journal_admin = a;
+            journal_open = replaying = true;
+            level_open = admin_open = ban_open = command_open = banupdate_open = false;
+        }
+        else if (!Q_stricmp(t, "[banupdate]"))
+        {
+            update = &scratch;
+            banupdate_open = true;
+            level_open = admin_open = ban_open = command_open = journal_open = false;
+            jrecords++;
+        }
         else if (level_open)
         {
             if (!Q_stricmp(t, "level"))
@@ -1114,12 +1573,87 @@ bool G_admin_readconfig(gentity_t *ent)
                 COM_ParseError("[command] unrecognized token \"%s\"", t);
             }
         }
+        else if (journal_open)
+        {
+            if (!Q_stricmp(t, "snapshot") || !Q_stricmp(t, "checksum"))
+            {
+                admin_readconfig_int(&cnf, &i);
+            }
+            else
+            {
+                COM_ParseError("[journal] unrecognized token \"%s\"", t);
+            }
+        }
+        else if (banupdate_open)
+        {
+            if (!Q_stricmp(t, "id"))
+            {
+                admin_readconfig_int(&cnf, &id);
+                for (update = g_admin_bans, i = 1; update && i < id; update = update->next, i++)
+                    ;
+                if (!update || id < 1)
+                {
+                    COM_ParseWarning("[banupdate] no ban #%d", id);
+                    update = &scratch;
+                }
+            }
+            else if (!Q_stricmp(t, "ip"))
+            {
+                admin_readconfig_string(&cnf, ip, sizeof(ip));
+                G_AddressParse(ip, &update->ip);
+            }
+            else if (!Q_stricmp(t, "reason"))
+            {
+                admin_readconfig_string(&cnf, update->reason, sizeof(update->reason));
+            }
+            else if (!Q_stricmp(t, "expires"))
+            {
+                admin_readconfig_int(&cnf, &update->expires);
+            }
+            else if (!Q_stricmp(t, "banner"))
+            {
+                admin_readconfig_string(&cnf, update->banner, sizeof(update->banner));
+            }
+            else
+            {
+                COM_ParseError("[banupdate] unrecognized token \"%s\"", t);
+            }
+        }
         else
         {
             COM_ParseError("unexpected token \"%s\"", t);
         }
     }
     BG_Free(cnf2);
+
+    // a journaled [admin] replaces the earlier record for the same guid
+    if (journal_found)
+    {
+        g_admin_admin_t *prev = journal_admin;
+        g_admin_admin_t *j = prev ? prev->next : g_admin_admins;
+
+        while (j)
+        {
+            g_admin_admin_t *o;
+
+            for (o = g_admin_admins; o != j && Q_stricmp(o->guid, j->guid); o = o->next)
+                ;
+            if (o == j)
+            {
+                prev = j;
+                j = j->next;
+                continue;
+            }
+            Q_strncpyz(o->name, j->name, sizeof(o->name));
+            o->level = j->level;
+            Q_strncpyz(o->flags, j->flags, sizeof(o->flags));
+            prev->next = j->next;
+            BG_Free(j);
+            j = prev->next;
+            ac--;
+        }
+    }
+    admin_ban_index_all();
     ADMP(va("^3readconfig: ^7loaded %d levels, %d admins, %d bans, %d commands\n", lc, ac, bc, cc));
     if (lc == 0)
         admin_default_levels();
@@ -1129,6 +1663,10 @@ bool G_admin_readconfig(gentity_t *ent)
         llsort((struct llist **)&g_admin_admins, cmplevel);
     }
 
+    // fold the journal into a fresh snapshot
+    if (!journal_found || jrecords)
+        admin_writeconfig(true);
+
     // restore admin mapping
     for (i = 0; i < level.maxclients; i++)
     {
@@ -1314,7 +1852,7 @@ bool G_admin_setlevel(gentity_t *ent)
     AP(va("print \"^3setlevel: ^7%s^7 was given level %d admin rights by %s\n\"", a->name, a->level,
         (ent) ? ent->client->pers.netname : "console"));
 
-    admin_writeconfig();
+    admin_journal_admin(a);
     if (vic)
     {
         G_admin_authlog(vic);
@@ -1344,10 +1882,17 @@ static void admin_create_ban(
     if (b)
     {
         if (!b->next)
+        {
+            i = b->id + 1;
             b = b->next = static_cast<g_admin_ban_t *>(BG_Alloc(sizeof(g_admin_ban_t)));
+            b->id = i;
+        }
     }
     else
+    {
         b = g_admin_bans = static_cast<g_admin_ban_t *>(BG_Alloc(sizeof(g_admin_ban_t)));
+        b->id = 1;
+    }
 
     Q_strncpyz(b->name, netname, sizeof(b->name));
     Q_strncpyz(b->guid, guid, sizeof(b->guid));
@@ -1373,6 +1918,9 @@ static void admin_create_ban(
     else
         Q_strncpyz(b->reason, reason, sizeof(b->reason));
 
+    admin_ban_index(b);
+    admin_journal_ban(b);
+
     G_admin_ban_message(NULL, b, disconnect, sizeof(disconnect), NULL, 0);
 
     for (i = 0; i < level.maxclients; i++)
@@ -1508,7 +2056,6 @@ bool G_admin_kick(gentity_t *ent)
     admin_create_ban(ent, vic->client->pers.netname, vic->client->pers.guidless ? "" : vic->client->pers.guid,
         &vic->client->pers.ip, MAX(1, G_admin_parse_time(g_adminTempBan.string)),
         (*reason) ? reason : "kicked by admin");
-    admin_writeconfig();
 
     return true;
 }
@@ -1568,7 +2115,8 @@ bool G_admin_ban(gentity_t *ent)
     int i;
     addr_t ip;
     bool ipmatch = false;
-    namelog_t *match = NULL;
+    namelog_t *match = NULL, *matches[MAX_NAMELOGS];
+    int found;
     bool cidr = false;
 
     if (Cmd_Argc() < 2)
@@ -1622,19 +2170,12 @@ bool G_admin_ban(gentity_t *ent)
         }
         ipmatch = true;
 
-        for (match = level.namelogs; match; match = match->next)
+        found = G_namelog_match_addr(&ip, matches, ARRAY_LEN(matches));
+        for (i = 0, match = NULL; i < found && !match; i++)
         {
             // skip players in the namelog who have already been banned
-            if (match->banned)
-                continue;
-
-            for (i = 0; i < MAX_NAMELOG_ADDRS && match->ip[i].str[0]; i++)
-            {
-                if (G_AddressCompare(&ip, &match->ip[i]))
-                    break;
-            }
-            if (i < MAX_NAMELOG_ADDRS && match->ip[i].str[0])
-                break;
+            if (!matches[i]->banned)
+                match = matches[i];
         }
 
         if (!match)
@@ -1710,8 +2251,6 @@ bool G_admin_ban(gentity_t *ent)
 
     if (!g_admin.string[0])
         ADMP("^3ban: ^7WARNING g_admin not set, not saving ban to a file\n");
-    else
-        admin_writeconfig();
 
     return true;
 }
@@ -1753,8 +2292,9 @@ bool G_admin_unban(gentity_t *ent)
         ban->expires ? ban->expires - time : 0, ban->guid, ban->name, ban->reason, ban->ip.str));
     AP(va("print \"^3unban: ^7ban #%d for %s^7 has been removed by %s\n\"", bnum, ban->name,
         (ent) ? ent->client->pers.netname : "console"));
+    admin_ban_unindex(ban);
     ban->expires = time;
-    admin_writeconfig();
+    admin_journal_banupdate(ban);
     return true;
 }
 
@@ -1868,12 +2408,15 @@ bool G_admin_adjustban(gentity_t *ent)
             expires = time + maximum;
         }
 
+        admin_ban_unindex(ban);
         ban->expires = expires;
         G_admin_duration((expires) ? expires - time : -1, duration, sizeof(duration));
     }
     if (mask)
     {
         char *p = strchr(ban->ip.str, '/');
+
+        admin_ban_unindex(ban);
         if (!p)
             p = ban->ip.str + strlen(ban->ip.str);
         if (mask == (ban->ip.type == addr_t::IPv6 ? 128 : 32))
@@ -1896,7 +2439,9 @@ bool G_admin_adjustban(gentity_t *ent)
             (*reason) ? "reason: " : "", reason));
     if (ent)
         Q_strncpyz(ban->banner, ent->client->pers.netname, sizeof(ban->banner));
-    admin_writeconfig();
+    if (ban->expires == 0 || ban->expires > time)
+        admin_ban_index(ban);
+    admin_journal_banupdate(ban);
     return true;
 }
 
@@ -2773,33 +3318,8 @@ bool G_admin_setnextmap(gentity_t *ent)
     return true;
 }
 
-static bool namelog_matchip(void *namelog, const void *ip)
-{
-    int i;
-    namelog_t *n = (namelog_t *)namelog;
-    for (i = 0; i < MAX_NAMELOG_ADDRS && n->ip[i].str[0]; i++)
-    {
-        if (G_AddressCompare(&n->ip[i], (addr_t *)ip) || G_AddressCompare((addr_t *)ip, &n->ip[i]))
-            return true;
-    }
-    return false;
-}
-static bool namelog_matchname(void *namelog, const void *name)
+static void namelog_out(namelog_t *n, char *str)
 {
-    char match[MAX_NAME_LENGTH];
-    int i;
-    namelog_t *n = (namelog_t *)namelog;
-    for (i = 0; i < MAX_NAMELOG_NAMES && n->name[i][0]; i++)
-    {
-        G_SanitiseString(n->name[i], match, sizeof(match));
-        if (strstr(match, (const char *)name))
-            return true;
-    }
-    return false;
-}
-static void namelog_out(void *namelog, char *str)
-{
-    namelog_t *n = (namelog_t *)namelog;
     char *p = str;
     int l, l2 = MAX_STRING_CHARS, i;
     const char *scolor;
@@ -2834,6 +3354,47 @@ static void namelog_out(void *namelog, char *str)
         l2 -= l;
     }
 }
+
+/*
+==================
+namelog_list
+
+Like admin_search, for namelogs found by G_namelog_match_*, numbered by
+namelog id so the numbers stay valid when old namelogs are forgotten
+==================
+*/
+static void namelog_list(gentity_t *ent, namelog_t **matches, int found, int start, const char *search, int limit)
+{
+    char str[MAX_STRING_CHARS];
+    int i, first, count = 0, next = 0;
+
+    if (start < 0)
+        first = MAX(found + start, 0);
+    else
+        for (first = 0; first < found && matches[first]->id < start; first++)
+            ;
+    if (first >= found)
+        first = 0;
+
+    ADMBP_begin();
+    for (i = first; i < found && (limit < 1 || count < limit); i++, count++)
+    {
+        namelog_out(matches[i], str);
+        ADMBP(va("%-3d %s\n", matches[i]->id, str));
+    }
+    if (i < found)
+        next = matches[i]->id;
+
+    if (limit > 0)
+    {
+        ADMBP(va("^3namelog: ^7showing %d of %d recent players %d-%d%s%s.", count, found,
+            count ? matches[first]->id : 0, count ? matches[i - 1]->id : 0, *search ? " matching " : "", search));
+        if (next)
+            ADMBP(va("  use 'namelog%s%s %d' to see more", *search ? " " : "", search, next));
+    }
+    ADMBP("\n");
+    ADMBP_end();
+}
 bool G_admin_namelog(gentity_t *ent)
 {
     char search[MAX_NAME_LENGTH] = {""};
@@ -2841,6 +3402,8 @@ bool G_admin_namelog(gentity_t *ent)
     addr_t ip;
     bool ipmatch = false;
     int start = MAX_CLIENTS, i;
+    namelog_t *matches[MAX_NAMELOGS];
+    int found;
 
     if (Cmd_Argc() == 3)
     {
@@ -2860,8 +3423,12 @@ bool G_admin_namelog(gentity_t *ent)
             G_SanitiseString(search, s2, sizeof(s2));
     }
 
-    admin_search(ent, "namelog", "recent players", ipmatch ? namelog_matchip : namelog_matchname, namelog_out,
-        level.namelogs, ipmatch ? (void *)&ip : s2, start, MAX_CLIENTS, MAX_ADMIN_LISTITEMS);
+    if (ipmatch)
+        found = G_namelog_match_addr(&ip, matches, ARRAY_LEN(matches));
+    else
+        found = G_namelog_match_name(s2, matches, ARRAY_LEN(matches));
+
+    namelog_list(ent, matches, found, start, ipmatch ? ip.str : s2, MAX_ADMIN_LISTITEMS);
     return true;
 }
 
@@ -2875,9 +3442,8 @@ Returns NULL if not exactly 1 match
 */
 namelog_t *G_NamelogFromString(gentity_t *ent, char *s)
 {
-    namelog_t *p, *m = NULL;
-    int i, found = 0;
-    char n2[MAX_NAME_LENGTH] = {""};
+    namelog_t *p, *matches[MAX_NAMELOGS];
+    int i, j, found;
     char s2[MAX_NAME_LENGTH] = {""};
 
     if (!s[0])
@@ -2897,13 +3463,7 @@ namelog_t *G_NamelogFromString(gentity_t *ent, char *s)
         }
         else if (i >= MAX_CLIENTS)
         {
-            for (p = level.namelogs; p; p = p->next)
-            {
-                if (p->id == i)
-                    break;
-            }
-            if (p)
-                return p;
+            return G_namelog_find_id(i);
         }
 
         return NULL;
@@ -2912,30 +3472,22 @@ namelog_t *G_NamelogFromString(gentity_t *ent, char *s)
     // check for a name match
     G_SanitiseString(s, s2, sizeof(s2));
 
-    for (p = level.namelogs; p; p = p->next)
-    {
-        for (i = 0; i < MAX_NAMELOG_NAMES && p->name[i][0]; i++)
-        {
-            G_SanitiseString(p->name[i], n2, sizeof(n2));
-
-            // if this is an exact match to a current player
-            if (i == p->nameOffset && p->slot > -1 && !strcmp(s2, n2))
-                return p;
+    found = G_namelog_match_name(s2, matches, ARRAY_LEN(matches));
 
-            if (strstr(n2, s2))
-                m = p;
-        }
+    for (j = 0; j < found; j++)
+    {
+        p = matches[j];
 
-        if (m == p)
-            found++;
+        // if this is an exact match to a current player
+        if (p->slot > -1 && !strcmp(s2, p->cleanName[p->nameOffset]))
+            return p;
     }
 
     if (found == 1)
-        return m;
+        return matches[0];
 
     if (found > 1)
-        admin_search(
-            ent, "namelog", "recent players", namelog_matchname, namelog_out, level.namelogs, s2, 0, MAX_CLIENTS, -1);
+        namelog_list(ent, matches, found, 0, s2, -1);
 
     return NULL;
 }
@@ -3291,6 +3843,7 @@ void G_admin_cleanup(void)
         BG_Free(b);
     }
     g_admin_bans = NULL;
+    admin_ban_index_all();
     for (c = g_admin_commands; c; c = static_cast<g_admin_command_t *>(n))
     {
         n = c->next;
@@ -118,6 +118,11 @@ struct addr_t {
 struct g_admin_ban_t
 {
     g_admin_ban_t *next;
+    g_admin_ban_t *nextGuid;    // ban index chains, only active bans are indexed
+    g_admin_ban_t *nextAddr;
+    g_admin_ban_t *nextExpiry;  // timed bans, soonest expiry first
+    bool indexed;
+    int id;                     // ban# as shown by showbans
     char name[ MAX_NAME_LENGTH ];
     char guid[ 33 ];
     addr_t ip;
@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
 #include "g_local.h"
+#include "g_lua.h"
 
 /*
 ================
@@ -109,6 +110,216 @@ gentity_t *G_CheckSpawnPoint(
 
 #define POWER_REFRESH_TIME 2000
 
+/*
+================
+G_SetParentNode
+
+Set self->parentNode, keeping the parent's list of children and the
+BP they use up to date.  Only buildables are tracked, dummy entities
+used for point queries just get the pointer.
+================
+*/
+void G_SetParentNode(gentity_t *self, gentity_t *node)
+{
+    gentity_t *old = self->parentNode;
+
+    if (old == node)
+        return;
+
+    self->parentNode = node;
+
+    if (old && (self->prevChildNode || old->childNodes == self))
+    {
+        if (self->prevChildNode)
+            self->prevChildNode->nextChildNode = self->nextChildNode;
+        else
+            old->childNodes = self->nextChildNode;
+        if (self->nextChildNode)
+            self->nextChildNode->prevChildNode = self->prevChildNode;
+
+        old->childBuildPoints -= BG_Buildable(self->s.modelindex)->buildPoints;
+        self->nextChildNode = self->prevChildNode = NULL;
+    }
+
+    if (node && self->s.eType == ET_BUILDABLE)
+    {
+        self->nextChildNode = node->childNodes;
+        if (node->childNodes)
+            node->childNodes->prevChildNode = self;
+        node->childNodes = self;
+
+        node->childBuildPoints += BG_Buildable(self->s.modelindex)->buildPoints;
+    }
+}
+
+/*
+================
+G_AddPowerNode
+
+Register a reactor or repeater so power searches only visit power nodes.
+The list is kept in entity number order so ties resolve as they would
+scanning g_entities.
+================
+*/
+static void G_AddPowerNode(gentity_t *self)
+{
+    gentity_t *prev, *next;
+
+    if (self->s.modelindex != BA_H_REACTOR && self->s.modelindex != BA_H_REPEATER)
+        return;
+
+    if (level.powerNodes == self || self->prevPowerNode)
+        return;
+
+    prev = NULL;
+    for (next = level.powerNodes; next && next < self; next = next->nextPowerNode)
+        prev = next;
+
+    self->prevPowerNode = prev;
+    self->nextPowerNode = next;
+    if (prev)
+        prev->nextPowerNode = self;
+    else
+        level.powerNodes = self;
+    if (next)
+        next->prevPowerNode = self;
+}
+
+/*
+================
+G_RemoveFromPowerGraph
+
+Called when a buildable is freed or stops being one, so that nothing
+keeps pointing at it or counting its BP
+================
+*/
+void G_RemoveFromPowerGraph(gentity_t *ent)
+{
+    G_SetParentNode(ent, NULL);
+
+    // orphans find a new parent on their next think
+    while (ent->childNodes)
+        G_SetParentNode(ent->childNodes, NULL);
+
+    if (level.powerNodes == ent || ent->prevPowerNode)
+    {
+        if (ent->prevPowerNode)
+            ent->prevPowerNode->nextPowerNode = ent->nextPowerNode;
+        else
+            level.powerNodes = ent->nextPowerNode;
+        if (ent->nextPowerNode)
+            ent->nextPowerNode->prevPowerNode = ent->prevPowerNode;
+
+        ent->nextPowerNode = ent->prevPowerNode = NULL;
+    }
+}
+
+/*
+================
+G_AddBuildable
+
+Put a newly built buildable on the list for its type, in entity number
+order like a scan of g_entities would find them
+================
+*/
+static void G_AddBuildable(gentity_t *self)
+{
+    gentity_t *prev, *next;
+    buildable_t buildable = self->s.modelindex;
+
+    if (level.buildables[buildable] == self || self->prevBuildable)
+        return;
+
+    prev = NULL;
+    for (next = level.buildables[buildable]; next && next < self; next = next->nextBuildable)
+        prev = next;
+
+    self->prevBuildable = prev;
+    self->nextBuildable = next;
+    if (prev)
+        prev->nextBuildable = self;
+    else
+        level.buildables[buildable] = self;
+    if (next)
+        next->prevBuildable = self;
+
+    level.numBuildables[buildable]++;
+}
+
+/*
+================
+G_RemoveBuildable
+
+Called when a buildable is freed or stops being one
+================
+*/
+void G_RemoveBuildable(gentity_t *ent)
+{
+    buildable_t buildable = ent->s.modelindex;
+
+    if (buildable <= BA_NONE || buildable >= BA_NUM_BUILDABLES)
+        return;
+
+    if (level.buildables[buildable] != ent && !ent->prevBuildable)
+        return;
+
+    if (ent->prevBuildable)
+        ent->prevBuildable->nextBuildable = ent->nextBuildable;
+    else
+        level.buildables[buildable] = ent->nextBuildable;
+    if (ent->nextBuildable)
+        ent->nextBuildable->prevBuildable = ent->prevBuildable;
+
+    ent->nextBuildable = ent->prevBuildable = NULL;
+    level.numBuildables[buildable]--;
+}
+
+/*
+================
+G_IterateBuildables
+
+Returns the buildable after from, or the first one if from is NULL,
+going through level.buildables one type at a time.  Only buildables of
+team are returned, or of every team if it is TEAM_NONE.  Get the next
+one before freeing from.
+================
+*/
+gentity_t *G_IterateBuildables(gentity_t *from, team_t team)
+{
+    int i;
+
+    if (from && from->nextBuildable)
+        return from->nextBuildable;
+
+    for (i = from ? from->s.modelindex + 1 : BA_NONE + 1; i < BA_NUM_BUILDABLES; i++)
+    {
+        if (team != TEAM_NONE && BG_Buildable(i)->team != team)
+            continue;
+
+        if (level.buildables[i])
+            return level.buildables[i];
+    }
+
+    return NULL;
+}
+
+/*
+================
+G_PowerNodeFreeBP
+
+BP a power node has left for self, not counting what self already uses
+================
+*/
+static int G_PowerNodeFreeBP(gentity_t *node, gentity_t *self, int buildPoints)
+{
+    buildPoints -= node->childBuildPoints;
+
+    if (self->parentNode == node && (self->prevChildNode || node->childNodes == self))
+        buildPoints += BG_Buildable(self->s.modelindex)->buildPoints;
+
+    return buildPoints;
+}
+
 /*
 ================
 G_FindPower
@@ -118,8 +329,7 @@ attempt to find power for self, return true if successful
 */
 bool G_FindPower(gentity_t *self, bool searchUnspawned)
 {
-    int i, j;
-    gentity_t *ent, *ent2;
+    gentity_t *ent;
     gentity_t *closestPower = NULL;
     int distance = 0;
     int minDistance = REPEATER_BASESIZE + 1;
@@ -131,7 +341,7 @@ bool G_FindPower(gentity_t *self, bool searchUnspawned)
     // Reactor is always powered
     if (self->s.modelindex == BA_H_REACTOR)
     {
-        self->parentNode = self;
+        G_SetParentNode(self, self);
 
         return true;
     }
@@ -139,20 +349,16 @@ bool G_FindPower(gentity_t *self, bool searchUnspawned)
     // Handle repeaters
     if (self->s.modelindex == BA_H_REPEATER)
     {
-        self->parentNode = G_Reactor();
+        G_SetParentNode(self, G_Reactor());
 
         return self->parentNode != NULL;
     }
 
-    // Iterate through entities
-    for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+    // Iterate through power nodes
+    for (ent = level.powerNodes; ent; ent = ent->nextPowerNode)
     {
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-
         // If entity is a power item calculate the distance to it
-        if ((ent->s.modelindex == BA_H_REACTOR || ent->s.modelindex == BA_H_REPEATER) &&
-            (searchUnspawned || ent->spawned) && ent->powered && ent->health > 0)
+        if ((searchUnspawned || ent->spawned) && ent->powered && ent->health > 0)
         {
             VectorSubtract(self->r.currentOrigin, ent->r.currentOrigin, temp_v);
             distance = VectorLength(temp_v);
@@ -163,22 +369,7 @@ bool G_FindPower(gentity_t *self, bool searchUnspawned)
                 // Only power as much BP as the reactor can hold
                 if (self->s.modelindex != BA_NONE)
                 {
-                    int buildPoints = g_humanBuildPoints.integer;
-
-                    // Scan the buildables in the reactor zone
-                    for (j = MAX_CLIENTS, ent2 = g_entities + j; j < level.num_entities; j++, ent2++)
-                    {
-                        if (ent2->s.eType != ET_BUILDABLE)
-                            continue;
-
-                        if (ent2 == self)
-                            continue;
-
-                        if (ent2->parentNode == ent)
-                        {
-                            buildPoints -= BG_Buildable(ent2->s.modelindex)->buildPoints;
-                        }
-                    }
+                    int buildPoints = G_PowerNodeFreeBP(ent, self, g_humanBuildPoints.integer);
 
                     buildPoints -= level.humanBuildPointQueue;
 
@@ -186,7 +377,7 @@ bool G_FindPower(gentity_t *self, bool searchUnspawned)
 
                     if (buildPoints >= 0)
                     {
-                        self->parentNode = ent;
+                        G_SetParentNode(self, ent);
                         return true;
                     }
                     else
@@ -200,7 +391,7 @@ bool G_FindPower(gentity_t *self, bool searchUnspawned)
                 // Dummy buildables don't need to look for zones
                 else
                 {
-                    self->parentNode = ent;
+                    G_SetParentNode(self, ent);
                     return true;
                 }
             }
@@ -211,20 +402,7 @@ bool G_FindPower(gentity_t *self, bool searchUnspawned)
 
                 if (self->s.modelindex != BA_NONE)
                 {
-                    int buildPoints = g_humanRepeaterBuildPoints.integer;
-
-                    // Scan the buildables in the repeater zone
-                    for (j = MAX_CLIENTS, ent2 = g_entities + j; j < level.num_entities; j++, ent2++)
-                    {
-                        if (ent2->s.eType != ET_BUILDABLE)
-                            continue;
-
-                        if (ent2 == self)
-                            continue;
-
-                        if (ent2->parentNode == ent)
-                            buildPoints -= BG_Buildable(ent2->s.modelindex)->buildPoints;
-                    }
+                    int buildPoints = G_PowerNodeFreeBP(ent, self, g_humanRepeaterBuildPoints.integer);
 
                     if (ent->usesBuildPointZone && level.buildPointZones[ent->buildPointZone].active)
                         buildPoints -= level.buildPointZones[ent->buildPointZone].queuedBuildPoints;
@@ -253,7 +431,7 @@ bool G_FindPower(gentity_t *self, bool searchUnspawned)
         }
     }
 
-    self->parentNode = closestPower;
+    G_SetParentNode(self, closestPower);
     return self->parentNode != NULL;
 }
 
@@ -361,7 +539,7 @@ Get the number of marked build points from a position
 int G_GetMarkedBuildPoints(const vec3_t pos, team_t team)
 {
     gentity_t *ent;
-    int i;
+    gentity_t *powerPoint = NULL;
     int sum = 0;
 
     if (G_TimeTilSuddenDeath() <= 0)
@@ -370,16 +548,13 @@ int G_GetMarkedBuildPoints(const vec3_t pos, team_t team)
     if (!g_markDeconstruct.integer)
         return 0;
 
-    for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
-    {
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
+    if (team == TEAM_HUMANS)
+        powerPoint = G_PowerEntityForPoint(pos);
 
+    for (ent = G_IterateBuildables(NULL, team); ent; ent = G_IterateBuildables(ent, team))
+    {
         if (team == TEAM_HUMANS && ent->s.modelindex != BA_H_REACTOR && ent->s.modelindex != BA_H_REPEATER &&
-            ent->parentNode != G_PowerEntityForPoint(pos))
-            continue;
-
-        if (!ent->inuse)
+            ent->parentNode != powerPoint)
             continue;
 
         if (ent->health <= 0)
@@ -408,14 +583,10 @@ providers will find themselves.
 */
 gentity_t *G_InPowerZone(gentity_t *self)
 {
-    int i;
     gentity_t *ent;
 
-    for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+    for (ent = level.powerNodes; ent; ent = ent->nextPowerNode)
     {
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-
         if (ent == self)
             continue;
 
@@ -426,7 +597,7 @@ gentity_t *G_InPowerZone(gentity_t *self)
             continue;
 
         // if entity is a power item calculate the distance to it
-        if ((ent->s.modelindex == BA_H_REACTOR || ent->s.modelindex == BA_H_REPEATER) && ent->spawned && ent->powered)
+        if (ent->powered)
         {
             vec3_t temp_v;
             VectorSubtract(self->r.currentOrigin, ent->r.currentOrigin, temp_v);
@@ -451,21 +622,17 @@ attempt to find a controlling DCC for self, return number found
 */
 int G_FindDCC(gentity_t *self)
 {
-    int i;
     gentity_t *ent;
     int foundDCC = 0;
 
     if (self->buildableTeam != TEAM_HUMANS)
         return 0;
 
-    // iterate through entities
-    for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+    // iterate through the dccs
+    for (ent = level.buildables[BA_H_DCC]; ent; ent = ent->nextBuildable)
     {
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-
-        // if entity is a dcc calculate the distance to it
-        if (ent->s.modelindex == BA_H_DCC && ent->spawned)
+        // calculate the distance to it
+        if (ent->spawned)
         {
             vec3_t temp_v;
             VectorSubtract(self->r.currentOrigin, ent->r.currentOrigin, temp_v);
@@ -489,17 +656,10 @@ See if any powered DCC exists
 */
 bool G_IsDCCBuilt(void)
 {
-    int i;
     gentity_t *ent;
 
-    for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+    for (ent = level.buildables[BA_H_DCC]; ent; ent = ent->nextBuildable)
     {
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-
-        if (ent->s.modelindex != BA_H_DCC)
-            continue;
-
         if (!ent->spawned)
             continue;
 
@@ -556,6 +716,78 @@ gentity_t *G_Overmind(void)
     return NULL;
 }
 
+/*
+================
+G_CreepBucket
+
+Creep sources are hashed on a 2D grid of cells a bit larger than the creep
+radius, so everything in range of a point is in the 3x3 cells around it
+even if a source has drifted slightly since it was last linked
+================
+*/
+#define CREEP_GRID_CELL (CREEP_BASESIZE + 64)
+
+static int G_CreepBucket(int cx, int cy)
+{
+    return (((unsigned)cx * 73856093u) ^ ((unsigned)cy * 19349663u)) & (CREEP_GRID_BUCKETS - 1);
+}
+
+static int G_CreepCell(float v)
+{
+    return (int)floor(v / CREEP_GRID_CELL);
+}
+
+/*
+================
+G_RemoveCreepSource
+================
+*/
+void G_RemoveCreepSource(gentity_t *ent)
+{
+    if (level.creepSources[ent->creepBucket] != ent && !ent->prevCreepSource)
+        return;
+
+    if (ent->prevCreepSource)
+        ent->prevCreepSource->nextCreepSource = ent->nextCreepSource;
+    else
+        level.creepSources[ent->creepBucket] = ent->nextCreepSource;
+    if (ent->nextCreepSource)
+        ent->nextCreepSource->prevCreepSource = ent->prevCreepSource;
+
+    ent->nextCreepSource = ent->prevCreepSource = NULL;
+}
+
+/*
+================
+G_UpdateCreepSource
+
+Put alien spawns and overminds in the grid cell of their current origin
+================
+*/
+void G_UpdateCreepSource(gentity_t *ent)
+{
+    int bucket;
+
+    if (ent->s.eType != ET_BUILDABLE || (ent->s.modelindex != BA_A_SPAWN && ent->s.modelindex != BA_A_OVERMIND))
+        return;
+
+    bucket = G_CreepBucket(G_CreepCell(ent->r.currentOrigin[0]), G_CreepCell(ent->r.currentOrigin[1]));
+
+    if (level.creepSources[ent->creepBucket] == ent || ent->prevCreepSource)
+    {
+        if (ent->creepBucket == bucket)
+            return;
+
+        G_RemoveCreepSource(ent);
+    }
+
+    ent->creepBucket = bucket;
+    ent->nextCreepSource = level.creepSources[bucket];
+    if (level.creepSources[bucket])
+        level.creepSources[bucket]->prevCreepSource = ent;
+    level.creepSources[bucket] = ent;
+}
+
 /*
 ================
 G_FindCreep
@@ -565,7 +797,8 @@ attempt to find creep for self, return true if successful
 */
 bool G_FindCreep(gentity_t *self)
 {
-    int i;
+    int x, y, cx, cy;
+    int buckets[9], numBuckets, i;
     gentity_t *ent;
     gentity_t *closestSpawn = NULL;
     int minDistance = 10000;
@@ -577,21 +810,47 @@ bool G_FindCreep(gentity_t *self)
     // if self does not have a parentNode or its parentNode is invalid, then find a new one
     if (self->client || self->parentNode == NULL || !self->parentNode->inuse || self->parentNode->health <= 0)
     {
-        for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+        cx = G_CreepCell(self->r.currentOrigin[0]);
+        cy = G_CreepCell(self->r.currentOrigin[1]);
+
+        // neighbouring cells may hash to the same bucket, only visit each once
+        numBuckets = 0;
+        for (x = cx - 1; x <= cx + 1; x++)
         {
-            if (ent->s.eType != ET_BUILDABLE)
-                continue;
+            for (y = cy - 1; y <= cy + 1; y++)
+            {
+                int bucket = G_CreepBucket(x, y);
 
-            if ((ent->s.modelindex == BA_A_SPAWN || ent->s.modelindex == BA_A_OVERMIND) && ent->spawned &&
-                ent->health > 0)
+                for (i = 0; i < numBuckets; i++)
+                {
+                    if (buckets[i] == bucket)
+                        break;
+                }
+
+                if (i == numBuckets)
+                    buckets[numBuckets++] = bucket;
+            }
+        }
+
+        for (i = 0; i < numBuckets; i++)
+        {
+            for (ent = level.creepSources[buckets[i]]; ent; ent = ent->nextCreepSource)
             {
-                vec3_t temp_v;
-                VectorSubtract(self->r.currentOrigin, ent->r.currentOrigin, temp_v);
-                int distance = VectorLength(temp_v);
-                if (distance < minDistance)
+                if (ent->s.eType != ET_BUILDABLE)
+                    continue;
+
+                if (ent->spawned && ent->health > 0)
                 {
-                    closestSpawn = ent;
-                    minDistance = distance;
+                    vec3_t temp_v;
+                    VectorSubtract(self->r.currentOrigin, ent->r.currentOrigin, temp_v);
+                    int distance = VectorLength(temp_v);
+
+                    // on a tie prefer the lower entity number like a g_entities scan would
+                    if (distance < minDistance || (distance == minDistance && ent < closestSpawn))
+                    {
+                        closestSpawn = ent;
+                        minDistance = distance;
+                    }
                 }
             }
         }
@@ -599,7 +858,7 @@ bool G_FindCreep(gentity_t *self)
         if (minDistance <= CREEP_BASESIZE)
         {
             if (!self->client)
-                self->parentNode = closestSpawn;
+                G_SetParentNode(self, closestSpawn);
             return true;
         }
         else
@@ -1399,14 +1658,22 @@ Used by ATrapper_Think to locate enemy gentities
 void ATrapper_FindEnemy(gentity_t *ent, int range)
 {
     gentity_t *target;
-    int i;
+    gentity_t *list[MAX_CLIENTS];
+    int i, num;
     int start;
 
-    // iterate through entities
-    start = rand() / (RAND_MAX / level.num_entities + 1);
-    for (i = start; i < level.num_entities + start; i++)
+    num = G_EntitiesInRadius(ent->r.currentOrigin, range, ET_PLAYER, (team_t)-1, list, MAX_CLIENTS);
+    if (!num)
     {
-        target = g_entities + (i % level.num_entities);
+        ent->enemy = NULL;
+        return;
+    }
+
+    // iterate through the players in range
+    start = rand() / (RAND_MAX / num + 1);
+    for (i = start; i < num + start; i++)
+    {
+        target = list[i % num];
         // if target is not valid keep searching
         if (!ATrapper_CheckTarget(ent, target, range))
             continue;
@@ -1550,6 +1817,8 @@ void HSpawn_Blast(gentity_t *self)
     G_QueueBuildPoints(self);
     G_RewardAttackers(self);
     // turn into an explosion
+    G_RemoveFromPowerGraph(self);
+    G_RemoveBuildable(self);
     self->s.eType = ET_EVENTS + EV_HUMAN_BUILDABLE_EXPLOSION;
     self->freeAfterEvent = true;
     G_AddEvent(self, EV_HUMAN_BUILDABLE_EXPLOSION, DirToByte(dir));
@@ -2503,15 +2772,18 @@ void G_BuildableTouchTriggers(gentity_t *ent)
     VectorSubtract(mins, range, mins);
     VectorAdd(maxs, range, maxs);
 
-    int touch[MAX_GENTITIES];
-    int num = SV_AreaEntities(mins, maxs, touch, MAX_GENTITIES);
+    gentity_t *touch[MAX_GENTITIES];
+    int num = G_TriggersInBox(mins, maxs, touch, MAX_GENTITIES);
 
     VectorAdd(ent->r.currentOrigin, bmins, mins);
     VectorAdd(ent->r.currentOrigin, bmaxs, maxs);
 
     for (int i = 0; i < num; i++)
     {
-        gentity_t *hit = &g_entities[touch[i]];
+        gentity_t *hit = touch[i];
+
+        if (!hit->inuse || !hit->r.linked)
+            continue;
 
         if (!hit->touch)
             continue;
@@ -2668,15 +2940,11 @@ Finds a buildable of the specified type
 */
 static gentity_t *G_FindBuildable(buildable_t buildable)
 {
-    int i;
     gentity_t *ent;
 
-    for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+    for (ent = level.buildables[buildable]; ent; ent = ent->nextBuildable)
     {
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-
-        if (ent->s.modelindex == buildable && !(ent->s.eFlags & EF_DEAD))
+        if (!(ent->s.eFlags & EF_DEAD))
             return ent;
     }
 
@@ -2810,17 +3078,10 @@ Remove decon mark from all buildables
 */
 void G_ClearDeconMarks(void)
 {
-    int i;
     gentity_t *ent;
 
-    for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+    for (ent = G_IterateBuildables(NULL, TEAM_NONE); ent; ent = G_IterateBuildables(ent, TEAM_NONE))
     {
-        if (!ent->inuse)
-            continue;
-
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-
         ent->deconstruct = false;
     }
 }
@@ -2902,6 +3163,7 @@ static itemBuildError_t G_SufficientBPAvailable(buildable_t buildable, vec3_t or
     int numRequired = 0;
     int pointsYielded = 0;
     gentity_t *ent;
+    gentity_t *powerPoint = NULL;
     team_t team = BG_Buildable(buildable)->team;
     int buildPoints = BG_Buildable(buildable)->buildPoints;
     int remainingBP, remainingSpawns;
@@ -2914,6 +3176,9 @@ static itemBuildError_t G_SufficientBPAvailable(buildable_t buildable, vec3_t or
     buildable_t core;
     int spawnCount = 0;
     bool changed = true;
+    gentity_t *list[MAX_GENTITIES];
+    vec3_t mins, maxs;
+    int num;
 
     level.numBuildablesForRemoval = 0;
 
@@ -2950,10 +3215,14 @@ static itemBuildError_t G_SufficientBPAvailable(buildable_t buildable, vec3_t or
             return bpError;
 
         // Check for buildable<->buildable collisions
-        for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+        BG_BuildableBoundingBox(buildable, mins, maxs);
+        VectorAdd(mins, origin, mins);
+        VectorAdd(maxs, origin, maxs);
+
+        num = G_EntitiesInBox(mins, maxs, ET_BUILDABLE, (team_t)-1, list, MAX_GENTITIES);
+        for (i = 0; i < num; i++)
         {
-            if (ent->s.eType != ET_BUILDABLE)
-                continue;
+            ent = list[i];
 
             if (G_BuildablesIntersect(buildable, origin, ent->s.modelindex, ent->r.currentOrigin))
                 return IBE_NOROOM;
@@ -2965,12 +3234,12 @@ static itemBuildError_t G_SufficientBPAvailable(buildable_t buildable, vec3_t or
     // Set buildPoints to the number extra that are required
     buildPoints -= remainingBP;
 
+    if (team == TEAM_HUMANS)
+        powerPoint = G_PowerEntityForPoint(origin);
+
     // Build a list of buildable entities
-    for (i = MAX_CLIENTS, ent = g_entities + i; i < level.num_entities; i++, ent++)
+    for (ent = G_IterateBuildables(NULL, TEAM_NONE); ent; ent = G_IterateBuildables(ent, TEAM_NONE))
     {
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-
         collision = G_BuildablesIntersect(buildable, origin, ent->s.modelindex, ent->r.currentOrigin);
 
         if (collision)
@@ -3001,7 +3270,7 @@ static itemBuildError_t G_SufficientBPAvailable(buildable_t buildable, vec3_t or
         // Don't allow marked buildables to be replaced in another zone,
         // unless the marked buildable isn't in a zone (and thus unpowered)
         if (team == TEAM_HUMANS && buildable != BA_H_REACTOR && buildable != BA_H_REPEATER &&
-            ent->parentNode != G_PowerEntityForPoint(origin))
+            ent->parentNode != powerPoint)
             continue;
 
         if (!ent->inuse)
@@ -3019,7 +3288,7 @@ static itemBuildError_t G_SufficientBPAvailable(buildable_t buildable, vec3_t or
             continue;
 
         // Don't allow a power source to be replaced by a dependant
-        if (team == TEAM_HUMANS && G_PowerEntityForPoint(origin) == ent && buildable != BA_H_REPEATER &&
+        if (team == TEAM_HUMANS && powerPoint == ent && buildable != BA_H_REPEATER &&
             buildable != core)
             continue;
 
@@ -3135,14 +3404,10 @@ Links or unlinks all the buildable entities
 */
 static void G_SetBuildableLinkState(bool link)
 {
-    int i;
     gentity_t *ent;
 
-    for (i = 1, ent = g_entities + i; i < level.num_entities; i++, ent++)
+    for (ent = G_IterateBuildables(NULL, TEAM_NONE); ent; ent = G_IterateBuildables(ent, TEAM_NONE))
     {
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-
         if (link)
             G_LinkEntity(ent);
         else
@@ -3402,6 +3667,8 @@ static gentity_t *G_Build(gentity_t *builder, buildable_t buildable, const vec3_
     built->killedBy = ENTITYNUM_NONE;
     built->classname = BG_Buildable(buildable)->entityName;
     built->s.modelindex = buildable;
+    G_AddBuildable(built);
+    G_AddPowerNode(built);
     built->buildableTeam = built->s.modelindex2 = BG_Buildable(buildable)->team;
     BG_BuildableBoundingBox(buildable, built->r.mins, built->r.maxs);
 
@@ -3598,6 +3865,9 @@ static gentity_t *G_Build(gentity_t *builder, buildable_t buildable, const vec3_
 
     G_AddRangeMarkerForBuildable(built);
 
+    if (luaHookCount[LUA_HOOK_BUILD])
+        LuaHook_Build(built, builder);
+
     return built;
 }
 
@@ -3839,6 +4109,22 @@ void G_ParseCSVBuildablePlusList(const char *string, int *buildables, int builda
     buildables[i] = BA_NONE;
 }
 
+/*
+============
+G_LayoutSaveEntity
+============
+*/
+static void G_LayoutSaveEntity(fileHandle_t f, const char *name, gentity_t *ent)
+{
+    const char *s;
+
+    s = va("%s %f %f %f %f %f %f %f %f %f %f %f %f\n", name, ent->r.currentOrigin[0], ent->r.currentOrigin[1],
+        ent->r.currentOrigin[2], ent->r.currentAngles[0], ent->r.currentAngles[1], ent->r.currentAngles[2],
+        ent->s.origin2[0], ent->s.origin2[1], ent->s.origin2[2], ent->s.angles2[0], ent->s.angles2[1],
+        ent->s.angles2[2]);
+    FS_Write(s, strlen(s), f);
+}
+
 /*
 ============
 G_LayoutSave
@@ -3854,7 +4140,6 @@ void G_LayoutSave(char *lstr)
     int len;
     int i;
     gentity_t *ent;
-    const char *s;
 
     Cvar_VariableStringBuffer("mapname", map, sizeof(map));
     if (!map[0])
@@ -3888,43 +4173,28 @@ void G_LayoutSave(char *lstr)
 
     G_Printf("layoutsave: saving layout to %s\n", fileName);
 
-    for (i = MAX_CLIENTS; i < level.num_entities; i++)
+    for (ent = G_IterateBuildables(NULL, TEAM_NONE); ent; ent = G_IterateBuildables(ent, TEAM_NONE))
     {
-        const char *name;
+        if (!bAllowed[BA_NONE] && !bAllowed[ent->s.modelindex])
+            continue;
 
-        ent = &level.gentities[i];
-        if (ent->s.eType == ET_BUILDABLE)
-        {
-            if (!bAllowed[BA_NONE] && !bAllowed[ent->s.modelindex])
-                continue;
-            name = BG_Buildable(ent->s.modelindex)->name;
-        }
-        else if (ent->count == 1 && !strcmp(ent->classname, "info_player_intermission"))
-        {
-            if (!bAllowed[BA_NONE] && !bAllowed[BA_NUM_BUILDABLES + TEAM_NONE])
-                continue;
-            name = "ivo_spectator";
-        }
-        else if (ent->count == 1 && !strcmp(ent->classname, "info_alien_intermission"))
-        {
-            if (!bAllowed[BA_NONE] && !bAllowed[BA_NUM_BUILDABLES + TEAM_ALIENS])
-                continue;
-            name = "ivo_alien";
-        }
-        else if (ent->count == 1 && !strcmp(ent->classname, "info_human_intermission"))
-        {
-            if (!bAllowed[BA_NONE] && !bAllowed[BA_NUM_BUILDABLES + TEAM_HUMANS])
-                continue;
-            name = "ivo_human";
-        }
-        else
+        G_LayoutSaveEntity(f, BG_Buildable(ent->s.modelindex)->name, ent);
+    }
+
+    for (i = 0; i < NUM_TEAMS; i++)
+    {
+        static const char *const classnames[NUM_TEAMS] = {
+            "info_player_intermission", "info_alien_intermission", "info_human_intermission"};
+        static const char *const names[NUM_TEAMS] = {"ivo_spectator", "ivo_alien", "ivo_human"};
+
+        if (!bAllowed[BA_NONE] && !bAllowed[BA_NUM_BUILDABLES + i])
             continue;
 
-        s = va("%s %f %f %f %f %f %f %f %f %f %f %f %f\n", name, ent->r.currentOrigin[0], ent->r.currentOrigin[1],
-            ent->r.currentOrigin[2], ent->r.currentAngles[0], ent->r.currentAngles[1], ent->r.currentAngles[2],
-            ent->s.origin2[0], ent->s.origin2[1], ent->s.origin2[2], ent->s.angles2[0], ent->s.angles2[1],
-            ent->s.angles2[2]);
-        FS_Write(s, strlen(s), f);
+        for (ent = NULL; (ent = G_Find(ent, FOFS(classname), classnames[i]));)
+        {
+            if (ent->count == 1)
+                G_LayoutSaveEntity(f, names[i], ent);
+        }
     }
     FS_FCloseFile(f);
 }
@@ -4208,18 +4478,13 @@ G_BaseSelfDestruct
 */
 void G_BaseSelfDestruct(team_t team)
 {
-    int i;
-    gentity_t *ent;
+    gentity_t *ent, *next;
 
-    for (i = MAX_CLIENTS; i < level.num_entities; i++)
+    for (ent = G_IterateBuildables(NULL, team); ent; ent = next)
     {
-        ent = &level.gentities[i];
+        next = G_IterateBuildables(ent, team);
         if (ent->health <= 0)
             continue;
-        if (ent->s.eType != ET_BUILDABLE)
-            continue;
-        if (ent->buildableTeam != team)
-            continue;
         G_Damage(ent, NULL, NULL, NULL, NULL, 10000, 0, MOD_SUICIDE);
     }
 }
@@ -4404,9 +4669,9 @@ void G_UpdateBuildableRangeMarkers(void)
     bool maskingExtension = (Cvar_VariableIntegerValue("sv_gppExtension") >= 1);
 
     gentity_t *e;
-    for (e = &g_entities[MAX_CLIENTS]; e < &g_entities[level.num_entities]; ++e)
+    for (e = G_IterateBuildables(NULL, TEAM_NONE); e; e = G_IterateBuildables(e, TEAM_NONE))
     {
-        if (e->s.eType != ET_BUILDABLE || !e->rangeMarker)
+        if (!e->rangeMarker)
             continue;
 
         buildable_t bType = e->s.modelindex;
@@ -4444,9 +4709,9 @@ void G_UpdateBuildableRangeMarkers(void)
                     Cvar_Set("g_rangeMarkerWarningGiven", "1");
                 }
 
-                for (e = &g_entities[MAX_CLIENTS]; e < &g_entities[level.num_entities]; ++e)
+                for (e = G_IterateBuildables(NULL, TEAM_NONE); e; e = G_IterateBuildables(e, TEAM_NONE))
                 {
-                    if (e->s.eType == ET_BUILDABLE && e->rangeMarker)
+                    if (e->rangeMarker)
                         e->rangeMarker->r.svFlags |= SVF_NOCLIENT;
                 }
 
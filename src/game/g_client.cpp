@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
 #include "g_local.h"
+#include "g_lua.h"
 #include "g_spawn.h"
 
 // g_client.c -- client functions that don't happen every frame
@@ -1516,7 +1517,8 @@ void ClientSpawn(gentity_t *ent, gentity_t *spawn, const vec3_t origin, const ve
 
     client->pers.infoChangeTime = level.time;
 
-	//LuaHook_ClientSpawn(ent - g_entities);
+    if (luaHookCount[LUA_HOOK_CLIENTSPAWN])
+        LuaHook_ClientSpawn(ent);
 }
 
 /*
@@ -222,28 +222,35 @@ int G_ClientNumbersFromString(char *s, int *plist, int max)
 
 /*
 ==================
-ScoreboardMessage
+G_BuildScoreboards
 
+Formats the score table once for each viewing team.  Players only see the
+weapon and upgrade of their own team, spectators see everyone's.
 ==================
 */
-void ScoreboardMessage(gentity_t *ent)
+static void G_BuildScoreboards(void)
 {
-    char entry[1024];
-    char string[1400];
-    int stringlength;
-    int i, j;
+    char entry[64];
+    char items[32];
+    char hidden[32];
+    int header[NUM_TEAMS];
+    int length[NUM_TEAMS];
+    bool full[NUM_TEAMS];
+    int i, j, t;
     gclient_t *cl;
-    int numSorted;
-    int weapon = WP_NONE;
-    upgrade_t upgrade = UP_NONE;
+    int weapon;
+    upgrade_t upgrade;
 
-    // send the latest information on all clients
-    string[0] = 0;
-    stringlength = 0;
+    Com_sprintf(hidden, sizeof(hidden), " %d %d", WP_NONE, UP_NONE);
 
-    numSorted = level.numConnectedClients;
+    for (t = 0; t < NUM_TEAMS; t++)
+    {
+        header[t] = length[t] = Com_sprintf(level.scoreboard[t], MAX_SCOREBOARD_STRING, "scores %i %i",
+            level.alienKills, level.humanKills);
+        full[t] = false;
+    }
 
-    for (i = 0; i < numSorted; i++)
+    for (i = 0; i < level.numConnectedClients; i++)
     {
         int ping;
 
@@ -254,8 +261,13 @@ void ScoreboardMessage(gentity_t *ent)
         else
             ping = cl->ps.ping < 999 ? cl->ps.ping : 999;
 
-        if (cl->sess.spectatorState == SPECTATOR_NOT &&
-            (ent->client->pers.teamSelection == TEAM_NONE || cl->pers.teamSelection == ent->client->pers.teamSelection))
+        j = Com_sprintf(entry, sizeof(entry), " %d %d %d %d", level.sortedClients[i], cl->ps.persistant[PERS_SCORE],
+            ping, (level.time - cl->pers.enterTime) / 60000);
+
+        weapon = WP_NONE;
+        upgrade = UP_NONE;
+
+        if (cl->sess.spectatorState == SPECTATOR_NOT)
         {
             weapon = cl->ps.weapon;
 
@@ -269,28 +281,53 @@ void ScoreboardMessage(gentity_t *ent)
                 upgrade = UP_HELMET;
             else if (BG_InventoryContainsUpgrade(UP_LIGHTARMOUR, cl->ps.stats))
                 upgrade = UP_LIGHTARMOUR;
-            else
-                upgrade = UP_NONE;
         }
-        else
+
+        Com_sprintf(items, sizeof(items), " %d %d", weapon, upgrade);
+
+        for (t = 0; t < NUM_TEAMS; t++)
         {
-            weapon = WP_NONE;
-            upgrade = UP_NONE;
-        }
+            const char *shown = items;
+            int k;
 
-        Com_sprintf(entry, sizeof(entry), " %d %d %d %d %d %d", level.sortedClients[i], cl->ps.persistant[PERS_SCORE],
-            ping, (level.time - cl->pers.enterTime) / 60000, weapon, upgrade);
+            if (full[t])
+                continue;
 
-        j = strlen(entry);
+            if (t != TEAM_NONE && cl->pers.teamSelection != t)
+                shown = hidden;
 
-        if (stringlength + j >= sizeof(string))
-            break;
+            k = strlen(shown);
 
-        strcpy(string + stringlength, entry);
-        stringlength += j;
+            if (length[t] - header[t] + j + k >= 1400)
+            {
+                full[t] = true;
+                continue;
+            }
+
+            memcpy(level.scoreboard[t] + length[t], entry, j);
+            memcpy(level.scoreboard[t] + length[t] + j, shown, k + 1);
+            length[t] += j + k;
+        }
     }
 
-    SV_GameSendServerCommand(ent - g_entities, va("scores %i %i%s", level.alienKills, level.humanKills, string));
+    level.scoreboardDirty = false;
+    level.scoreboardTime = level.time;
+}
+
+/*
+==================
+ScoreboardMessage
+
+Sends the score table for the client's team, rebuilding it only when
+ranks changed or it has gone stale
+==================
+*/
+void ScoreboardMessage(gentity_t *ent)
+{
+    if (level.scoreboardDirty || level.time - level.scoreboardTime >= SCOREBOARD_REBUILD_TIME)
+        G_BuildScoreboards();
+
+    SV_GameSendServerCommand(ent - g_entities, level.scoreboard[ent->client->pers.teamSelection]);
 }
 
 /*
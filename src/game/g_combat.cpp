@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
 #include "g_local.h"
+#include "g_lua.h"
 
 damageRegion_t g_damageRegions[PCL_NUM_CLASSES][MAX_DAMAGE_REGIONS];
 int g_numDamageRegions[PCL_NUM_CLASSES];
@@ -689,8 +690,8 @@ static float G_CalcDamageModifier(vec3_t point, gentity_t *targ, gentity_t *atta
         return GetNonLocDamageModifier(targ, klass);
 
     // Get the point location relative to the floor under the target
-    if (g_unlagged.integer && targ->client && targ->client->unlaggedCalc.used)
-        VectorCopy(targ->client->unlaggedCalc.origin, targOrigin);
+    if (g_unlagged.integer && targ->client && level.unlaggedCalc.used[targ->s.number])
+        VectorCopy(level.unlaggedCalc.origin[targ->s.number], targOrigin);
     else
         VectorCopy(targ->r.currentOrigin, targOrigin);
 
@@ -867,6 +868,9 @@ void G_Damage(gentity_t *targ, gentity_t *inflictor, gentity_t *attacker, vec3_t
     if (client && client->noclip)
         return;
 
+    if (luaHookCount[LUA_HOOK_DAMAGE])
+        LuaHook_Damage(targ, inflictor, attacker, damage, mod);
+
     if (!dir)
         dflags |= DAMAGE_NO_KNOCKBACK;
     else
@@ -199,7 +199,25 @@ struct gentity_t {
     stage_t stageStage;
 
     team_t buildableTeam;  // buildable item team
-    gentity_t *parentNode;  // for creep and defence/spawn dependencies
+    gentity_t *parentNode;  // for creep and defence/spawn dependencies, set with G_SetParentNode
+    gentity_t *childNodes;  // buildables that have this one as their parentNode
+    gentity_t *nextChildNode;  // siblings in parentNode->childNodes
+    gentity_t *prevChildNode;
+    int childBuildPoints;  // total BP of childNodes
+    gentity_t *nextBuildable;  // level.buildables[ s.modelindex ]
+    gentity_t *prevBuildable;
+    gentity_t *nextPowerNode;  // level.powerNodes
+    gentity_t *prevPowerNode;
+    gentity_t *nextCreepSource;  // level.creepSources[ creepBucket ]
+    gentity_t *prevCreepSource;
+    int creepBucket;
+    gentity_t *nextInGrid;  // level.entityGrid[ gridBucket ]
+    gentity_t *prevInGrid;
+    int gridBucket;
+    int gridCell[2];
+    gentity_t *nextTrigger;  // level.triggers
+    gentity_t *prevTrigger;
+    vec3_t triggerAbsmin, triggerAbsmax;  // absmin/absmax when last linked
     gentity_t *rangeMarker;
     bool active;  // for power repeater, but could be useful elsewhere
     bool powered;  // for human buildables
@@ -278,9 +296,23 @@ typedef struct {
 // namelog
 #define MAX_NAMELOG_NAMES 5
 #define MAX_NAMELOG_ADDRS 5
+#define MAX_NAMELOGS 256  // past this the least recently seen player is forgotten
+#define NAMELOG_NAME_BITS 128  // size of the trigram signature of a player's names
+
+// links one of a namelog's addresses into the address index
+struct namelogAddr_t {
+    namelog_t *namelog;
+    namelogAddr_t *next;
+};
+
 struct namelog_t {
     namelog_t *next;
+    namelog_t *nextGuid;  // guid index chain
+    namelog_t *lruPrev, *lruNext;  // most recently connected first
+    namelogAddr_t addrLink[MAX_NAMELOG_ADDRS];
     char name[MAX_NAMELOG_NAMES][MAX_NAME_LENGTH];
+    char cleanName[MAX_NAMELOG_NAMES][MAX_NAME_LENGTH];  // G_SanitiseString of name
+    unsigned nameBits[NAMELOG_NAME_BITS / 32];  // trigrams of cleanName
     addr_t ip[MAX_NAMELOG_ADDRS];
     char guid[33];
     bool guidless;
@@ -352,6 +384,9 @@ struct clientPersistant_t {
     int infoChangeTime;
 };
 
+#define MAX_THINK_BATCH 32  // most commands taken from one GAME_CLIENT_THINK_BATCH
+#define MAX_CACHED_TRIGGERS 32
+#define TRIGGER_CELL 64  // size of the cells G_TouchTriggers caches triggers for
 #define MAX_UNLAGGED_MARKERS 256
 struct unlagged_t {
     vec3_t origin;
@@ -360,6 +395,16 @@ struct unlagged_t {
     bool used;
 };
 
+// every client's position at one time, one array per field so whole
+// frames can be interpolated in a single pass
+struct unlaggedFrame_t {
+    int time;
+    vec3_t origin[MAX_CLIENTS];
+    vec3_t mins[MAX_CLIENTS];
+    vec3_t maxs[MAX_CLIENTS];
+    bool used[MAX_CLIENTS];
+};
+
 #define MAX_TRAMPLE_BUILDABLES_TRACKED 20
 // this structure is cleared on each ClientSpawn(),
 // except for 'client->pers' and 'client->sess'
@@ -438,11 +483,20 @@ struct gclient_t {
 
     int lastFlameBall;  // s.number of the last flame ball fired
 
-    unlagged_t unlaggedHist[MAX_UNLAGGED_MARKERS];
     unlagged_t unlaggedBackup;
-    unlagged_t unlaggedCalc;
     int unlaggedTime;
 
+    bool thinkBatch;  // inside ClientThinkBatch
+    bool thinkBatchBuildPoints;  // PERS_BP needs updating once the batch is done
+
+    // G_TouchTriggers candidates for the cell the client was last in
+    bool triggersCached;
+    int triggerCell[3];
+    int triggerClass;
+    int triggerGeneration;
+    int numTriggers;
+    gentity_t *triggers[MAX_CACHED_TRIGGERS];
+
     float voiceEnthusiasm;
     char lastVoiceCmd[MAX_VOICE_CMD_LEN];
 
@@ -521,6 +575,11 @@ struct buildLog_t {
 #define MAX_SPAWN_VARS 64
 #define MAX_SPAWN_VARS_CHARS 4096
 #define MAX_BUILDLOG 128
+#define CREEP_GRID_BUCKETS 256  // power of two
+#define ENTITY_GRID_BUCKETS 1024  // power of two, plus one more for oversized entities
+#define MAX_SCOREBOARD_STRING 1432  // 1400 bytes of entries plus the kill counts
+#define SCOREBOARD_REBUILD_TIME 1000  // pings and play time may be this stale
+#define SCOREBOARD_BROADCAST_TIME 500  // minimum msec between broadcasts
 #define MAX_PLAYER_MODEL 256
 
 struct level_locals_t {
@@ -557,6 +616,13 @@ struct level_locals_t {
     int numPlayingClients;  // connected, non-spectators
     int sortedClients[MAX_CLIENTS];  // sorted by score
 
+    // score table, formatted once for each viewing team
+    char scoreboard[NUM_TEAMS][MAX_SCOREBOARD_STRING];
+    bool scoreboardDirty;  // ranks or scores changed, set by CalculateRanks
+    int scoreboardTime;  // level.time the score table was built
+    bool scoreboardPending;  // broadcast held back by the rate limit
+    int scoreboardSentTime;  // level.time of the last broadcast
+
     int snd_fry;  // sound index for standing in lava
 
     int warmupModificationCount;  // for detecting if g_warmup is changed
@@ -617,6 +683,13 @@ struct level_locals_t {
     int humanNextQueueTime;
 
     buildPointZone_t *buildPointZones;
+    gentity_t *buildables[BA_NUM_BUILDABLES];  // every buildable of each type, alive or not
+    int numBuildables[BA_NUM_BUILDABLES];
+    gentity_t *powerNodes;  // every reactor and repeater, alive or not
+    gentity_t *creepSources[CREEP_GRID_BUCKETS];  // alien spawns and overminds by grid cell
+    gentity_t *entityGrid[ENTITY_GRID_BUCKETS + 1];  // in use entities by grid cell, see G_EntitiesInBox
+    gentity_t *triggers;  // linked CONTENTS_TRIGGER entities
+    int triggerGeneration;  // changes whenever level.triggers or one of their boxes does
 
     gentity_t *markedBuildables[MAX_GENTITIES];
     int numBuildablesForRemoval;
@@ -649,7 +722,11 @@ struct level_locals_t {
     int pausedTime;
 
     int unlaggedIndex;
-    int unlaggedTimes[MAX_UNLAGGED_MARKERS];
+    unlaggedFrame_t unlaggedHist[MAX_UNLAGGED_MARKERS];
+    unlaggedFrame_t unlaggedCalc;  // see G_UnlaggedCalc, used[] is per rewind
+    bool unlaggedCalcCached;  // unlaggedCalc is still valid for unlaggedCalc.time
+    int unlaggedCalcStart;
+    int unlaggedCalcStop;
 
     char layout[MAX_QPATH];
 
@@ -761,6 +838,8 @@ bool G_IsDCCBuilt(void);
 int G_FindDCC(gentity_t *self);
 gentity_t *G_Reactor(void);
 gentity_t *G_Overmind(void);
+void G_UpdateCreepSource(gentity_t *ent);
+void G_RemoveCreepSource(gentity_t *ent);
 bool G_FindCreep(gentity_t *self);
 
 void G_BuildableThink(gentity_t *ent, int msec);
@@ -782,6 +861,10 @@ int G_NextQueueTime(int queuedBP, int totalBP, int queueBaseRate);
 void G_QueueBuildPoints(gentity_t *self);
 int G_GetBuildPoints(const vec3_t pos, team_t team);
 int G_GetMarkedBuildPoints(const vec3_t pos, team_t team);
+void G_SetParentNode(gentity_t *self, gentity_t *node);
+void G_RemoveFromPowerGraph(gentity_t *ent);
+void G_RemoveBuildable(gentity_t *ent);
+gentity_t *G_IterateBuildables(gentity_t *from, team_t team);
 bool G_FindPower(gentity_t *self, bool searchUnspawned);
 gentity_t *G_PowerEntityForPoint(const vec3_t origin);
 gentity_t *G_PowerEntityForEntity(gentity_t *ent);
@@ -838,6 +921,11 @@ void G_TriggerMenu(int clientNum, dynMenu_t menu);
 void G_TriggerMenuArgs(int clientNum, dynMenu_t menu, int arg);
 void G_CloseMenus(int clientNum);
 
+void G_UpdateEntityGrid(gentity_t *ent);
+void G_RemoveFromEntityGrid(gentity_t *ent);
+int G_EntitiesInBox(const vec3_t mins, const vec3_t maxs, int eType, team_t team, gentity_t **list, int maxcount);
+int G_EntitiesInRadius(const vec3_t origin, float radius, int eType, team_t team, gentity_t **list, int maxcount);
+int G_TriggersInBox(const vec3_t mins, const vec3_t maxs, gentity_t **list, int maxcount);
 bool G_Visible(gentity_t *ent1, gentity_t *ent2, int contents);
 gentity_t *G_ClosestEnt(vec3_t origin, gentity_t **entities, int numEntities);
 
@@ -1005,6 +1093,7 @@ void FindIntermissionPoint(void);
 void G_RunThink(gentity_t *ent);
 void G_AdminMessage(gentity_t *ent, const char *string);
 void QDECL G_LogPrintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void G_LogFlush(void);
 void SendScoreboardMessageToAllClients(void);
 void QDECL G_Printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
 void QDECL G_Error(const char *fmt, ...) __attribute__((noreturn, format(printf, 1, 2)));
@@ -1030,8 +1119,10 @@ void G_UnlaggedStore(void);
 void G_UnlaggedClear(gentity_t *ent);
 void G_UnlaggedCalc(int time, gentity_t *skipEnt);
 void G_UnlaggedOn(gentity_t *attacker, vec3_t muzzle, float range);
+void G_UnlaggedOnTrace(gentity_t *attacker, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end);
 void G_UnlaggedOff(void);
 void ClientThink(int clientNum);
+int ClientThinkBatch(int clientNum, int numCmds);
 void ClientEndFrame(gentity_t *ent);
 void G_RunClient(gentity_t *ent);
 
@@ -1079,6 +1170,9 @@ void G_namelog_restore(gclient_t *client);
 void G_namelog_update_score(gclient_t *client);
 void G_namelog_update_name(gclient_t *client);
 void G_namelog_cleanup(void);
+namelog_t *G_namelog_find_id(int id);
+int G_namelog_match_addr(const addr_t *ip, namelog_t **matches, int max);
+int G_namelog_match_name(const char *clean, namelog_t **matches, int max);
 
 // some maxs
 #define MAX_FILEPATH 144
@@ -1186,4 +1280,6 @@ extern vmCvar_t g_allowTeamOverlay;
 
 extern vmCvar_t g_censorship;
 
+extern vmCvar_t g_luaBudget;  // instructions a Lua script gets per call, 0 for no limit
+
 #endif
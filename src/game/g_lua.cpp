@@ -12,7 +12,13 @@
 #include "script/mathlib.h"
 using namespace script;
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <list>
+#include <vector>
 
 sol::state *lua = nullptr;
 
@@ -297,10 +303,417 @@ private:
     gentity_t* ent = nullptr;
 };
 
+/*
+ * Entities passed to hooks
+ *
+ * Hooks get entities as light userdata instead of a GEntity, so firing a
+ * hook allocates nothing.  All light userdata share one metatable, whose
+ * __index and __newindex map the key to a field number through a table
+ * built once in Api_Init.  game.entity(e) wraps one in a full GEntity.
+ * A missing entity, like the attacker of world damage, is passed as nil.
+ */
+enum entityField_t {
+    ENTFIELD_NUMBER,
+    ENTFIELD_CLASSNAME,
+    ENTFIELD_HEALTH,
+    ENTFIELD_COUNT,
+    ENTFIELD_DAMAGE,
+    ENTFIELD_SPAWNFLAGS,
+    ENTFIELD_ORIGIN,
+    ENTFIELD_ANGLES,
+    ENTFIELD_CLIENT,
+
+    ENTFIELD_MAX
+};
+
+static const char *entityFieldNames[ENTFIELD_MAX] = {
+    "number", "classname", "health", "count", "damage", "spawnflags", "origin", "angles", "client"
+};
+
+static gentity_t *LuaEntity_Check(lua_State *L, int idx)
+{
+    gentity_t *ent = static_cast<gentity_t *>(lua_touserdata(L, idx));
+
+    if (!ent || ent < g_entities || ent >= g_entities + level.num_entities || !ent->inuse)
+        luaL_error(L, "not a game entity");
+
+    return ent;
+}
+
+static int LuaEntity_Field(lua_State *L)
+{
+    int field;
+
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+    field = lua_isinteger(L, -1) ? lua_tointeger(L, -1) : -1;
+    lua_pop(L, 1);
+
+    return field;
+}
+
+static int LuaEntity_Index(lua_State *L)
+{
+    gentity_t *ent = LuaEntity_Check(L, 1);
+
+    switch (LuaEntity_Field(L))
+    {
+        case ENTFIELD_NUMBER:
+            lua_pushinteger(L, ent - g_entities);
+            break;
+        case ENTFIELD_CLASSNAME:
+            lua_pushstring(L, ent->classname ? ent->classname : "");
+            break;
+        case ENTFIELD_HEALTH:
+            lua_pushinteger(L, ent->health);
+            break;
+        case ENTFIELD_COUNT:
+            lua_pushinteger(L, ent->count);
+            break;
+        case ENTFIELD_DAMAGE:
+            lua_pushinteger(L, ent->damage);
+            break;
+        case ENTFIELD_SPAWNFLAGS:
+            lua_pushinteger(L, ent->spawnflags);
+            break;
+        case ENTFIELD_ORIGIN:
+            sol::stack::push(L, Vec3(ent->r.currentOrigin));
+            break;
+        case ENTFIELD_ANGLES:
+            sol::stack::push(L, Vec3(ent->r.currentAngles));
+            break;
+        case ENTFIELD_CLIENT:
+            lua_pushboolean(L, ent->client != nullptr);
+            break;
+        default:
+            lua_pushnil(L);
+            break;
+    }
+
+    return 1;
+}
+
+static int LuaEntity_NewIndex(lua_State *L)
+{
+    gentity_t *ent = LuaEntity_Check(L, 1);
+
+    switch (LuaEntity_Field(L))
+    {
+        case ENTFIELD_HEALTH:
+            ent->health = luaL_checkinteger(L, 3);
+            break;
+        case ENTFIELD_COUNT:
+            ent->count = luaL_checkinteger(L, 3);
+            break;
+        case ENTFIELD_DAMAGE:
+            ent->damage = luaL_checkinteger(L, 3);
+            break;
+        default:
+            return luaL_error(L, "entity field \"%s\" is read only", lua_tostring(L, 2));
+    }
+
+    return 0;
+}
+
+static void LuaEntity_Init(lua_State *L)
+{
+    lua_pushlightuserdata(L, nullptr);
+    lua_createtable(L, 0, 2);
+
+    lua_createtable(L, 0, ENTFIELD_MAX);
+    for (int i = 0; i < ENTFIELD_MAX; i++)
+    {
+        lua_pushinteger(L, i);
+        lua_setfield(L, -2, entityFieldNames[i]);
+    }
+
+    lua_pushvalue(L, -1);
+    lua_pushcclosure(L, LuaEntity_Index, 1);
+    lua_setfield(L, -3, "__index");
+    lua_pushcclosure(L, LuaEntity_NewIndex, 1);
+    lua_setfield(L, -2, "__newindex");
+
+    lua_setmetatable(L, -2);
+    lua_pop(L, 1);
+}
+
+/*
+ * Scripts
+ *
+ * Each script loaded with the lua command runs in its own environment,
+ * which falls back to the globals for the game API, and is loaded again
+ * when its file changes.  Every call into a script, including running it
+ * on load, gets g_luaBudget instructions, counted by a Lua count hook, and
+ * is timed for luastatus.
+ */
+#define LUA_BUDGET_STEP 1000  // instructions between budget checks
+#define LUA_RELOAD_TIME 1000  // msec between checks for changed scripts
+
+struct luaScript_t {
+    std::string path;
+    sol::environment env;
+    time_t mtime;
+
+    int calls;
+    int errors;
+    int overruns;  // calls stopped for going over g_luaBudget
+    double totalTime;  // nanoseconds
+    double maxTime;
+};
+
+static std::list<luaScript_t> luaScripts;
+static luaScript_t *luaCurrent;  // script being loaded or called
+static int luaCallDepth;
+static int luaBudgetLeft;
+static bool luaBudgetExceeded;
+
+static void LuaBudget_Hook(lua_State *L, lua_Debug *)
+{
+    if ((luaBudgetLeft -= LUA_BUDGET_STEP) > 0)
+        return;
+
+    luaBudgetExceeded = true;
+    luaL_error(L, "instruction budget of %d exceeded", g_luaBudget.integer);
+}
+
+/*
+ * LuaScript_Call
+ *
+ * Calls into a script under the instruction budget.  Calls made from
+ * inside another call share the budget of the outermost one.
+ */
+template <typename... Args>
+static bool LuaScript_Call(luaScript_t *script, const char *what, const sol::protected_function& fn, Args... args)
+{
+    lua_State *L = lua->lua_state();
+    luaScript_t *caller = luaCurrent;
+    bool outer = !luaCallDepth++;
+
+    if (outer && g_luaBudget.integer > 0)
+    {
+        luaBudgetLeft = g_luaBudget.integer;
+        luaBudgetExceeded = false;
+        lua_sethook(L, LuaBudget_Hook, LUA_MASKCOUNT, LUA_BUDGET_STEP);
+    }
+
+    luaCurrent = script;
+    auto start = std::chrono::steady_clock::now();
+    sol::protected_function_result r = fn(args...);
+    double time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    luaCurrent = caller;
+
+    if (outer)
+        lua_sethook(L, nullptr, 0, 0);
+    luaCallDepth--;
+
+    if (script)
+    {
+        script->calls++;
+        script->totalTime += time;
+        script->maxTime = std::max(script->maxTime, time);
+    }
+
+    if (r.valid())
+        return true;
+
+    sol::error e = r;
+    G_Printf(S_COLOR_YELLOW "lua %s%s%s: %s\n", script ? script->path.c_str() : "", script ? " " : "", what, e.what());
+    if (script)
+    {
+        script->errors++;
+        if (outer && luaBudgetExceeded)
+            script->overruns++;
+    }
+
+    return false;
+}
+
+/*
+ * Hook registry
+ *
+ * game.hook(name, function) resolves the name to a luaHook_t and keeps
+ * the function as a protected_function when the script loads, so firing
+ * a hook is a walk over a vector with no lookups by name.  Hooks
+ * registered while a script loads replace that script's hooks only once
+ * the load succeeds, so a broken edit leaves the old hooks running.
+ */
+struct luaHookEntry_t {
+    luaHook_t hook;
+    sol::protected_function fn;
+    luaScript_t *script;
+};
+
+int luaHookCount[LUA_HOOK_MAX];
+
+static std::vector<luaHookEntry_t> luaHooks[LUA_HOOK_MAX];
+static std::vector<luaHookEntry_t> luaPendingHooks;
+static bool luaLoading;
+
+static const char *luaHookNames[LUA_HOOK_MAX] = {"client_spawn", "damage", "think", "build"};
+
+static void LuaHook_Add(const luaHookEntry_t& entry)
+{
+    luaHooks[entry.hook].push_back(entry);
+    luaHookCount[entry.hook] = luaHooks[entry.hook].size();
+}
+
+static void LuaHook_RemoveScript(luaScript_t *script)
+{
+    for (int i = 0; i < LUA_HOOK_MAX; i++)
+    {
+        auto& hooks = luaHooks[i];
+        hooks.erase(std::remove_if(hooks.begin(), hooks.end(),
+                        [script](const luaHookEntry_t& h) { return h.script == script; }),
+            hooks.end());
+        luaHookCount[i] = hooks.size();
+    }
+}
+
+static void LuaHook_Register(const std::string& name, sol::protected_function fn)
+{
+    for (int i = 0; i < LUA_HOOK_MAX; i++)
+    {
+        if (!Q_stricmp(name.c_str(), luaHookNames[i]))
+        {
+            // hooks are only bound at load, so firing one never changes the list being walked
+            if (!luaLoading)
+            {
+                G_Printf(S_COLOR_YELLOW "game.hook: hooks can only be added while a script loads\n");
+                return;
+            }
+
+            luaPendingHooks.push_back({static_cast<luaHook_t>(i), fn, luaCurrent});
+            return;
+        }
+    }
+
+    G_Printf(S_COLOR_YELLOW "game.hook: unknown hook \"%s\"\n", name.c_str());
+}
+
+template <typename... Args>
+static void LuaHook_Call(luaHook_t hook, Args... args)
+{
+    for (auto& h : luaHooks[hook])
+        LuaScript_Call(h.script, luaHookNames[hook], h.fn, args...);
+}
+
+static time_t LuaScript_MTime(const std::string& path)
+{
+    struct stat st;
+
+    if (stat(path.c_str(), &st) < 0)
+        return 0;
+
+    return st.st_mtime;
+}
+
+/*
+ * LuaScript_Load
+ *
+ * Runs the script in a fresh environment and, if that works, swaps its
+ * hooks and environment for the new ones
+ */
+static bool LuaScript_Load(luaScript_t *script)
+{
+    sol::environment env(*lua, sol::create, lua->globals());
+    sol::load_result chunk = lua->load_file(script->path);
+    bool ok;
+
+    script->mtime = LuaScript_MTime(script->path);
+
+    if (!chunk.valid())
+    {
+        sol::error e = chunk;
+        G_Printf(S_COLOR_YELLOW "lua %s: %s\n", script->path.c_str(), e.what());
+        return false;
+    }
+
+    sol::protected_function fn = chunk;
+    sol::set_environment(env, fn);
+
+    luaPendingHooks.clear();
+    luaLoading = true;
+    ok = LuaScript_Call(script, "load", fn);
+    luaLoading = false;
+
+    if (ok)
+    {
+        LuaHook_RemoveScript(script);
+        for (auto& h : luaPendingHooks)
+            LuaHook_Add(h);
+        script->env = env;
+    }
+    luaPendingHooks.clear();
+
+    return ok;
+}
+
+/*
+ * G_LuaCheckReload
+ *
+ * Loads scripts whose file changed again, called every frame
+ */
+void G_LuaCheckReload(void)
+{
+    static int nextCheck;
+    int now = Sys_Milliseconds();
+
+    if (now < nextCheck)
+        return;
+    nextCheck = now + LUA_RELOAD_TIME;
+
+    for (auto& script : luaScripts)
+    {
+        time_t mtime = LuaScript_MTime(script.path);
+
+        if (!mtime || mtime == script.mtime)
+            continue;
+
+        G_Printf("lua: reloading %s\n", script.path.c_str());
+        LuaScript_Load(&script);
+    }
+}
+
+static sol::optional<sol::lightuserdata_value> LuaEntity(gentity_t *ent)
+{
+    if (!ent)
+        return sol::nullopt;
+
+    return sol::lightuserdata_value(ent);
+}
+
+// game.entity(e)
+static int LuaEntity_Wrap(lua_State *L)
+{
+    return sol::stack::push(L, GEntity(LuaEntity_Check(L, 1)));
+}
+
+void LuaHook_ClientSpawn(gentity_t *ent)
+{
+    LuaHook_Call(LUA_HOOK_CLIENTSPAWN, LuaEntity(ent));
+}
+
+void LuaHook_Damage(gentity_t *targ, gentity_t *inflictor, gentity_t *attacker, int damage, int mod)
+{
+    LuaHook_Call(LUA_HOOK_DAMAGE, LuaEntity(targ), LuaEntity(inflictor), LuaEntity(attacker), damage, mod);
+}
+
+void LuaHook_Think(gentity_t *ent)
+{
+    LuaHook_Call(LUA_HOOK_THINK, LuaEntity(ent));
+}
+
+void LuaHook_Build(gentity_t *ent, gentity_t *builder)
+{
+    LuaHook_Call(LUA_HOOK_BUILD, LuaEntity(ent), LuaEntity(builder));
+}
+
 void Api_Init()
 {
     lua = static_cast<sol::state*>(Sys_GetLua());
 
+    LuaEntity_Init(lua->lua_state());
+
     sol::table game = lua->create_named_table("game");
 
     game.new_usertype<GEntity>("gentity_t",
@@ -346,10 +759,65 @@ void Api_Init()
             "targetShaderNewName", sol::property(&GEntity::get_targetShaderNewName, &GEntity::set_targetShaderNewName),
             "targetname", sol::property(&GEntity::get_targetname, &GEntity::set_targetname),
             "wait", sol::property(&GEntity::get_wait, &GEntity::set_wait));
+
+    game.set_function("hook", &LuaHook_Register);
+    game.set_function("entity", &LuaEntity_Wrap);
 }
 
-void LuaHook_ClientSpawn(GEntity gEnt)
+/*
+ * luabench [calls]
+ *
+ * Times a hook that reads one entity field, fired through the registry
+ * with a light userdata entity, against the same function looked up by
+ * name and passed a GEntity, the way hooks were called before.
+ */
+void Svcmd_LuaBench_f(void)
 {
+    char arg[16];
+    int calls = 100000;
+    gentity_t *ent = &g_entities[ENTITYNUM_WORLD];
+    std::vector<luaHookEntry_t> saved;
+    double prebound, byname;
+
+    if (Cmd_Argc() > 1)
+    {
+        Cmd_ArgvBuffer(1, arg, sizeof(arg));
+        calls = MAX(atoi(arg), 1);
+    }
+
+    try
+    {
+        lua->script("function __luabench(e) return e.health end");
+    }
+    catch (sol::error& e)
+    {
+        Com_Printf(S_COLOR_YELLOW "%s\n", e.what());
+        return;
+    }
+
+    // time the think hook alone
+    sol::protected_function bench = (*lua)["__luabench"];
+    saved.swap(luaHooks[LUA_HOOK_THINK]);
+    luaHooks[LUA_HOOK_THINK].push_back({LUA_HOOK_THINK, bench, nullptr});
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++)
+        LuaHook_Think(ent);
+    prebound = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++)
+    {
+        sol::protected_function fn = (*lua)["__luabench"];
+        fn(GEntity(ent));
+    }
+    byname = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    luaHooks[LUA_HOOK_THINK].swap(saved);
+    (*lua)["__luabench"] = sol::lua_nil;
+
+    G_Printf("luabench: %d calls, prebound %.0f ns/call, by name %.0f ns/call\n", calls, prebound / calls,
+        byname / calls);
 }
 
 void Cmd_LuaLoad_f(gentity_t*)
@@ -360,13 +828,44 @@ void Cmd_LuaLoad_f(gentity_t*)
         return;
     }
 
-    try
+    std::string path = ConcatArgs(1);
+    luaScript_t *script = nullptr;
+
+    for (auto& s : luaScripts)
     {
-        std::string s = ConcatArgs(1);
-        lua->script_file(s);
+        if (s.path == path)
+            script = &s;
     }
-    catch (sol::error& e)
+
+    if (!script)
     {
-        Com_Printf(S_COLOR_YELLOW "%s\n", e.what());
+        luaScripts.emplace_back();
+        script = &luaScripts.back();
+        script->path = path;
+    }
+
+    LuaScript_Load(script);
+}
+
+/*
+ * luastatus
+ *
+ * Lists the loaded scripts with their hooks and call counters
+ */
+void Svcmd_LuaStatus_f(void)
+{
+    for (auto& script : luaScripts)
+    {
+        int hooks = 0;
+
+        for (int i = 0; i < LUA_HOOK_MAX; i++)
+        {
+            for (auto& h : luaHooks[i])
+                hooks += h.script == &script;
+        }
+
+        G_Printf("%s: %d hooks, %d calls, %.1f us avg, %.1f us max, %d errors, %d over budget\n",
+            script.path.c_str(), hooks, script.calls, script.calls ? script.totalTime / script.calls / 1000 : 0.0,
+            script.maxTime / 1000, script.errors, script.overruns);
     }
 }
@@ -7,7 +7,28 @@
 struct gentity_t;
 struct gclient_t;
 
+// events scripts can hook with game.hook(name, function)
+enum luaHook_t {
+    LUA_HOOK_CLIENTSPAWN,  // client_spawn(ent)
+    LUA_HOOK_DAMAGE,  // damage(targ, inflictor, attacker, damage, mod)
+    LUA_HOOK_THINK,  // think(ent)
+    LUA_HOOK_BUILD,  // build(ent, builder)
+
+    LUA_HOOK_MAX
+};
+
+// callers check this before paying for a call into g_lua.cpp
+extern int luaHookCount[LUA_HOOK_MAX];
+
 void Api_Init();
 void Cmd_LuaLoad_f( gentity_t* );
+void Svcmd_LuaBench_f( void );
+void Svcmd_LuaStatus_f( void );
+void G_LuaCheckReload( void );
+
+void LuaHook_ClientSpawn( gentity_t *ent );
+void LuaHook_Damage( gentity_t *targ, gentity_t *inflictor, gentity_t *attacker, int damage, int mod );
+void LuaHook_Think( gentity_t *ent );
+void LuaHook_Build( gentity_t *ent, gentity_t *builder );
 
 #endif
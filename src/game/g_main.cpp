@@ -145,6 +145,8 @@ vmCvar_t g_allowTeamOverlay;
 
 vmCvar_t g_censorship;
 
+vmCvar_t g_luaBudget;
+
 vmCvar_t g_tag;
 
 // copy cvars that can be set in worldspawn so they can be restored later
@@ -268,6 +270,8 @@ static cvarTable_t gameCvarTable[] =
 
     {&g_censorship, "g_censorship", "", CVAR_ARCHIVE, 0, false},
 
+    {&g_luaBudget, "g_luaBudget", "1000000", CVAR_ARCHIVE, 0, false},
+
     {&g_tag, "g_tag", "main", CVAR_INIT, 0, false}
 };
 
@@ -308,6 +312,9 @@ SO_PUBLIC intptr_t vmMain(int command, int arg0, int arg1, int arg2)
             ClientThink(arg0);
             return 0;
 
+        case GAME_CLIENT_THINK_BATCH:
+            return ClientThinkBatch(arg0, arg1);
+
         case GAME_CLIENT_USERINFO_CHANGED:
             ClientUserinfoChanged(arg0, false);
             return 0;
@@ -449,9 +456,15 @@ G_UpdateCvars
 */
 void G_UpdateCvars(void)
 {
+    static int lastModificationCount = -1;
     int i;
     cvarTable_t *cv;
 
+    // nothing to pick up if no cvar changed since the last pass
+    if (Cvar_ModificationCount() == lastModificationCount)
+        return;
+    lastModificationCount = Cvar_ModificationCount();
+
     for (i = 0, cv = gameCvarTable; i < gameCvarTableSize; i++, cv++)
     {
         if (cv->vmCvar)
@@ -710,6 +723,7 @@ void G_ShutdownGame(int restart)
     {
         G_LogPrintf("ShutdownGame:\n");
         G_LogPrintf("------------------------------------------------------------\n");
+        G_LogFlush();
         FS_FCloseFile(level.logFile);
         level.logFile = 0;
     }
@@ -1030,20 +1044,20 @@ Counts the number of spawns for each team
 */
 void G_CountSpawns(void)
 {
-    int i;
     gentity_t *ent;
 
     level.numAlienSpawns = 0;
     level.numHumanSpawns = 0;
-    for (i = 1, ent = g_entities + i; i < level.num_entities; i++, ent++)
-    {
-        if (!ent->inuse || ent->s.eType != ET_BUILDABLE || ent->health <= 0)
-            continue;
 
-        if (ent->s.modelindex == BA_A_SPAWN)
+    for (ent = level.buildables[BA_A_SPAWN]; ent; ent = ent->nextBuildable)
+    {
+        if (ent->health > 0)
             level.numAlienSpawns++;
+    }
 
-        if (ent->s.modelindex == BA_H_SPAWN)
+    for (ent = level.buildables[BA_H_SPAWN]; ent; ent = ent->nextBuildable)
+    {
+        if (ent->health > 0)
             level.numHumanSpawns++;
     }
 }
@@ -1074,7 +1088,6 @@ Recalculate the quantity of building points available to the teams
 void G_CalculateBuildPoints(void)
 {
     int i;
-    buildable_t buildable;
     buildPointZone_t *zone;
 
     // BP queue updates
@@ -1128,15 +1141,14 @@ void G_CalculateBuildPoints(void)
         zone->totalBuildPoints = g_humanRepeaterBuildPoints.integer;
     }
 
-    // Iterate through entities
-    for (i = MAX_CLIENTS; i < level.num_entities; i++)
+    // Iterate through buildables
+    for (gentity_t *ent = G_IterateBuildables(NULL, TEAM_NONE); ent; ent = G_IterateBuildables(ent, TEAM_NONE))
     {
-        gentity_t *ent = &g_entities[i];
         buildPointZone_t *zone;
         buildable_t buildable;
         int cost;
 
-        if (ent->s.eType != ET_BUILDABLE || ent->s.eFlags & EF_DEAD)
+        if (ent->s.eFlags & EF_DEAD)
             continue;
 
         // mark a zone as active
@@ -1172,16 +1184,9 @@ void G_CalculateBuildPoints(void)
 
     // Finally, update repeater zones and their queues
     // note that this has to be done after the used BP is calculated
-    for (i = MAX_CLIENTS; i < level.num_entities; i++)
+    for (gentity_t *ent = level.buildables[BA_H_REPEATER]; ent; ent = ent->nextBuildable)
     {
-        gentity_t *ent = &g_entities[i];
-
-        if (ent->s.eType != ET_BUILDABLE || ent->s.eFlags & EF_DEAD || ent->buildableTeam != TEAM_HUMANS)
-            continue;
-
-        buildable = static_cast<buildable_t>(ent->s.modelindex);
-
-        if (buildable != BA_H_REPEATER)
+        if (ent->s.eFlags & EF_DEAD)
             continue;
 
         if (ent->usesBuildPointZone && level.buildPointZones[ent->buildPointZone].active)
@@ -1422,6 +1427,8 @@ void CalculateRanks(void)
     // see if it is time to end the level
     CheckExitRules();
 
+    level.scoreboardDirty = true;
+
     // if we are at the intermission, send the new info to everyone
     if (level.intermissiontime)
         SendScoreboardMessageToAllClients();
@@ -1440,13 +1447,23 @@ MAP CHANGING
 SendScoreboardMessageToAllClients
 
 Do this at BeginIntermission time and whenever ranks are recalculated
-due to enters/exits/forced team changes
+due to enters/exits/forced team changes.  Broadcasts are rate limited, one
+held back is sent from G_RunFrame once the limit allows.
 ========================
 */
 void SendScoreboardMessageToAllClients(void)
 {
     int i;
 
+    if (level.time - level.scoreboardSentTime < SCOREBOARD_BROADCAST_TIME)
+    {
+        level.scoreboardPending = true;
+        return;
+    }
+
+    level.scoreboardPending = false;
+    level.scoreboardSentTime = level.time;
+
     for (i = 0; i < level.maxclients; i++)
     {
         if (level.clients[i].pers.connected == CON_CONNECTED)
@@ -1646,6 +1663,30 @@ void G_AdminMessage(gentity_t *ent, const char *msg)
         ent ? ent->client->pers.netname : "console", msg);
 }
 
+/*
+=================
+G_LogFlush
+
+Lines for the logfile are collected in logBuffer and written out once a
+frame, so a busy server does one write per frame instead of one per line
+=================
+*/
+#define LOG_BUFFER_SIZE 0x8000
+
+static char logBuffer[LOG_BUFFER_SIZE];
+static int logBufferLen;
+
+void G_LogFlush(void)
+{
+    if (!logBufferLen)
+        return;
+
+    if (level.logFile)
+        FS_Write(logBuffer, logBufferLen, level.logFile);
+
+    logBufferLen = 0;
+}
+
 /*
 =================
 G_LogPrintf
@@ -1657,7 +1698,7 @@ void QDECL G_LogPrintf(const char *fmt, ...)
 {
     va_list argptr;
     char string[1024], decolored[1024];
-    int min, tens, sec;
+    int min, tens, sec, len;
 
     sec = (level.time - level.startTime) / 1000;
 
@@ -1682,7 +1723,11 @@ void QDECL G_LogPrintf(const char *fmt, ...)
         return;
 
     G_DecolorString(string, decolored, sizeof(decolored));
-    FS_Write(decolored, strlen(decolored), level.logFile);
+    len = strlen(decolored);
+    if (logBufferLen + len > LOG_BUFFER_SIZE)
+        G_LogFlush();
+    memcpy(logBuffer + logBufferLen, decolored, len);
+    logBufferLen += len;
 }
 
 /*
@@ -2128,6 +2173,9 @@ void G_RunThink(gentity_t *ent)
     if (!ent->think)
         G_Error("NULL ent->think");
 
+    if (luaHookCount[LUA_HOOK_THINK])
+        LuaHook_Think(ent);
+
     ent->think(ent);
 }
 
@@ -2167,6 +2215,11 @@ void G_RunFrame(int levelTime)
     int msec;
     static int ptime3000 = 0;
 
+    // write out what was logged since the last frame
+    G_LogFlush();
+
+    G_LuaCheckReload();
+
     // if we are waiting for the level to restart, do nothing
     if (level.restarted)
         return;
@@ -2330,6 +2383,9 @@ void G_RunFrame(int levelTime)
     // see if it is time to end the level
     CheckExitRules();
 
+    if (level.scoreboardPending)
+        SendScoreboardMessageToAllClients();
+
     // update to team status?
     CheckTeamStatus();
 
@@ -22,6 +22,200 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "g_local.h"
 
+/*
+===============
+Namelog indexes
+
+Namelogs are looked up by guid on every connect and searched by address
+and name by admin commands, so they are indexed by guid and by each of
+their addresses.  Name search is a substring match, so each namelog keeps
+its cleaned names and a signature of their trigrams; a search only runs
+strstr on namelogs whose signature holds every trigram of the search.
+At most MAX_NAMELOGS are kept, forgetting the least recently connected.
+===============
+*/
+#define NAMELOG_HASH_SIZE 512
+
+static namelog_t *namelogGuidHash[NAMELOG_HASH_SIZE];
+static namelogAddr_t *namelogAddrHash[NAMELOG_HASH_SIZE];
+static namelog_t *namelogTail;
+static namelog_t *namelogLruHead, *namelogLruTail;
+static int namelogCount;
+static int namelogNextId;
+
+static unsigned namelog_hash_guid(const char *guid)
+{
+    unsigned h = 0;
+
+    while (*guid)
+        h = h * 31 + tolower(*guid++);
+
+    return h & (NAMELOG_HASH_SIZE - 1);
+}
+
+static int namelog_addr_bits(const addr_t *ip) { return ip->type == addr_t::IPv4 ? 32 : 128; }
+
+static unsigned namelog_hash_addr(const addr_t *ip)
+{
+    unsigned h = ip->type;
+    int i;
+
+    for (i = 0; i < namelog_addr_bits(ip) / 8; i++)
+        h = h * 31 + ip->addr[i];
+
+    return h & (NAMELOG_HASH_SIZE - 1);
+}
+
+static void namelog_index_addr(namelog_t *n, int i)
+{
+    unsigned h = namelog_hash_addr(&n->ip[i]);
+
+    n->addrLink[i].namelog = n;
+    n->addrLink[i].next = namelogAddrHash[h];
+    namelogAddrHash[h] = &n->addrLink[i];
+}
+
+static void namelog_unindex_addr(namelog_t *n, int i)
+{
+    namelogAddr_t **l;
+
+    for (l = &namelogAddrHash[namelog_hash_addr(&n->ip[i])]; *l; l = &(*l)->next)
+    {
+        if (*l == &n->addrLink[i])
+        {
+            *l = n->addrLink[i].next;
+            return;
+        }
+    }
+}
+
+static void namelog_lru_unlink(namelog_t *n)
+{
+    if (n->lruPrev)
+        n->lruPrev->lruNext = n->lruNext;
+    else
+        namelogLruHead = n->lruNext;
+    if (n->lruNext)
+        n->lruNext->lruPrev = n->lruPrev;
+    else
+        namelogLruTail = n->lruPrev;
+    n->lruPrev = n->lruNext = NULL;
+}
+
+static void namelog_lru_touch(namelog_t *n)
+{
+    if (namelogLruHead == n)
+        return;
+    if (n->lruPrev || n->lruNext || namelogLruTail == n)
+        namelog_lru_unlink(n);
+    n->lruNext = namelogLruHead;
+    if (namelogLruHead)
+        namelogLruHead->lruPrev = n;
+    namelogLruHead = n;
+    if (!namelogLruTail)
+        namelogLruTail = n;
+}
+
+static int namelog_trigram(const char *s) { return (s[0] * 961 + s[1] * 31 + s[2]) % NAMELOG_NAME_BITS; }
+
+static void namelog_update_bits(namelog_t *n)
+{
+    int i;
+    const char *s;
+
+    memset(n->nameBits, 0, sizeof(n->nameBits));
+    for (i = 0; i < MAX_NAMELOG_NAMES; i++)
+    {
+        for (s = n->cleanName[i]; s[0] && s[1] && s[2]; s++)
+        {
+            int b = namelog_trigram(s);
+            n->nameBits[b / 32] |= 1u << (b % 32);
+        }
+    }
+}
+
+/*
+===============
+namelog_referenced
+
+Buildables and the build log keep pointers to the namelog of whoever built
+them, so those namelogs have to outlive the map
+===============
+*/
+static bool namelog_referenced(namelog_t *n)
+{
+    int i;
+
+    for (i = MAX_CLIENTS; i < level.num_entities; i++)
+    {
+        if (g_entities[i].inuse && g_entities[i].builtBy == n)
+            return true;
+    }
+
+    for (i = 0; i < level.numBuildLogs && i < MAX_BUILDLOG; i++)
+    {
+        if (level.buildLog[i].actor == n || level.buildLog[i].builtBy == n)
+            return true;
+    }
+
+    return false;
+}
+
+static void namelog_free(namelog_t *n)
+{
+    namelog_t **l, *p = NULL;
+    int i;
+
+    for (l = &level.namelogs; *l; p = *l, l = &(*l)->next)
+    {
+        if (*l == n)
+        {
+            *l = n->next;
+            break;
+        }
+    }
+    if (namelogTail == n)
+        namelogTail = p;
+
+    for (l = &namelogGuidHash[namelog_hash_guid(n->guid)]; *l; l = &(*l)->nextGuid)
+    {
+        if (*l == n)
+        {
+            *l = n->nextGuid;
+            break;
+        }
+    }
+
+    for (i = 0; i < MAX_NAMELOG_ADDRS && n->ip[i].str[0]; i++)
+        namelog_unindex_addr(n, i);
+
+    namelog_lru_unlink(n);
+    BG_Free(n);
+    namelogCount--;
+}
+
+/*
+===============
+namelog_evict
+
+Forget the least recently connected player who is not connected and has no
+mute or denybuild to remember
+===============
+*/
+static void namelog_evict(void)
+{
+    namelog_t *n;
+
+    for (n = namelogLruTail; n; n = n->lruPrev)
+    {
+        if (n->slot != -1 || n->muted || n->denyBuild || namelog_referenced(n))
+            continue;
+
+        namelog_free(n);
+        return;
+    }
+}
+
 void G_namelog_cleanup(void)
 {
     namelog_t *namelog, *n;
@@ -31,37 +225,49 @@ void G_namelog_cleanup(void)
         n = namelog->next;
         BG_Free(namelog);
     }
+
+    memset(namelogGuidHash, 0, sizeof(namelogGuidHash));
+    memset(namelogAddrHash, 0, sizeof(namelogAddrHash));
+    namelogTail = namelogLruHead = namelogLruTail = NULL;
+    namelogCount = 0;
+    namelogNextId = 0;
 }
 
 void G_namelog_connect(gclient_t *client)
 {
-    namelog_t *n, *p = NULL;
+    namelog_t *n, *p;
     int i;
+    unsigned h;
     char *newname;
 
-    for (n = level.namelogs; n; p = n, n = n->next)
+    // several namelogs can share a guid, reuse the oldest one not in use
+    h = namelog_hash_guid(client->pers.guid);
+    for (n = NULL, p = namelogGuidHash[h]; p; p = p->nextGuid)
     {
-        if (n->slot != -1)
+        if (p->slot != -1 || Q_stricmp(client->pers.guid, p->guid))
             continue;
-        if (!Q_stricmp(client->pers.guid, n->guid))
-            break;
+        if (!n || p->id < n->id)
+            n = p;
     }
     if (!n)
     {
+        if (namelogCount >= MAX_NAMELOGS)
+            namelog_evict();
+
         n = static_cast<namelog_t *>(BG_Alloc(sizeof(namelog_t)));
         strcpy(n->guid, client->pers.guid);
         n->guidless = client->pers.guidless;
-        if (p)
-        {
-            p->next = n;
-            n->id = p->id + 1;
-        }
+        n->id = MAX_CLIENTS + namelogNextId++;
+        if (namelogTail)
+            namelogTail->next = n;
         else
-        {
             level.namelogs = n;
-            n->id = MAX_CLIENTS;
-        }
+        namelogTail = n;
+        n->nextGuid = namelogGuidHash[h];
+        namelogGuidHash[h] = n;
+        namelogCount++;
     }
+    namelog_lru_touch(n);
     client->pers.namelog = n;
     n->slot = client - level.clients;
     n->banned = false;
@@ -76,8 +282,12 @@ void G_namelog_connect(gclient_t *client)
         if (!strcmp(n->ip[i].str, client->pers.ip.str))
             return;
     if (i == MAX_NAMELOG_ADDRS)
+    {
         i--;
+        namelog_unindex_addr(n, i);
+    }
     memcpy(&n->ip[i], &client->pers.ip, sizeof(n->ip[i]));
+    namelog_index_addr(n, i);
 }
 
 void G_namelog_disconnect(gclient_t *client)
@@ -112,6 +322,8 @@ void G_namelog_update_name(gclient_t *client)
             n->nameOffset = (n->nameOffset + 1) % MAX_NAMELOG_NAMES;
     }
     strcpy(n->name[n->nameOffset], client->pers.netname);
+    G_SanitiseString(n->name[n->nameOffset], n->cleanName[n->nameOffset], sizeof(n->cleanName[0]));
+    namelog_update_bits(n);
 }
 
 void G_namelog_restore(gclient_t *client)
@@ -123,3 +335,111 @@ void G_namelog_restore(gclient_t *client)
     client->ps.persistant[PERS_CREDIT] = 0;
     G_AddCreditToClient(client, n->credits, false);
 }
+
+namelog_t *G_namelog_find_id(int id)
+{
+    namelog_t *n;
+
+    for (n = level.namelogs; n; n = n->next)
+    {
+        if (n->id == id)
+            return n;
+    }
+
+    return NULL;
+}
+
+static int namelog_cmpid(const void *a, const void *b)
+{
+    return (*(namelog_t *const *)a)->id - (*(namelog_t *const *)b)->id;
+}
+
+/*
+===============
+G_namelog_match_addr
+
+Fills matches with the namelogs with an address in ip, oldest first, and
+returns how many there are
+===============
+*/
+int G_namelog_match_addr(const addr_t *ip, namelog_t **matches, int max)
+{
+    namelog_t *n;
+    namelogAddr_t *l;
+    int i, count = 0;
+
+    // a single address only needs its hash chain
+    if (ip->mask < 1 || ip->mask >= namelog_addr_bits(ip))
+    {
+        for (l = namelogAddrHash[namelog_hash_addr(ip)]; l && count < max; l = l->next)
+        {
+            n = l->namelog;
+            if (!G_AddressCompare(ip, &n->ip[l - n->addrLink]))
+                continue;
+            for (i = 0; i < count && matches[i] != n; i++)
+                ;
+            if (i == count)
+                matches[count++] = n;
+        }
+        qsort(matches, count, sizeof(matches[0]), namelog_cmpid);
+        return count;
+    }
+
+    for (n = level.namelogs; n && count < max; n = n->next)
+    {
+        for (i = 0; i < MAX_NAMELOG_ADDRS && n->ip[i].str[0]; i++)
+        {
+            if (G_AddressCompare(ip, &n->ip[i]))
+            {
+                matches[count++] = n;
+                break;
+            }
+        }
+    }
+
+    return count;
+}
+
+/*
+===============
+G_namelog_match_name
+
+Fills matches with the namelogs with a name containing clean, a string
+cleaned by G_SanitiseString, oldest first, and returns how many there are
+===============
+*/
+int G_namelog_match_name(const char *clean, namelog_t **matches, int max)
+{
+    unsigned bits[NAMELOG_NAME_BITS / 32] = {0};
+    namelog_t *n;
+    const char *s;
+    int i, count = 0;
+
+    for (s = clean; s[0] && s[1] && s[2]; s++)
+    {
+        int b = namelog_trigram(s);
+        bits[b / 32] |= 1u << (b % 32);
+    }
+
+    for (n = level.namelogs; n && count < max; n = n->next)
+    {
+        for (i = 0; i < NAMELOG_NAME_BITS / 32; i++)
+        {
+            if ((n->nameBits[i] & bits[i]) != bits[i])
+                break;
+        }
+        if (i < NAMELOG_NAME_BITS / 32)
+            continue;
+
+        for (i = 0; i < MAX_NAMELOG_NAMES && n->name[i][0]; i++)
+        {
+            if (strstr(n->cleanName[i], clean))
+            {
+                matches[count++] = n;
+                break;
+            }
+        }
+    }
+
+    return count;
+}
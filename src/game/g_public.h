@@ -261,11 +261,17 @@ enum gameExport_t {
 
     GAME_RUN_FRAME,  // ( int levelTime );
 
-    GAME_CONSOLE_COMMAND  // ( void );
+    GAME_CONSOLE_COMMAND,  // ( void );
     // ConsoleCommand will be called when a command has been issued
     // that is not recognized as a builtin function.
     // The game can issue trap_argc() / trap_argv() commands to get the command
     // and parameters.  Return false if the game doesn't recognize it as a command.
+
+    GAME_CLIENT_THINK_BATCH  // ( int clientNum, int numCmds );
+    // Like GAME_CLIENT_THINK for several new commands at once, fetched with
+    // SV_GetUsercmds.  Returns how many of them were run, the server runs the
+    // rest one at a time.  SV_SetThinkCmd selects the command SV_GetUsercmd
+    // returns while each one runs.
 };
 
 #endif
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "qcommon/cmd.h"
 #include "g_local.h"
+#include "g_lua.h"
 
 /*
 ===================
@@ -557,7 +558,8 @@ struct svcmd {
     {"evacuation", false, Svcmd_Evacuation_f}, {"forceTeam", false, Svcmd_ForceTeam_f},
     {"game_memory", false, BG_MemoryInfo}, {"humanWin", false, Svcmd_TeamWin_f},
     {"layoutLoad", false, Svcmd_LayoutLoad_f}, {"layoutSave", false, Svcmd_LayoutSave_f},
-    {"listmaps", true, Svcmd_ListMapsWrapper}, {"loadcensors", false, G_LoadCensors}, {"m", true, Svcmd_MessageWrapper},
+    {"listmaps", true, Svcmd_ListMapsWrapper}, {"loadcensors", false, G_LoadCensors},
+    {"luabench", false, Svcmd_LuaBench_f}, {"luastatus", false, Svcmd_LuaStatus_f}, {"m", true, Svcmd_MessageWrapper},
     {"mapRotation", false, Svcmd_MapRotation_f}, {"pr", false, Svcmd_Pr_f}, {"printqueue", false, Svcmd_PrintQueue_f},
     {"say", true, Svcmd_MessageWrapper}, {"say_team", true, Svcmd_TeamMessage_f}, {"status", false, Svcmd_Status_f},
     {"stopMapRotation", false, G_StopMapRotation}, {"suddendeath", false, Svcmd_SuddenDeath_f}};
@@ -465,6 +465,11 @@ void G_FreeEntity(gentity_t *ent)
     if (ent->neverFree)
         return;
 
+    G_RemoveFromPowerGraph(ent);
+    G_RemoveBuildable(ent);
+    G_RemoveCreepSource(ent);
+    G_RemoveFromEntityGrid(ent);
+
     // Cleanup dynamically allocated strings from lua land
     if (ent->_classname_alloced)
         free(&ent->classname);
@@ -864,36 +869,353 @@ void G_SetOrigin(gentity_t *ent, const vec3_t origin)
     VectorClear(ent->s.pos.trDelta);
 
     VectorCopy(origin, ent->r.currentOrigin);
+    G_UpdateEntityGrid(ent);
 }
 
-// from quakestyle.telefragged.com
-// (NOBODY): Code helper function
-//
-gentity_t *G_FindRadius(gentity_t *from, vec3_t org, float rad)
+/*
+===============
+Entity grid
+
+In use entities are hashed on a 2D grid by the cell holding the center
+of their bounding box, so spatial queries only visit the cells around
+the query volume.  Unlike SV_AreaEntities this also finds entities that
+are not linked into the world, e.g. buildables while G_CanBuild has
+them unlinked.  Anything wider than a cell goes into one extra bucket
+that every query checks.
+===============
+*/
+#define ENTITY_GRID_CELL 256
+#define ENTITY_GRID_OVERSIZED ENTITY_GRID_BUCKETS
+
+static int G_EntityGridCell(float v)
 {
-    vec3_t eorg;
-    int j;
+    return (int)floor(v / ENTITY_GRID_CELL);
+}
 
-    if (!from)
-        from = g_entities;
+static int G_EntityGridBucket(int cx, int cy)
+{
+    return (((unsigned)cx * 73856093u) ^ ((unsigned)cy * 19349663u)) & (ENTITY_GRID_BUCKETS - 1);
+}
+
+/*
+===============
+G_RemoveFromEntityGrid
+===============
+*/
+void G_RemoveFromEntityGrid(gentity_t *ent)
+{
+    if (level.entityGrid[ent->gridBucket] != ent && !ent->prevInGrid)
+        return;
+
+    if (ent->prevInGrid)
+        ent->prevInGrid->nextInGrid = ent->nextInGrid;
     else
-        from++;
+        level.entityGrid[ent->gridBucket] = ent->nextInGrid;
+    if (ent->nextInGrid)
+        ent->nextInGrid->prevInGrid = ent->prevInGrid;
 
-    for (; from < &g_entities[level.num_entities]; from++)
+    ent->nextInGrid = ent->prevInGrid = NULL;
+}
+
+/*
+===============
+G_UpdateEntityGrid
+
+Move ent to the grid cell of its current bounding box
+===============
+*/
+void G_UpdateEntityGrid(gentity_t *ent)
+{
+    int bucket;
+    int cell[2];
+    int i;
+
+    if (ent < g_entities || ent >= g_entities + MAX_GENTITIES || !ent->inuse)
+        return;
+
+    bucket = ENTITY_GRID_OVERSIZED;
+    cell[0] = cell[1] = 0;
+
+    if (ent->r.maxs[0] - ent->r.mins[0] <= ENTITY_GRID_CELL && ent->r.maxs[1] - ent->r.mins[1] <= ENTITY_GRID_CELL)
     {
-        if (!from->inuse)
-            continue;
+        for (i = 0; i < 2; i++)
+            cell[i] = G_EntityGridCell(ent->r.currentOrigin[i] + (ent->r.mins[i] + ent->r.maxs[i]) * 0.5f);
+
+        bucket = G_EntityGridBucket(cell[0], cell[1]);
+    }
+
+    if (level.entityGrid[ent->gridBucket] == ent || ent->prevInGrid)
+    {
+        if (ent->gridBucket == bucket && ent->gridCell[0] == cell[0] && ent->gridCell[1] == cell[1])
+            return;
+
+        G_RemoveFromEntityGrid(ent);
+    }
+
+    ent->gridBucket = bucket;
+    ent->gridCell[0] = cell[0];
+    ent->gridCell[1] = cell[1];
+    ent->prevInGrid = NULL;
+    ent->nextInGrid = level.entityGrid[bucket];
+    if (level.entityGrid[bucket])
+        level.entityGrid[bucket]->prevInGrid = ent;
+    level.entityGrid[bucket] = ent;
+}
+
+/*
+===============
+G_EntityGridMatch
+===============
+*/
+static bool G_EntityGridMatch(gentity_t *ent, const vec3_t mins, const vec3_t maxs, int eType, team_t team)
+{
+    int i;
+
+    if (!ent->inuse)
+        return false;
+
+    if (eType >= 0 && ent->s.eType != eType)
+        return false;
+
+    if (team >= 0)
+    {
+        if (ent->client)
+        {
+            if (ent->client->ps.stats[STAT_TEAM] != team)
+                return false;
+        }
+        else if (ent->s.eType == ET_BUILDABLE)
+        {
+            if (ent->buildableTeam != team)
+                return false;
+        }
+        else if (team != TEAM_NONE)
+            return false;
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        if (ent->r.currentOrigin[i] + ent->r.mins[i] > maxs[i] || ent->r.currentOrigin[i] + ent->r.maxs[i] < mins[i])
+            return false;
+    }
+
+    return true;
+}
+
+static int G_CompareEntityNumbers(const void *a, const void *b)
+{
+    return *(gentity_t **)a - *(gentity_t **)b;
+}
+
+/*
+===============
+G_EntitiesInBox
+
+Fills list with the in use entities whose bounding box touches the box,
+in entity number order.  eType and team filter the result, pass -1 for
+either to accept anything.  Clients match on STAT_TEAM, buildables on
+buildableTeam and everything else counts as TEAM_NONE.
+===============
+*/
+int G_EntitiesInBox(const vec3_t mins, const vec3_t maxs, int eType, team_t team, gentity_t **list, int maxcount)
+{
+    int x, y, x0, y0, x1, y1;
+    int count = 0;
+    gentity_t *ent;
+
+    // an entity can reach half a cell out of the cell its center is in
+    x0 = G_EntityGridCell(mins[0] - ENTITY_GRID_CELL / 2);
+    y0 = G_EntityGridCell(mins[1] - ENTITY_GRID_CELL / 2);
+    x1 = G_EntityGridCell(maxs[0] + ENTITY_GRID_CELL / 2);
+    y1 = G_EntityGridCell(maxs[1] + ENTITY_GRID_CELL / 2);
+
+    for (ent = level.entityGrid[ENTITY_GRID_OVERSIZED]; ent && count < maxcount; ent = ent->nextInGrid)
+    {
+        if (G_EntityGridMatch(ent, mins, maxs, eType, team))
+            list[count++] = ent;
+    }
+
+    if ((x1 - x0 + 1) * (y1 - y0 + 1) > ENTITY_GRID_BUCKETS)
+    {
+        // huge query, visiting every bucket once is cheaper
+        for (x = 0; x < ENTITY_GRID_BUCKETS; x++)
+        {
+            for (ent = level.entityGrid[x]; ent && count < maxcount; ent = ent->nextInGrid)
+            {
+                if (G_EntityGridMatch(ent, mins, maxs, eType, team))
+                    list[count++] = ent;
+            }
+        }
+    }
+    else
+    {
+        for (x = x0; x <= x1; x++)
+        {
+            for (y = y0; y <= y1; y++)
+            {
+                for (ent = level.entityGrid[G_EntityGridBucket(x, y)]; ent && count < maxcount; ent = ent->nextInGrid)
+                {
+                    // other cells share the bucket, only report each entity from its own cell
+                    if (ent->gridCell[0] != x || ent->gridCell[1] != y)
+                        continue;
+
+                    if (G_EntityGridMatch(ent, mins, maxs, eType, team))
+                        list[count++] = ent;
+                }
+            }
+        }
+    }
+
+    qsort(list, count, sizeof(list[0]), G_CompareEntityNumbers);
+
+    return count;
+}
+
+/*
+===============
+G_EntitiesInRadius
+
+Like G_EntitiesInBox, for entities whose bounding box is within
+radius of origin
+===============
+*/
+int G_EntitiesInRadius(const vec3_t origin, float radius, int eType, team_t team, gentity_t **list, int maxcount)
+{
+    vec3_t mins, maxs, v;
+    int i, j, k, count;
+    gentity_t *ent;
+
+    for (i = 0; i < 3; i++)
+    {
+        mins[i] = origin[i] - radius;
+        maxs[i] = origin[i] + radius;
+    }
+
+    count = G_EntitiesInBox(mins, maxs, eType, team, list, maxcount);
+
+    // find the distance from the edge of the bounding box
+    for (i = j = 0; i < count; i++)
+    {
+        ent = list[i];
+
+        for (k = 0; k < 3; k++)
+        {
+            if (origin[k] < ent->r.currentOrigin[k] + ent->r.mins[k])
+                v[k] = ent->r.currentOrigin[k] + ent->r.mins[k] - origin[k];
+            else if (origin[k] > ent->r.currentOrigin[k] + ent->r.maxs[k])
+                v[k] = origin[k] - ent->r.currentOrigin[k] - ent->r.maxs[k];
+            else
+                v[k] = 0;
+        }
+
+        if (VectorLength(v) <= radius)
+            list[j++] = ent;
+    }
+
+    return j;
+}
+
+/*
+===============
+Trigger list
+
+Linked CONTENTS_TRIGGER entities are kept on a list of their own so
+touch checks don't have to sift through everything SV_AreaEntities
+returns.  level.triggerGeneration changes whenever a trigger is added,
+removed or moved, which lets callers keep what they found for a while.
+===============
+*/
+
+/*
+===============
+G_RemoveTrigger
+===============
+*/
+static void G_RemoveTrigger(gentity_t *ent)
+{
+    if (level.triggers != ent && !ent->prevTrigger)
+        return;
+
+    if (ent->prevTrigger)
+        ent->prevTrigger->nextTrigger = ent->nextTrigger;
+    else
+        level.triggers = ent->nextTrigger;
+    if (ent->nextTrigger)
+        ent->nextTrigger->prevTrigger = ent->prevTrigger;
+
+    ent->nextTrigger = ent->prevTrigger = NULL;
+    level.triggerGeneration++;
+}
+
+/*
+===============
+G_UpdateTrigger
+
+Called after ent has been linked
+===============
+*/
+static void G_UpdateTrigger(gentity_t *ent)
+{
+    gentity_t *prev, *next;
+
+    if (!(ent->r.contents & CONTENTS_TRIGGER))
+    {
+        G_RemoveTrigger(ent);
+        return;
+    }
+
+    if (level.triggers == ent || ent->prevTrigger)
+    {
+        if (!VectorCompare(ent->r.absmin, ent->triggerAbsmin) || !VectorCompare(ent->r.absmax, ent->triggerAbsmax))
+        {
+            VectorCopy(ent->r.absmin, ent->triggerAbsmin);
+            VectorCopy(ent->r.absmax, ent->triggerAbsmax);
+            level.triggerGeneration++;
+        }
+        return;
+    }
+
+    // keep entity number order, like a scan of g_entities
+    prev = NULL;
+    for (next = level.triggers; next && next < ent; next = next->nextTrigger)
+        prev = next;
+
+    ent->prevTrigger = prev;
+    ent->nextTrigger = next;
+    if (prev)
+        prev->nextTrigger = ent;
+    else
+        level.triggers = ent;
+    if (next)
+        next->prevTrigger = ent;
 
-        for (j = 0; j < 3; j++)
-            eorg[j] = org[j] - (from->r.currentOrigin[j] + (from->r.mins[j] + from->r.maxs[j]) * 0.5);
+    VectorCopy(ent->r.absmin, ent->triggerAbsmin);
+    VectorCopy(ent->r.absmax, ent->triggerAbsmax);
+    level.triggerGeneration++;
+}
+
+/*
+===============
+G_TriggersInBox
 
-        if (VectorLength(eorg) > rad)
+Fills list with the linked triggers whose absolute bounds touch the box
+===============
+*/
+int G_TriggersInBox(const vec3_t mins, const vec3_t maxs, gentity_t **list, int maxcount)
+{
+    gentity_t *ent;
+    int count = 0;
+
+    for (ent = level.triggers; ent && count < maxcount; ent = ent->nextTrigger)
+    {
+        if (ent->r.absmin[0] > maxs[0] || ent->r.absmin[1] > maxs[1] || ent->r.absmin[2] > maxs[2] ||
+            ent->r.absmax[0] < mins[0] || ent->r.absmax[1] < mins[1] || ent->r.absmax[2] < mins[2])
             continue;
 
-        return from;
+        list[count++] = ent;
     }
 
-    return NULL;
+    return count;
 }
 
 /*
@@ -1187,11 +1509,15 @@ void G_TraceCapsule( trace_t *results, const vec3_t start,
 void G_LinkEntity(gentity_t *gEnt)
 {
     SV_LinkEntity(static_cast<sharedEntity_t*>((void*)gEnt));
+    G_UpdateCreepSource(gEnt);
+    G_UpdateEntityGrid(gEnt);
+    G_UpdateTrigger(gEnt);
 }
 
 void G_UnlinkEntity(gentity_t *gEnt)
 {
     SV_UnlinkEntity(static_cast<sharedEntity_t*>((void*)gEnt));
+    G_RemoveTrigger(gEnt);
 }
 
 void G_AdjustAreaPortalState(gentity_t *ent, bool open)
@@ -0,0 +1,813 @@
+//
+// Deterministic Pmove replay harness and benchmark
+//
+// Loads a BSP through the cm_* code, replays usercmd streams for every
+// player class and compares the resulting playerState against golden
+// files.  Without -map a small test world is built in memory and loaded
+// through CM_LoadMap like any other map.
+//
+// pmove_replay [-map <bsp>] [-assets <dir>] [-golden <dir>] [-update]
+//              [-bench <passes>] <stream.cmds> ...
+//
+#include "qcommon/cm_public.h"
+#include "qcommon/cvar.h"
+#include "qcommon/files.h"
+#include "qcommon/q_shared.h"
+#include "qcommon/qcommon.h"
+#include "qcommon/qfiles.h"
+
+#include "game/bg_public.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern int c_pmove;
+
+static std::string assetsDir = "../../../assets";
+static std::vector<byte> builtinMap;
+
+#define BUILTIN_MAP "maps/pmove_test.bsp"
+
+/*
+======================================================================
+
+Engine services used by cm_* and bg_*
+
+======================================================================
+*/
+
+void Com_Error(int code, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    fprintf(stderr, "ERROR: ");
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+    exit(2);
+}
+
+void Com_Printf(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+void Com_DPrintf(const char *fmt, ...) {}
+
+void *Hunk_Alloc(int size, ha_pref preference) { return calloc(1, size); }
+void *Z_Malloc(int size) { return calloc(1, size); }
+void Z_Free(void *ptr) { free(ptr); }
+
+cvar_t *Cvar_Get(const char *var_name, const char *value, int flags)
+{
+    cvar_t *var = (cvar_t *)calloc(1, sizeof(cvar_t));
+
+    var->name = strdup(var_name);
+    var->string = strdup(value);
+    var->flags = flags;
+    var->value = atof(value);
+    var->integer = atoi(value);
+
+    return var;
+}
+
+void Cvar_VariableStringBuffer(const char *var_name, char *buffer, int bufsize)
+{
+    if (bufsize > 0)
+        buffer[0] = '\0';
+}
+
+static std::vector<FILE *> openFiles(1, nullptr);
+
+int FS_FOpenFileByMode(const char *qpath, fileHandle_t *f, enum FS_Mode mode)
+{
+    FILE *fp;
+    long len;
+
+    if (mode != FS_READ)
+        return -1;
+
+    fp = fopen((assetsDir + "/" + qpath).c_str(), "rb");
+    if (!fp)
+    {
+        if (f)
+            *f = 0;
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (!f)
+    {
+        fclose(fp);
+        return len;
+    }
+
+    *f = openFiles.size();
+    openFiles.push_back(fp);
+
+    return len;
+}
+
+int FS_Read(void *buffer, int len, fileHandle_t f)
+{
+    return fread(buffer, 1, len, openFiles[f]);
+}
+
+void FS_FCloseFile(fileHandle_t f)
+{
+    if (f > 0 && openFiles[f])
+    {
+        fclose(openFiles[f]);
+        openFiles[f] = nullptr;
+    }
+}
+
+int FS_GetFileList(const char *path, const char *extension, char *listbuf, int bufsize) { return 0; }
+
+long FS_ReadFile(const char *qpath, void **buffer)
+{
+    FILE *fp;
+    long len;
+
+    if (!strcmp(qpath, BUILTIN_MAP))
+    {
+        *buffer = malloc(builtinMap.size());
+        memcpy(*buffer, builtinMap.data(), builtinMap.size());
+        return builtinMap.size();
+    }
+
+    *buffer = nullptr;
+
+    fp = fopen(qpath, "rb");
+    if (!fp)
+        return -1;
+
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    *buffer = malloc(len + 1);
+    if (fread(*buffer, 1, len, fp) != (size_t)len)
+    {
+        free(*buffer);
+        *buffer = nullptr;
+        len = -1;
+    }
+    fclose(fp);
+
+    return len;
+}
+
+void FS_FreeFile(void *buffer) { free(buffer); }
+
+/*
+======================================================================
+
+Built in test world
+
+A closed room with stairs, a walkable and a too steep ramp, a pillar,
+a water pool, a low ceiling for crouching and a slick pad.
+
+======================================================================
+*/
+
+enum { SHADER_SOLID, SHADER_WATER, SHADER_SLICK, NUM_SHADERS };
+
+struct mapBuilder_t
+{
+    std::vector<dplane_t> planes;
+    std::vector<dbrushside_t> sides;
+    std::vector<dbrush_t> brushes;
+};
+
+/*
+===============
+MB_AddPlane
+
+Planes come in pairs, x ^ 1 is always the opposite of x
+===============
+*/
+static int MB_AddPlane(mapBuilder_t *mb, float nx, float ny, float nz, float dist)
+{
+    dplane_t p = {{nx, ny, nz}, dist};
+    dplane_t back = {{-nx, -ny, -nz}, -dist};
+
+    mb->planes.push_back(p);
+    mb->planes.push_back(back);
+
+    return mb->planes.size() - 2;
+}
+
+/*
+===============
+MB_AddBrush
+
+An axial box, optionally cut by one more plane.  The six axial sides come
+first since CM_BoundBrush takes the bounds from them.
+===============
+*/
+static void MB_AddBrush(mapBuilder_t *mb, int shader, float x0, float y0, float z0, float x1, float y1, float z1,
+    const dplane_t *cut = nullptr)
+{
+    dbrush_t brush;
+    int planes[7];
+    int numSides = 6;
+
+    planes[0] = MB_AddPlane(mb, -1, 0, 0, -x0);
+    planes[1] = MB_AddPlane(mb, 1, 0, 0, x1);
+    planes[2] = MB_AddPlane(mb, 0, -1, 0, -y0);
+    planes[3] = MB_AddPlane(mb, 0, 1, 0, y1);
+    planes[4] = MB_AddPlane(mb, 0, 0, -1, -z0);
+    planes[5] = MB_AddPlane(mb, 0, 0, 1, z1);
+
+    if (cut)
+        planes[numSides++] = MB_AddPlane(mb, cut->normal[0], cut->normal[1], cut->normal[2], cut->dist);
+
+    brush.firstSide = mb->sides.size();
+    brush.numSides = numSides;
+    brush.shaderNum = shader;
+
+    for (int i = 0; i < numSides; i++)
+    {
+        dbrushside_t side = {planes[i], shader};
+        mb->sides.push_back(side);
+    }
+
+    mb->brushes.push_back(brush);
+}
+
+/*
+===============
+MB_AddRamp
+
+A ramp rising along +x at the given angle
+===============
+*/
+static void MB_AddRamp(mapBuilder_t *mb, float x0, float y0, float x1, float y1, float angle)
+{
+    float rad = DEG2RAD(angle);
+    dplane_t cut = {{-sinf(rad), 0, cosf(rad)}, -sinf(rad) * x0};
+
+    MB_AddBrush(mb, SHADER_SOLID, x0, y0, 0, x1, y1, (x1 - x0) * tanf(rad), &cut);
+}
+
+template <typename T>
+static void MB_WriteLump(std::vector<byte> &out, dheader_t *header, int lump, const T *data, size_t count)
+{
+    header->lumps[lump].fileofs = out.size();
+    header->lumps[lump].filelen = count * sizeof(T);
+    out.insert(out.end(), (const byte *)data, (const byte *)(data + count));
+
+    while (out.size() & 3)
+        out.push_back(0);
+}
+
+/*
+===============
+BuildTestMap
+
+Everything sits in one leaf behind a single node.  The maps the game ships
+have a real BSP tree, but the collision code does not care for this test.
+===============
+*/
+static void BuildTestMap(void)
+{
+    mapBuilder_t mb;
+    dheader_t header;
+    dshader_t shaders[NUM_SHADERS];
+    dnode_t node;
+    dleaf_t leafs[2];
+    dmodel_t world;
+    std::vector<int> leafBrushes;
+    const char *entities = "{\n\"classname\" \"worldspawn\"\n}\n";
+
+    // room
+    MB_AddBrush(&mb, SHADER_SOLID, -1024, -1024, -64, 1024, 1024, 0);
+    MB_AddBrush(&mb, SHADER_SOLID, -1024, -1024, 512, 1024, 1024, 576);
+    MB_AddBrush(&mb, SHADER_SOLID, -1088, -1024, 0, -1024, 1024, 512);
+    MB_AddBrush(&mb, SHADER_SOLID, 1024, -1024, 0, 1088, 1024, 512);
+    MB_AddBrush(&mb, SHADER_SOLID, -1088, -1088, 0, 1088, -1024, 512);
+    MB_AddBrush(&mb, SHADER_SOLID, -1088, 1024, 0, 1088, 1088, 512);
+
+    // stairs
+    for (int i = 0; i < 4; i++)
+        MB_AddBrush(&mb, SHADER_SOLID, 128 + 32 * i, -768, 0, 384, -512, 16 * (i + 1));
+
+    // ramps
+    MB_AddRamp(&mb, 128, 256, 384, 512, 30.0f);
+    MB_AddRamp(&mb, 512, 256, 640, 512, 60.0f);
+
+    // pillar
+    MB_AddBrush(&mb, SHADER_SOLID, -64, 384, 0, 64, 448, 512);
+
+    // low ceiling
+    MB_AddBrush(&mb, SHADER_SOLID, -768, 256, 48, -512, 512, 512);
+
+    // water
+    MB_AddBrush(&mb, SHADER_WATER, -768, -768, 0, -384, -384, 128);
+
+    // slick pad
+    MB_AddBrush(&mb, SHADER_SLICK, 512, -768, 0, 768, -512, 2);
+
+    memset(shaders, 0, sizeof(shaders));
+    Q_strncpyz(shaders[SHADER_SOLID].shader, "textures/common/caulk", MAX_QPATH);
+    shaders[SHADER_SOLID].contentFlags = CONTENTS_SOLID;
+    Q_strncpyz(shaders[SHADER_WATER].shader, "textures/common/water", MAX_QPATH);
+    shaders[SHADER_WATER].contentFlags = CONTENTS_WATER;
+    shaders[SHADER_WATER].surfaceFlags = SURF_NONSOLID;
+    Q_strncpyz(shaders[SHADER_SLICK].shader, "textures/common/slick", MAX_QPATH);
+    shaders[SHADER_SLICK].contentFlags = CONTENTS_SOLID;
+    shaders[SHADER_SLICK].surfaceFlags = SURF_SLICK;
+
+    for (size_t i = 0; i < mb.brushes.size(); i++)
+        leafBrushes.push_back(i);
+
+    memset(leafs, 0, sizeof(leafs));
+    leafs[0].numLeafBrushes = leafBrushes.size();
+    leafs[1].cluster = -1;
+
+    node.planeNum = MB_AddPlane(&mb, 1, 0, 0, MIN_WORLD_COORD);
+    node.children[0] = -1;
+    node.children[1] = -2;
+    VectorSet(node.mins, -1088, -1088, -64);
+    VectorSet(node.maxs, 1088, 1088, 576);
+
+    VectorSet(world.mins, -1088, -1088, -64);
+    VectorSet(world.maxs, 1088, 1088, 576);
+    world.firstSurface = world.numSurfaces = 0;
+    world.firstBrush = 0;
+    world.numBrushes = mb.brushes.size();
+
+    memset(&header, 0, sizeof(header));
+    header.ident = BSP_IDENT;
+    header.version = BSP_VERSION;
+
+    builtinMap.assign(sizeof(header), 0);
+    MB_WriteLump(builtinMap, &header, LUMP_ENTITIES, entities, strlen(entities) + 1);
+    MB_WriteLump(builtinMap, &header, LUMP_SHADERS, shaders, NUM_SHADERS);
+    MB_WriteLump(builtinMap, &header, LUMP_PLANES, mb.planes.data(), mb.planes.size());
+    MB_WriteLump(builtinMap, &header, LUMP_NODES, &node, 1);
+    MB_WriteLump(builtinMap, &header, LUMP_LEAFS, leafs, 2);
+    MB_WriteLump(builtinMap, &header, LUMP_LEAFBRUSHES, leafBrushes.data(), leafBrushes.size());
+    MB_WriteLump(builtinMap, &header, LUMP_MODELS, &world, 1);
+    MB_WriteLump(builtinMap, &header, LUMP_BRUSHES, mb.brushes.data(), mb.brushes.size());
+    MB_WriteLump(builtinMap, &header, LUMP_BRUSHSIDES, mb.sides.data(), mb.sides.size());
+    memcpy(builtinMap.data(), &header, sizeof(header));
+}
+
+/*
+======================================================================
+
+Usercmd streams
+
+One command per line, repeated <frames> times:
+
+  <frames> <msec> <forward> <right> <up> <pitch> <yaw> <buttons>
+
+where buttons is "-" or a "+" separated list of button names.
+
+  spawn <x> <y> <z>     floor position the player starts on
+  yaw <degrees>         starting view yaw
+
+======================================================================
+*/
+
+struct stream_t
+{
+    std::string name;
+    vec3_t spawn;
+    float yaw;
+    std::vector<usercmd_t> cmds;
+    std::vector<int> msecs;
+};
+
+static const struct
+{
+    const char *name;
+    int button;
+} buttonNames[] = {
+    {"attack", BUTTON_ATTACK},
+    {"attack2", BUTTON_ATTACK2},
+    {"use", BUTTON_USE_HOLDABLE},
+    {"gesture", BUTTON_GESTURE},
+    {"walking", BUTTON_WALKING},
+    {"dodge", BUTTON_DODGE},
+    {"evolve", BUTTON_USE_EVOLVE},
+    {"sprint", BUTTON_SPRINT},
+};
+
+static bool ParseButtons(char *list, int *buttons)
+{
+    *buttons = 0;
+
+    if (!strcmp(list, "-"))
+        return true;
+
+    for (char *name = strtok(list, "+"); name; name = strtok(nullptr, "+"))
+    {
+        size_t i;
+
+        for (i = 0; i < ARRAY_LEN(buttonNames); i++)
+        {
+            if (!Q_stricmp(name, buttonNames[i].name))
+            {
+                *buttons |= buttonNames[i].button;
+                break;
+            }
+        }
+
+        if (i == ARRAY_LEN(buttonNames))
+            return false;
+    }
+
+    return true;
+}
+
+static bool LoadStream(const char *path, stream_t *stream)
+{
+    FILE *fp = fopen(path, "r");
+    char line[256];
+    int lineNum = 0;
+
+    if (!fp)
+    {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+
+    stream->name = COM_SkipPath((char *)path);
+    if (stream->name.rfind('.') != std::string::npos)
+        stream->name.erase(stream->name.rfind('.'));
+    VectorClear(stream->spawn);
+    stream->yaw = 0.0f;
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        int frames, msec, forward, right, up;
+        float pitch, yaw;
+        char buttons[128];
+        usercmd_t cmd;
+
+        lineNum++;
+
+        if (line[strspn(line, " \t\r\n")] == '\0' || line[strspn(line, " \t")] == '#')
+            continue;
+
+        if (sscanf(line, "spawn %f %f %f", &stream->spawn[0], &stream->spawn[1], &stream->spawn[2]) == 3)
+            continue;
+
+        if (sscanf(line, "yaw %f", &stream->yaw) == 1)
+            continue;
+
+        memset(&cmd, 0, sizeof(cmd));
+
+        if (sscanf(line, "%d %d %d %d %d %f %f %127s", &frames, &msec, &forward, &right, &up, &pitch, &yaw,
+                buttons) != 8 ||
+            !ParseButtons(buttons, &cmd.buttons))
+        {
+            fprintf(stderr, "%s:%d: bad command\n", path, lineNum);
+            fclose(fp);
+            return false;
+        }
+
+        cmd.forwardmove = forward;
+        cmd.rightmove = right;
+        cmd.upmove = up;
+        cmd.angles[PITCH] = ANGLE2SHORT(pitch);
+        cmd.angles[YAW] = ANGLE2SHORT(yaw);
+
+        for (int i = 0; i < frames; i++)
+        {
+            stream->cmds.push_back(cmd);
+            stream->msecs.push_back(msec);
+        }
+    }
+
+    fclose(fp);
+    return true;
+}
+
+/*
+======================================================================
+
+Replay
+
+======================================================================
+*/
+
+static void Replay_Trace(trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end,
+    int passEntityNum, int contentmask)
+{
+    CM_BoxTrace(results, start, end, mins, maxs, 0, contentmask, TT_AABB);
+    results->entityNum = results->fraction != 1.0f ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+}
+
+static int Replay_PointContents(const vec3_t point, int passEntityNum) { return CM_PointContents(point, 0); }
+
+static unsigned HashBytes(unsigned hash, const void *data, size_t size)
+{
+    const byte *p = (const byte *)data;
+
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ p[i]) * 16777619u;
+
+    return hash;
+}
+
+/*
+===============
+HashState
+
+Only fields Pmove writes; padding in playerState_t is not hashed
+===============
+*/
+static unsigned HashState(unsigned hash, const playerState_t *ps)
+{
+    hash = HashBytes(hash, ps->origin, sizeof(ps->origin));
+    hash = HashBytes(hash, ps->velocity, sizeof(ps->velocity));
+    hash = HashBytes(hash, ps->viewangles, sizeof(ps->viewangles));
+    hash = HashBytes(hash, ps->grapplePoint, sizeof(ps->grapplePoint));
+    hash = HashBytes(hash, &ps->pm_type, sizeof(ps->pm_type));
+    hash = HashBytes(hash, &ps->pm_flags, sizeof(ps->pm_flags));
+    hash = HashBytes(hash, &ps->pm_time, sizeof(ps->pm_time));
+    hash = HashBytes(hash, &ps->groundEntityNum, sizeof(ps->groundEntityNum));
+    hash = HashBytes(hash, &ps->eFlags, sizeof(ps->eFlags));
+    hash = HashBytes(hash, &ps->movementDir, sizeof(ps->movementDir));
+    hash = HashBytes(hash, &ps->legsAnim, sizeof(ps->legsAnim));
+    hash = HashBytes(hash, &ps->legsTimer, sizeof(ps->legsTimer));
+    hash = HashBytes(hash, &ps->torsoAnim, sizeof(ps->torsoAnim));
+    hash = HashBytes(hash, &ps->torsoTimer, sizeof(ps->torsoTimer));
+    hash = HashBytes(hash, &ps->viewheight, sizeof(ps->viewheight));
+    hash = HashBytes(hash, &ps->weaponstate, sizeof(ps->weaponstate));
+    hash = HashBytes(hash, &ps->weaponTime, sizeof(ps->weaponTime));
+    hash = HashBytes(hash, &ps->eventSequence, sizeof(ps->eventSequence));
+    hash = HashBytes(hash, ps->events, sizeof(ps->events));
+    hash = HashBytes(hash, ps->eventParms, sizeof(ps->eventParms));
+    hash = HashBytes(hash, ps->stats, sizeof(ps->stats));
+
+    return hash;
+}
+
+/*
+===============
+ReplayClass
+
+Spawns a player of the given class the way ClientSpawn does and feeds it
+the stream.  Returns the number of Pmove calls made.
+===============
+*/
+static int ReplayClass(const stream_t *stream, class_t klass, playerState_t *ps, unsigned *hash)
+{
+    const classAttributes_t *ca = BG_Class(klass);
+    pmoveExt_t pmext;
+    pmove_t pm;
+    trace_t tr;
+    vec3_t mins, maxs;
+    weapon_t weapon;
+    team_t team;
+    int serverTime = 0;
+
+    memset(ps, 0, sizeof(*ps));
+    memset(&pmext, 0, sizeof(pmext));
+    srand(0);
+
+    if (klass == PCL_HUMAN || klass == PCL_HUMAN_BSUIT)
+    {
+        team = TEAM_HUMANS;
+        weapon = WP_MACHINEGUN;
+    }
+    else
+    {
+        team = TEAM_ALIENS;
+        weapon = ca->startWeapon;
+    }
+
+    BG_ClassBoundingBox(klass, mins, maxs, NULL, NULL, NULL);
+
+    ps->pm_type = PM_NORMAL;
+    ps->clientNum = 0;
+    ps->stats[STAT_CLASS] = klass;
+    ps->stats[STAT_TEAM] = team;
+    ps->stats[STAT_MAX_HEALTH] = ps->stats[STAT_HEALTH] = ca->health;
+    ps->stats[STAT_STAMINA] = STAMINA_MAX;
+    ps->stats[STAT_BUILDABLE] = BA_NONE;
+    ps->stats[STAT_WEAPON] = ps->weapon = weapon;
+    ps->ammo = BG_Weapon(weapon)->maxAmmo;
+    ps->clips = BG_Weapon(weapon)->maxClips;
+    ps->weaponstate = WEAPON_READY;
+    ps->groundEntityNum = ENTITYNUM_NONE;
+    ps->gravity = 800;
+    ps->speed = 320 * ca->speed;
+    VectorSet(ps->grapplePoint, 0.0f, 0.0f, 1.0f);
+    VectorCopy(stream->spawn, ps->origin);
+    ps->origin[2] += 1.0f - mins[2];
+    ps->delta_angles[YAW] = ANGLE2SHORT(stream->yaw);
+
+    Replay_Trace(&tr, ps->origin, mins, maxs, ps->origin, 0, MASK_PLAYERSOLID);
+    if (tr.startsolid)
+        Com_Printf("WARNING: %s spawns %s in solid\n", stream->name.c_str(), ca->name);
+
+    *hash = 2166136261u;
+
+    for (size_t i = 0; i < stream->cmds.size(); i++)
+    {
+        memset(&pm, 0, sizeof(pm));
+        pmext.fallVelocity = 0.0f;
+
+        serverTime += stream->msecs[i];
+
+        pm.ps = ps;
+        pm.pmext = &pmext;
+        pm.cmd = stream->cmds[i];
+        pm.cmd.serverTime = serverTime;
+        pm.tracemask = MASK_PLAYERSOLID;
+        pm.trace = Replay_Trace;
+        pm.pointcontents = Replay_PointContents;
+        pm.pmove_msec = 8;
+
+        Pmove(&pm);
+
+        *hash = HashState(*hash, ps);
+    }
+
+    return stream->cmds.size();
+}
+
+static std::vector<std::string> ReplayStream(const stream_t *stream, int *calls)
+{
+    std::vector<std::string> lines;
+    playerState_t ps;
+    unsigned hash;
+
+    for (int klass = PCL_NONE + 1; klass < PCL_NUM_CLASSES; klass++)
+    {
+        *calls += ReplayClass(stream, (class_t)klass, &ps, &hash);
+
+        lines.push_back(va("%s origin %.9g %.9g %.9g velocity %.9g %.9g %.9g viewangles %.9g %.9g %.9g "
+                           "pm_flags 0x%x ground %d eFlags 0x%x state 0x%x stamina %d viewheight %d hash %08x",
+            BG_Class((class_t)klass)->name, ps.origin[0], ps.origin[1], ps.origin[2], ps.velocity[0], ps.velocity[1],
+            ps.velocity[2], ps.viewangles[0], ps.viewangles[1], ps.viewangles[2], ps.pm_flags, ps.groundEntityNum,
+            ps.eFlags, ps.stats[STAT_STATE], ps.stats[STAT_STAMINA], ps.viewheight, hash));
+    }
+
+    return lines;
+}
+
+/*
+===============
+CheckGolden
+
+Returns false when the replay does not match the golden file
+===============
+*/
+static bool CheckGolden(const std::string &path, const std::vector<std::string> &lines, bool update)
+{
+    std::vector<std::string> golden;
+    char line[1024];
+    bool ok = true;
+    FILE *fp;
+
+    if (update)
+    {
+        fp = fopen(path.c_str(), "w");
+        if (!fp)
+        {
+            fprintf(stderr, "%s: cannot write\n", path.c_str());
+            return false;
+        }
+
+        for (const std::string &l : lines)
+            fprintf(fp, "%s\n", l.c_str());
+
+        fclose(fp);
+        printf("%s: updated\n", path.c_str());
+        return true;
+    }
+
+    fp = fopen(path.c_str(), "r");
+    if (!fp)
+    {
+        fprintf(stderr, "%s: missing, run with -update to create it\n", path.c_str());
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        golden.push_back(line);
+    }
+    fclose(fp);
+
+    for (size_t i = 0; i < lines.size() || i < golden.size(); i++)
+    {
+        const char *want = i < golden.size() ? golden[i].c_str() : "(none)";
+        const char *got = i < lines.size() ? lines[i].c_str() : "(none)";
+
+        if (strcmp(want, got))
+        {
+            printf("%s:%zu: mismatch\n  want: %s\n  got:  %s\n", path.c_str(), i + 1, want, got);
+            ok = false;
+        }
+    }
+
+    printf("%s: %s\n", path.c_str(), ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static void Usage(void)
+{
+    fprintf(stderr,
+        "usage: pmove_replay [-map <bsp>] [-assets <dir>] [-golden <dir>] [-update] [-bench <passes>] "
+        "<stream.cmds> ...\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *mapName = BUILTIN_MAP;
+    std::string goldenDir = "pmove";
+    std::vector<stream_t> streams;
+    bool update = false;
+    int passes = 0;
+    int checksum;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-map") && i + 1 < argc)
+            mapName = argv[++i];
+        else if (!strcmp(argv[i], "-assets") && i + 1 < argc)
+            assetsDir = argv[++i];
+        else if (!strcmp(argv[i], "-golden") && i + 1 < argc)
+            goldenDir = argv[++i];
+        else if (!strcmp(argv[i], "-update"))
+            update = true;
+        else if (!strcmp(argv[i], "-bench") && i + 1 < argc)
+            passes = atoi(argv[++i]);
+        else if (argv[i][0] == '-')
+            Usage();
+        else
+        {
+            streams.emplace_back();
+            if (!LoadStream(argv[i], &streams.back()))
+                return 2;
+        }
+    }
+
+    if (streams.empty())
+        Usage();
+
+    BG_InitClassConfigs();
+
+    if (!strcmp(mapName, BUILTIN_MAP))
+        BuildTestMap();
+    CM_LoadMap(mapName, false, &checksum);
+
+    for (const stream_t &stream : streams)
+    {
+        std::string mapBase = COM_SkipPath((char *)mapName);
+        std::string path;
+        int calls = 0;
+
+        mapBase.erase(mapBase.rfind('.') != std::string::npos ? mapBase.rfind('.') : mapBase.size());
+        path = goldenDir + "/" + stream.name + "." + mapBase + ".golden";
+
+        if (!CheckGolden(path, ReplayStream(&stream, &calls), update))
+            failed++;
+    }
+
+    if (passes > 0)
+    {
+        int calls = 0;
+        int singles = c_pmove;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int pass = 0; pass < passes; pass++)
+        {
+            for (const stream_t &stream : streams)
+                ReplayStream(&stream, &calls);
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        singles = c_pmove - singles;
+        printf("%d Pmove calls (%d PmoveSingle) in %.3f s: %.0f calls/sec, %.0f PmoveSingle/sec\n", calls, singles,
+            elapsed.count(), calls / elapsed.count(), singles / elapsed.count());
+    }
+
+    return failed ? 1 : 0;
+}
@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "autocomplete.h"
 #include "cvar.h"
 #include "files.h"
+#include "nameindex.h"
 #include "q_shared.h"
 #include "qcommon.h"
 
@@ -54,6 +55,7 @@ byte cmd_text_buf[MAX_CMD_BUFFER];
 struct cmd_function_t {
     cmd_function_t *next;
     char *name;
+    unsigned int hash;  // NameIndex_Hash( name )
     xcommand_t function;
     completionFunc_t complete;
 };
@@ -68,6 +70,7 @@ struct cmdContext_t {
 static cmdContext_t cmd;
 static cmdContext_t savedCmd;
 static cmd_function_t *cmd_functions;  // possible commands to execute
+static nameIndex_t cmd_index;  // cmd_functions by name
 
 //=============================================================================
 
@@ -715,11 +718,7 @@ Cmd_FindCommand
 */
 cmd_function_t *Cmd_FindCommand(const char *cmd_name)
 {
-    cmd_function_t *cmd;
-    for (cmd = cmd_functions; cmd; cmd = cmd->next)
-        if (!Q_stricmp(cmd_name, cmd->name))
-            return cmd;
-    return nullptr;
+    return static_cast<cmd_function_t *>(NameIndex_Find(&cmd_index, cmd_name, NameIndex_Hash(cmd_name)));
 }
 
 /*
@@ -750,10 +749,12 @@ void Cmd_AddCommand(const char *cmd_name, xcommand_t function)
     // use a small malloc to avoid zone fragmentation
     cmd = new cmd_function_t;
     cmd->name = CopyString(cmd_name);
+    cmd->hash = NameIndex_Hash(cmd->name);
     cmd->function = function;
     cmd->complete = nullptr;
     cmd->next = cmd_functions;
     cmd_functions = cmd;
+    NameIndex_Insert(&cmd_index, cmd->name, cmd->hash, cmd);
 }
 
 /*
@@ -763,16 +764,10 @@ Cmd_SetCommandCompletionFunc
 */
 void Cmd_SetCommandCompletionFunc(const char *command, completionFunc_t complete)
 {
-    cmd_function_t *cmd;
+    cmd_function_t *cmd = Cmd_FindCommand(command);
 
-    for (cmd = cmd_functions; cmd; cmd = cmd->next)
-    {
-        if (!Q_stricmp(command, cmd->name))
-        {
-            cmd->complete = complete;
-            return;
-        }
-    }
+    if (cmd)
+        cmd->complete = complete;
 }
 
 /*
@@ -796,6 +791,7 @@ void Cmd_RemoveCommand(const char *cmd_name)
         if (!strcmp(cmd_name, cmd->name))
         {
             *back = cmd->next;
+            NameIndex_Remove(&cmd_index, cmd->name, cmd->hash);
             if (cmd->name)
             {
                 Z_Free(cmd->name);
@@ -864,9 +860,9 @@ void Cmd_CompleteArgument(const char *command, char *args, int argNum)
 #endif
 #endif
     // Call local completion if VM doesn't pick up
-    for (cmd = cmd_functions; cmd; cmd = cmd->next)
-        if (!Q_stricmp(command, cmd->name) && cmd->complete)
-            cmd->complete(args, argNum);
+    cmd = Cmd_FindCommand(command);
+    if (cmd && cmd->complete)
+        cmd->complete(args, argNum);
 }
 
 /*
@@ -878,7 +874,7 @@ A complete command line has been parsed, so try to execute it
 */
 void Cmd_ExecuteString(const char *text)
 {
-    cmd_function_t *cmdFunc, **prev;
+    cmd_function_t *cmdFunc;
 
     // execute the command line
     Cmd_TokenizeString(text);
@@ -889,30 +885,14 @@ void Cmd_ExecuteString(const char *text)
     }
 
     // check registered command functions
-    for (prev = &cmd_functions; *prev; prev = &cmdFunc->next)
+    cmdFunc = Cmd_FindCommand(cmd.argv[0]);
+    if (cmdFunc && cmdFunc->function)
     {
-        cmdFunc = *prev;
-        if (!Q_stricmp(cmd.argv[0], cmdFunc->name))
-        {
-            // rearrange the links so that the command will be
-            // near the head of the list next time it is used
-            *prev = cmdFunc->next;
-            cmdFunc->next = cmd_functions;
-            cmd_functions = cmdFunc;
-
-            // perform the action
-            if (!cmdFunc->function)
-            {
-                // let the cgame or game handle it
-                break;
-            }
-            else
-            {
-                cmdFunc->function();
-            }
-            return;
-        }
+        // perform the action
+        cmdFunc->function();
+        return;
     }
+    // commands without a function are handled by the cgame or game
 
     // check cvars
     if (Cvar_Command())
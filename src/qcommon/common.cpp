@@ -55,8 +55,10 @@ int demo_protocols[] = { PROTOCOL_VERSION, 70, 69, 0 };
 #define MIN_COMHUNKMEGS  256
 #define DEF_COMHUNKMEGS  256
 #define DEF_COMZONEMEGS  48
+#define DEF_COMFRAMEMEGS 4
 #define DEF_COMHUNKMEGS_S XSTRING(DEF_COMHUNKMEGS)
 #define DEF_COMZONEMEGS_S XSTRING(DEF_COMZONEMEGS)
+#define DEF_COMFRAMEMEGS_S XSTRING(DEF_COMFRAMEMEGS)
 
 int com_argc;
 char* com_argv[MAX_NUM_ARGVS+1];
@@ -81,7 +83,7 @@ cvar_t *com_altivec;
 cvar_t *com_timedemo;
 cvar_t *com_sv_running;
 cvar_t *com_cl_running;
-cvar_t *com_logfile;  // 1 = buffer log, 2 = flush after each print
+cvar_t *com_logfile;  // 1 = buffer log, 2 = flush every frame
 cvar_t *com_pipefile;
 cvar_t *com_showtrace;
 cvar_t *com_version;
@@ -153,6 +155,33 @@ void Com_EndRedirect(void)
     rd_flush = NULL;
 }
 
+/*
+=============
+Com_LogFlush
+
+Lines for qconsole.log are collected in com_logBuffer and written out once
+a frame, so a busy server does one write per frame instead of one per line
+=============
+*/
+#define LOG_BUFFER_SIZE 0x10000
+
+static char com_logBuffer[LOG_BUFFER_SIZE];
+static int com_logBufferLen;
+
+void Com_LogFlush( void )
+{
+    if ( !com_logBufferLen )
+        return;
+
+    if ( logfile && FS_Initialized() ) {
+        FS_Write( com_logBuffer, com_logBufferLen, logfile );
+        if ( com_logfile->integer > 1 )
+            FS_Flush( logfile );
+    }
+
+    com_logBufferLen = 0;
+}
+
 /*
 =============
 Com_Printf
@@ -215,13 +244,6 @@ void Com_Printf( const char *fmt, ... )
             if(logfile)
             {
                 Com_Printf( "logfile opened on %s\n", asctime( newtime ) );
-
-                if ( com_logfile->integer > 1 )
-                {
-                    // force it to not buffer so we get valid
-                    // data even if we are crashing
-                    FS_ForceFlush(logfile);
-                }
             }
             else
             {
@@ -232,7 +254,12 @@ void Com_Printf( const char *fmt, ... )
             opening_qconsole = false;
         }
         if ( logfile && FS_Initialized()) {
-            FS_Write(msg, strlen(msg), logfile);
+            int len = strlen( msg );
+
+            if ( com_logBufferLen + len > LOG_BUFFER_SIZE )
+                Com_LogFlush();
+            memcpy( com_logBuffer + com_logBufferLen, msg, len );
+            com_logBufferLen += len;
         }
     }
 }
@@ -314,6 +341,7 @@ void QDECL Com_Error( int code, const char *fmt, ... )
         CL_FlushMemory( );
         // make sure we can get at our local stuff
         FS_PureServerSetLoadedPaks("", "");
+        Com_LogFlush();
         com_errorEntered = false;
         longjmp (abortframe, -1);
     }
@@ -324,6 +352,7 @@ void QDECL Com_Error( int code, const char *fmt, ... )
         CL_Disconnect( true );
         CL_FlushMemory( );
         FS_PureServerSetLoadedPaks("", "");
+        Com_LogFlush();
         com_errorEntered = false;
 
         static int reconnectCount = 0;
@@ -753,12 +782,24 @@ The rover can be left pointing at a non-empty block
 
 The zone calls are pretty much only used for small strings and structures,
 all big things are allocated on the hunk.
+
+Allocations of up to SLAB_MAX_CHUNK bytes (header included) never walk the
+block list.  They are rounded up to a size class and served from slab pages,
+which are ordinary TAG_SLAB blocks of the same zone cut into equal chunks.
+Each chunk keeps a full memblock_t header, so Z_Free and the trash tester
+work the same for both, and chunks in use are kept on a list per tag for
+Z_FreeTags.  Slab pages are never given back to the zone.
 ==============================================================================
 */
 
 #define ZONEID 0x1d4a11
+#define SLABID 0x1d4a12
 #define MINFRAGMENT 64
 
+#define SLAB_PAGE_SIZE 8192
+#define SLAB_GRANULARITY 16
+#define SLAB_MAX_CHUNK 640
+
 typedef struct zonedebug_s {
     const char *label;
     const char *file;
@@ -770,19 +811,40 @@ typedef struct memblock_s {
     int size;           // including the header and possibly tiny fragments
     int tag;            // a tag of 0 is a free block
     struct memblock_s       *next, *prev;
-    int id;          // should be ZONEID
+    int id;          // should be ZONEID, or SLABID for slab chunks
 #ifdef ZONE_DEBUG
     zonedebug_t d;
 #endif
 } memblock_t;
 
+// chunk sizes including header and trash tester, multiples of SLAB_GRANULARITY
+static const int slabChunkSizes[] = {
+    48, 64, 80, 96, 128, 160, 192, 256, 320, 384, 512, SLAB_MAX_CHUNK
+};
+
+#define NUM_SLAB_CLASSES ARRAY_LEN( slabChunkSizes )
+
+typedef struct {
+    memblock_t *freelist;   // linked through next
+    int pages;
+    int chunks;             // total chunks in all pages
+    int used;               // chunks handed out
+    int highwater;
+} memslab_t;
+
 typedef struct {
     int size;   // total bytes malloced, including header
     int used;   // total bytes used
     memblock_t blocklist; // start / end cap for linked list
     memblock_t *rover;
+    memslab_t slabs[NUM_SLAB_CLASSES];
+    memblock_t slabInUse[TAG_MAX]; // start / end caps for the chunks of each tag
+    int slabTagBytes[TAG_MAX];
 } memzone_t;
 
+// size class for each SLAB_GRANULARITY step up to SLAB_MAX_CHUNK
+static byte slabClassForSize[SLAB_MAX_CHUNK / SLAB_GRANULARITY];
+
 // main zone for all "dynamic" memory allocation
 memzone_t *mainzone;
 // we also have a small zone for small allocations that would only
@@ -799,6 +861,7 @@ Z_ClearZone
 void Z_ClearZone( memzone_t *zone, int size )
 {
     memblock_t *block;
+    int i, c;
 
     // set the entire zone to one free block
 
@@ -815,6 +878,23 @@ void Z_ClearZone( memzone_t *zone, int size )
     block->tag = 0; // free block
     block->id = ZONEID;
     block->size = size - sizeof(memzone_t);
+
+    // no slab pages yet
+    ::memset( zone->slabs, 0, sizeof( zone->slabs ) );
+    for ( i = 0; i < TAG_MAX; i++ ) {
+        zone->slabInUse[i].next = zone->slabInUse[i].prev = &zone->slabInUse[i];
+        zone->slabInUse[i].tag = i;
+        zone->slabInUse[i].id = 0;
+        zone->slabInUse[i].size = 0;
+        zone->slabTagBytes[i] = 0;
+    }
+
+    for ( i = 0, c = 0; i < (int)ARRAY_LEN( slabClassForSize ); i++ ) {
+        while ( ( i + 1 ) * SLAB_GRANULARITY > slabChunkSizes[c] ) {
+            c++;
+        }
+        slabClassForSize[i] = c;
+    }
 }
 
 /*
@@ -837,6 +917,38 @@ int Z_AvailableMemory( void )
     return Z_AvailableZoneMemory( mainzone );
 }
 
+/*
+========================
+Z_SlabForSize
+========================
+*/
+static memslab_t *Z_SlabForSize( memzone_t *zone, int size )
+{
+    return &zone->slabs[ slabClassForSize[ ( size - 1 ) / SLAB_GRANULARITY ] ];
+}
+
+/*
+========================
+Z_SlabFree
+
+Puts a chunk back on the free list of its size class
+========================
+*/
+static void Z_SlabFree( memzone_t *zone, memblock_t *block )
+{
+    memslab_t *slab = Z_SlabForSize( zone, block->size );
+
+    block->prev->next = block->next;
+    block->next->prev = block->prev;
+    zone->slabTagBytes[block->tag] -= block->size;
+
+    block->tag = 0; // mark as free
+    block->prev = NULL;
+    block->next = slab->freelist;
+    slab->freelist = block;
+    slab->used--;
+}
+
 /*
 ========================
 Z_Free
@@ -853,7 +965,7 @@ void Z_Free( void *ptr )
     }
 
     block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
-    if (block->id != ZONEID) {
+    if (block->id != ZONEID && block->id != SLABID) {
         Com_Error( ERR_FATAL, "Z_Free: freed a pointer without ZONEID" );
     }
     if (block->tag == 0) {
@@ -876,11 +988,17 @@ void Z_Free( void *ptr )
         zone = mainzone;
     }
 
-    zone->used -= block->size;
     // set the block to something that should cause problems
     // if it is referenced...
     ::memset( ptr, 0xaa, block->size - sizeof( *block ) );
 
+    if (block->id == SLABID) {
+        Z_SlabFree( zone, block );
+        return;
+    }
+
+    zone->used -= block->size;
+
     block->tag = 0; // mark as free
 
     other = block->prev;
@@ -915,6 +1033,7 @@ Z_FreeTags
 void Z_FreeTags( int tag )
 {
     memzone_t *zone;
+    memblock_t *chunks;
 
     if ( tag == TAG_SMALL )
     {
@@ -924,6 +1043,13 @@ void Z_FreeTags( int tag )
     {
         zone = mainzone;
     }
+
+    // slab chunks of this tag are all on one list
+    chunks = &zone->slabInUse[tag];
+    while ( chunks->next != chunks ) {
+        Z_Free( (void *)(chunks->next + 1) );
+    }
+
     // use the rover as our pointer, because
     // Z_Free automatically adjusts it
     zone->rover = zone->blocklist.next;
@@ -939,38 +1065,20 @@ void Z_FreeTags( int tag )
 
 /*
 ================
-Z_TagMalloc
+Z_ZoneAlloc
+
+First fit from the block list, size already includes the header
 ================
 */
-#ifdef ZONE_DEBUG
-void *Z_TagMallocDebug( int size, int tag, const char *label, const char *file, int line )
-#else
-void *Z_TagMalloc( int size, int tag )
-#endif
+static memblock_t *Z_ZoneAlloc( memzone_t *zone, int size, int tag )
 {
     int extra;
     memblock_t *start, *rover, *_new, *base;
-    memzone_t *zone;
-
-    if (!tag)
-        Com_Error( ERR_FATAL, "Z_TagMalloc: tried to use a 0 tag" );
 
-    if ( tag == TAG_SMALL )
-        zone = smallzone;
-    else
-        zone = mainzone;
-
-#ifdef ZONE_DEBUG
-    int allocSize = size;
-#endif
     //
     // scan through the block list looking for the first free block
     // of sufficient size
     //
-    size += sizeof(memblock_t); // account for size of block header
-    size += 4;     // space for memory trash tester
-    size = PAD(size, sizeof(intptr_t)); // align to 32/64 bit boundary
-
     base = rover = zone->rover;
     start = base->prev;
 
@@ -978,15 +1086,6 @@ void *Z_TagMalloc( int size, int tag )
         if (rover == start)
         {
             // scaned all the way around the list
-#ifdef ZONE_DEBUG
-            Z_LogHeap();
-
-            Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone: %s, line: %d (%s)",
-                    size, zone == smallzone ? "small" : "main", file, line, label);
-#else
-            Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone",
-                    size, zone == smallzone ? "small" : "main");
-#endif
             return NULL;
         }
         if (rover->tag) {
@@ -1020,6 +1119,128 @@ void *Z_TagMalloc( int size, int tag )
 
     base->id = ZONEID;
 
+    // marker for memory trash testing
+    *(int *)((byte *)base + base->size - 4) = ZONEID;
+
+    return base;
+}
+
+/*
+================
+Z_SlabAlloc
+
+Takes a chunk from the size class, carving a new page out of the zone
+when the class has run dry
+================
+*/
+static memblock_t *Z_SlabAlloc( memzone_t *zone, int size, int tag )
+{
+    memslab_t *slab = Z_SlabForSize( zone, size );
+    memblock_t *block;
+
+    if ( !slab->freelist ) {
+        memblock_t *page;
+        byte *chunk;
+        int chunkSize, i, count;
+
+        page = Z_ZoneAlloc( zone, SLAB_PAGE_SIZE, TAG_SLAB );
+        if ( !page ) {
+            return NULL;
+        }
+#ifdef ZONE_DEBUG
+        page->d.label = "slab page";
+        page->d.file = __FILE__;
+        page->d.line = __LINE__;
+        page->d.allocSize = SLAB_PAGE_SIZE;
+#endif
+
+        chunkSize = slabChunkSizes[ slab - zone->slabs ];
+        count = ( SLAB_PAGE_SIZE - sizeof(memblock_t) - 4 ) / chunkSize;
+        chunk = (byte *)( page + 1 ) + ( count - 1 ) * chunkSize;
+
+        for ( i = 0; i < count; i++, chunk -= chunkSize ) {
+            block = (memblock_t *)chunk;
+            block->size = chunkSize;
+            block->tag = 0;
+            block->id = SLABID;
+            block->prev = NULL;
+            block->next = slab->freelist;
+            slab->freelist = block;
+        }
+
+        slab->pages++;
+        slab->chunks += count;
+    }
+
+    block = slab->freelist;
+    slab->freelist = block->next;
+    if ( ++slab->used > slab->highwater ) {
+        slab->highwater = slab->used;
+    }
+
+    block->tag = tag;
+
+    // link into the in use list of the tag
+    block->prev = &zone->slabInUse[tag];
+    block->next = zone->slabInUse[tag].next;
+    block->next->prev = block;
+    zone->slabInUse[tag].next = block;
+    zone->slabTagBytes[tag] += block->size;
+
+    // marker for memory trash testing
+    *(int *)((byte *)block + block->size - 4) = ZONEID;
+
+    return block;
+}
+
+/*
+================
+Z_TagMalloc
+================
+*/
+#ifdef ZONE_DEBUG
+void *Z_TagMallocDebug( int size, int tag, const char *label, const char *file, int line )
+#else
+void *Z_TagMalloc( int size, int tag )
+#endif
+{
+    memblock_t *base;
+    memzone_t *zone;
+
+    if (!tag)
+        Com_Error( ERR_FATAL, "Z_TagMalloc: tried to use a 0 tag" );
+
+    if ( tag == TAG_SMALL )
+        zone = smallzone;
+    else
+        zone = mainzone;
+
+#ifdef ZONE_DEBUG
+    int allocSize = size;
+#endif
+    size += sizeof(memblock_t); // account for size of block header
+    size += 4;     // space for memory trash tester
+    size = PAD(size, sizeof(intptr_t)); // align to 32/64 bit boundary
+
+    if ( size <= SLAB_MAX_CHUNK ) {
+        base = Z_SlabAlloc( zone, size, tag );
+    } else {
+        base = Z_ZoneAlloc( zone, size, tag );
+    }
+
+    if ( !base ) {
+#ifdef ZONE_DEBUG
+        Z_LogHeap();
+
+        Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone: %s, line: %d (%s)",
+                size, zone == smallzone ? "small" : "main", file, line, label);
+#else
+        Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone",
+                size, zone == smallzone ? "small" : "main");
+#endif
+        return NULL;
+    }
+
 #ifdef ZONE_DEBUG
     base->d.label = label;
     base->d.file = file;
@@ -1027,9 +1248,6 @@ void *Z_TagMalloc( int size, int tag )
     base->d.allocSize = allocSize;
 #endif
 
-    // marker for memory trash testing
-    *(int *)((byte *)base + base->size - 4) = ZONEID;
-
     return (void *) ((byte *)base + sizeof(memblock_t));
 }
 
@@ -1097,48 +1315,74 @@ void Z_CheckHeap( void )
 
 /*
 ========================
-Z_LogZoneHeap
+Z_LogZoneBlock
 ========================
 */
-void Z_LogZoneHeap( memzone_t *zone, const char *name )
+static void Z_LogZoneBlock( memblock_t *block )
 {
 #ifdef ZONE_DEBUG
     char dump[32], *ptr;
     int  i, j;
+    char buf[4096];
+
+    ptr = ((char *) block) + sizeof(memblock_t);
+    j = 0;
+    for (i = 0; i < 20 && i < block->d.allocSize; i++)
+    {
+        if (ptr[i] >= 32 && ptr[i] < 127) {
+            dump[j++] = ptr[i];
+        }
+        else {
+            dump[j++] = '_';
+        }
+    }
+    dump[j] = '\0';
+    Com_sprintf(buf, sizeof(buf), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump);
+    FS_Write(buf, strlen(buf), logfile);
 #endif
+}
+
+/*
+========================
+Z_LogZoneHeap
+========================
+*/
+void Z_LogZoneHeap( memzone_t *zone, const char *name )
+{
     memblock_t *block;
     char buf[4096];
     int size, allocSize, numBlocks;
+    int i;
 
     if (!logfile || !FS_Initialized())
         return;
 
-    size = numBlocks = 0;
-#ifdef ZONE_DEBUG
-    allocSize = 0;
-#endif
+    Com_LogFlush();
+
+    size = numBlocks = allocSize = 0;
     Com_sprintf(buf, sizeof(buf), "\r\n================\r\n%s log\r\n================\r\n", name);
     FS_Write(buf, strlen(buf), logfile);
 
     for (block = zone->blocklist.next ; block->next != &zone->blocklist; block = block->next)
     {
-        if (block->tag)
+        // slab pages are logged chunk by chunk below
+        if (block->tag && block->tag != TAG_SLAB)
         {
+            Z_LogZoneBlock( block );
+#ifdef ZONE_DEBUG
+            allocSize += block->d.allocSize;
+#endif
+            size += block->size;
+            numBlocks++;
+        }
+    }
+
+    for (i = 0; i < TAG_MAX; i++)
+    {
+        for (block = zone->slabInUse[i].next; block != &zone->slabInUse[i]; block = block->next)
+        {
+            Z_LogZoneBlock( block );
 #ifdef ZONE_DEBUG
-            ptr = ((char *) block) + sizeof(memblock_t);
-            j = 0;
-            for (i = 0; i < 20 && i < block->d.allocSize; i++)
-            {
-                if (ptr[i] >= 32 && ptr[i] < 127) {
-                    dump[j++] = ptr[i];
-                }
-                else {
-                    dump[j++] = '_';
-                }
-            }
-            dump[j] = '\0';
-            Com_sprintf(buf, sizeof(buf), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump);
-            FS_Write(buf, strlen(buf), logfile);
             allocSize += block->d.allocSize;
 #endif
             size += block->size;
@@ -1286,6 +1530,43 @@ static int s_hunkTotal;
 static int s_zoneTotal;
 static int s_smallZoneTotal;
 
+static byte *s_frameData = NULL;
+static int s_frameTotal;
+static int s_frameUsed;
+static int s_frameLastUsed;
+static int s_frameHighwater;
+static int s_frameOverflow;  // bytes that didn't fit in the arena
+static int s_frameLastOverflow;
+
+/*
+=================
+Com_MeminfoSlabs
+=================
+*/
+static void Com_MeminfoSlabs( memzone_t *zone, const char *name )
+{
+    int i;
+    int pages = 0, used = 0, total = 0;
+
+    for ( i = 0; i < (int)NUM_SLAB_CLASSES; i++ ) {
+        memslab_t *slab = &zone->slabs[i];
+
+        if ( !slab->pages ) {
+            continue;
+        }
+
+        Com_Printf( "        %4i byte chunks: %3i pages %6i/%6i used %6i highwater\n",
+                slabChunkSizes[i], slab->pages, slab->used, slab->chunks, slab->highwater );
+
+        pages += slab->pages;
+        used += slab->used * slabChunkSizes[i];
+        total += slab->chunks * slabChunkSizes[i];
+    }
+
+    Com_Printf( "%8i bytes of %s slabs in use, %i bytes free in %i pages\n",
+            used, name, total - used, pages );
+}
+
 /*
 =================
 Com_Meminfo_f
@@ -1298,6 +1579,7 @@ void Com_Meminfo_f( void )
     int smallZoneBytes;
     int botlibBytes, rendererBytes;
     int unused;
+    int i;
 
     zoneBytes = 0;
     botlibBytes = 0;
@@ -1308,7 +1590,8 @@ void Com_Meminfo_f( void )
             Com_Printf ("block:%p    size:%7i    tag:%3i\n",
                     (void *)block, block->size, block->tag);
         }
-        if ( block->tag ) {
+        // slab pages are accounted for by their chunks
+        if ( block->tag && block->tag != TAG_SLAB ) {
             zoneBytes += block->size;
             zoneBlocks++;
             if ( block->tag == TAG_BOTLIB ) {
@@ -1332,10 +1615,19 @@ void Com_Meminfo_f( void )
         }
     }
 
-    smallZoneBytes = 0;
+    for ( i = 0; i < TAG_MAX; i++ ) {
+        zoneBytes += mainzone->slabTagBytes[i];
+        for ( block = mainzone->slabInUse[i].next; block != &mainzone->slabInUse[i]; block = block->next ) {
+            zoneBlocks++;
+        }
+    }
+    botlibBytes += mainzone->slabTagBytes[TAG_BOTLIB];
+    rendererBytes += mainzone->slabTagBytes[TAG_RENDERER];
+
+    smallZoneBytes = smallzone->slabTagBytes[TAG_SMALL];
     for (block = smallzone->blocklist.next ; ; block = block->next)
     {
-        if ( block->tag )
+        if ( block->tag && block->tag != TAG_SLAB )
             smallZoneBytes += block->size;
 
         if (block->next == &smallzone->blocklist)
@@ -1374,6 +1666,14 @@ void Com_Meminfo_f( void )
     Com_Printf( "        %8i bytes in dynamic renderer\n", rendererBytes );
     Com_Printf( "        %8i bytes in dynamic other\n", zoneBytes - ( botlibBytes + rendererBytes ) );
     Com_Printf( "        %8i bytes in small Zone memory\n", smallZoneBytes );
+    Com_Printf( "\n" );
+    Com_Printf( "%8i bytes total frame memory\n", s_frameTotal );
+    Com_Printf( "        %8i bytes used last frame\n", s_frameLastUsed );
+    Com_Printf( "        %8i bytes frame highwater\n", s_frameHighwater );
+    Com_Printf( "        %8i bytes overflowed to the zone last frame\n", s_frameLastOverflow );
+    Com_Printf( "\n" );
+    Com_MeminfoSlabs( mainzone, "main" );
+    Com_MeminfoSlabs( smallzone, "small" );
 }
 
 /*
@@ -1477,6 +1777,8 @@ void Hunk_Log( void)
     if (!logfile || !FS_Initialized())
         return;
 
+    Com_LogFlush();
+
     int size = 0;
     int numBlocks = 0;
 
@@ -1512,6 +1814,8 @@ void Hunk_SmallLog(void)
     if (!logfile || !FS_Initialized())
         return;
 
+    Com_LogFlush();
+
     for ( hunkblock_t* block = hunkblocks ; block; block = block->next )
         block->printed = false;
 
@@ -1914,6 +2218,172 @@ void Hunk_ClearTempMemory( void )
 /*
 ===================================================================
 
+FRAME MEMORY
+
+A linear arena for scratch memory that only has to live until the
+end of the current frame.  Allocating just bumps a pointer and the
+whole arena is released at once at the top of Com_Frame, so there is
+nothing to free and nothing to fragment.  Never keep a pointer from
+Com_FrameAlloc across frames.
+
+Whatever doesn't fit in the arena is taken from the zone and freed at
+the same time, so a frame that needs more (several cinematics, a
+loading screen redrawn many times) only gets slower.
+===================================================================
+*/
+
+#define FRAME_MAGIC 0x46524d45
+
+// sized to keep the returned memory 16 byte aligned
+struct alignas(16) frameOverflow_t {
+    frameOverflow_t *next;
+};
+
+static frameOverflow_t *s_frameOverflowList;
+
+#ifdef ZONE_DEBUG
+typedef struct {
+    int magic;
+    int size;   // including header and trash tester
+    int pad[2]; // keep the returned memory 16 byte aligned
+} frameHeader_t;
+#endif
+
+/*
+=================
+Com_InitFrameMemory
+=================
+*/
+void Com_InitFrameMemory( void )
+{
+    cvar_t *cv;
+
+    s_frameUsed = 0;
+
+    // nothing on a dedicated server uses it, every allocation goes to the zone
+    if ( com_dedicated && com_dedicated->integer ) {
+        s_frameTotal = 0;
+        return;
+    }
+
+    cv = Cvar_Get( "com_frameMegs", DEF_COMFRAMEMEGS_S, CVAR_LATCH | CVAR_ARCHIVE );
+    Cvar_SetDescription( cv, "The size of the per frame scratch memory arena" );
+
+    if ( cv->integer < DEF_COMFRAMEMEGS ) {
+        s_frameTotal = 1024 * 1024 * DEF_COMFRAMEMEGS;
+    } else {
+        s_frameTotal = cv->integer * 1024 * 1024;
+    }
+
+    s_frameData = (byte*)calloc( s_frameTotal + 31, 1 );
+    if ( !s_frameData ) {
+        Com_Error( ERR_FATAL, "Frame memory failed to allocate %i megs", s_frameTotal / (1024*1024) );
+    }
+    // align to 32 bytes
+    s_frameData = (byte *) ( ( (intptr_t)s_frameData + 31 ) & ~31 );
+}
+
+/*
+=================
+Com_FrameAlloc
+
+Memory is NOT zero filled and is only valid until the next frame
+=================
+*/
+#ifdef ZONE_DEBUG
+void *Com_FrameAllocDebug( int size, const char *label, const char *file, int line )
+#else
+void *Com_FrameAlloc( int size )
+#endif
+{
+    void *buf;
+
+    if ( size < 0 ) {
+        Com_Error( ERR_FATAL, "Com_FrameAlloc: bad size %i", size );
+    }
+
+#ifdef ZONE_DEBUG
+    size += sizeof( frameHeader_t ) + 4;
+#endif
+    size = PAD( size, 16 );
+
+    if ( s_frameUsed + size > s_frameTotal ) {
+        frameOverflow_t *over;
+
+#ifdef ZONE_DEBUG
+        over = (frameOverflow_t *)Z_MallocDebug( sizeof( *over ) + size, label, file, line );
+#else
+        over = (frameOverflow_t *)Z_Malloc( sizeof( *over ) + size );
+#endif
+        over->next = s_frameOverflowList;
+        s_frameOverflowList = over;
+        s_frameOverflow += size;
+        return (void *)( over + 1 );
+    }
+
+    buf = s_frameData + s_frameUsed;
+    s_frameUsed += size;
+
+#ifdef ZONE_DEBUG
+    {
+        frameHeader_t *hdr = (frameHeader_t *)buf;
+
+        hdr->magic = FRAME_MAGIC;
+        hdr->size = size;
+        // marker for memory trash testing
+        *(int *)( (byte *)buf + size - 4 ) = FRAME_MAGIC;
+        buf = (void *)( hdr + 1 );
+    }
+#endif
+
+    return buf;
+}
+
+/*
+=================
+Com_ResetFrameMemory
+
+Releases everything handed out by Com_FrameAlloc since the last reset
+=================
+*/
+static void Com_ResetFrameMemory( void )
+{
+#ifdef ZONE_DEBUG
+    int offset;
+
+    // walk the allocations and check the memory trash testers
+    for ( offset = 0; offset < s_frameUsed; ) {
+        frameHeader_t *hdr = (frameHeader_t *)( s_frameData + offset );
+
+        if ( hdr->magic != FRAME_MAGIC ) {
+            Com_Error( ERR_FATAL, "Com_ResetFrameMemory: bad magic" );
+        }
+        if ( *(int *)( (byte *)hdr + hdr->size - 4 ) != FRAME_MAGIC ) {
+            Com_Error( ERR_FATAL, "Com_ResetFrameMemory: memory block wrote past end" );
+        }
+        offset += hdr->size;
+    }
+#endif
+
+    while ( s_frameOverflowList ) {
+        frameOverflow_t *next = s_frameOverflowList->next;
+
+        Z_Free( s_frameOverflowList );
+        s_frameOverflowList = next;
+    }
+
+    if ( s_frameUsed > s_frameHighwater ) {
+        s_frameHighwater = s_frameUsed;
+    }
+    s_frameLastUsed = s_frameUsed;
+    s_frameUsed = 0;
+    s_frameLastOverflow = s_frameOverflow;
+    s_frameOverflow = 0;
+}
+
+/*
+===================================================================
+
 EVENTS AND JOURNALING
 
 In addition to these events, .cfg files are also copied to the
@@ -2609,6 +3079,7 @@ void Com_Init( char *commandLine )
 #endif
     // allocate the stack based hunk allocator
     Com_InitHunkMemory();
+    Com_InitFrameMemory();
 
     // if any archived cvars are modified after this, we will trigger a writing
     // of the config file
@@ -2917,6 +3388,9 @@ void Com_Frame( void )
     if ( setjmp(abortframe) )
         return; // an ERR_DROP was thrown
 
+    // scratch memory from the last frame is no longer referenced
+    Com_ResetFrameMemory();
+
     timeBeforeFirstEvents =0;
     timeBeforeServer =0;
     timeBeforeEvents =0;
@@ -3100,6 +3574,8 @@ void Com_Frame( void )
 
     Com_ReadFromPipe();
 
+    Com_LogFlush();
+
     com_frameNumber++;
 }
 
@@ -3112,6 +3588,7 @@ void Com_Shutdown(void)
 {
     if (logfile)
     {
+        Com_LogFlush();
         FS_FCloseFile (logfile);
         logfile = 0;
     }
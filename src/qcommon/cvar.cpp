@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "autocomplete.h"
 #include "cmd.h"
 #include "files.h"
+#include "nameindex.h"
 #include "q_shared.h"
 #include "qcommon.h"
 
@@ -39,27 +40,10 @@ int cvar_modifiedFlags = 0;
 static cvar_t cvar_indexes[MAX_CVARS];
 static int cvar_numIndexes;
 
-#define FILE_HASH_SIZE 256
-static cvar_t *hashTable[FILE_HASH_SIZE];
+static nameIndex_t cvar_index;
 
-/*
-================
-return a hash value for the filename
-================
-*/
-static long generateHashValue(const char *fname)
-{
-    long hash = 0;
-    int i = 0;
-    while (fname[i] != '\0')
-    {
-        char letter = tolower(fname[i]);
-        hash += (long)(letter) * (i + 119);
-        i++;
-    }
-    hash &= (FILE_HASH_SIZE - 1);
-    return hash;
-}
+// bumped whenever any cvar changes, lets the VMs skip polling every cvar
+static int cvar_modificationCount;
 
 /*
 ============
@@ -94,13 +78,7 @@ Cvar_FindVar
 */
 cvar_t *Cvar_FindVar(const char *var_name)
 {
-    long hash = generateHashValue(var_name);
-
-    for (cvar_t *var = hashTable[hash]; var; var = var->hashNext)
-        if (!Q_stricmp(var_name, var->name))
-            return var;
-
-    return nullptr;
+    return static_cast<cvar_t *>(NameIndex_Find(&cvar_index, var_name, NameIndex_Hash(var_name)));
 }
 
 /*
@@ -446,15 +424,10 @@ cvar_t *Cvar_Get(const char *var_name, const char *var_value, int flags)
     if (var->flags & CVAR_ALTERNATE_SYSTEMINFO)
         cvar_modifiedFlags |= CVAR_SYSTEMINFO;
 
-    long hash = generateHashValue(var_name);
-    var->hashIndex = hash;
-
-    var->hashNext = hashTable[hash];
-    if (hashTable[hash])
-        hashTable[hash]->hashPrev = var;
+    cvar_modificationCount++;
 
-    var->hashPrev = nullptr;
-    hashTable[hash] = var;
+    var->hash = NameIndex_Hash(var->name);
+    NameIndex_Insert(&cvar_index, var->name, var->hash, var);
 
     return var;
 }
@@ -579,6 +552,7 @@ cvar_t *Cvar_Set2(const char *var_name, const char *value, bool force)
             var->latchedString = CopyString(value);
             var->modified = true;
             var->modificationCount++;
+            cvar_modificationCount++;
             return var;
         }
 
@@ -602,6 +576,7 @@ cvar_t *Cvar_Set2(const char *var_name, const char *value, bool force)
 
     var->modified = true;
     var->modificationCount++;
+    cvar_modificationCount++;
 
     Z_Free(var->string);  // free the old value string
 
@@ -1187,7 +1162,10 @@ cvar_t *Cvar_Unset(cvar_t *cv)
     cvar_modifiedFlags |= cv->flags;
 
     if (cv->name)
+    {
+        NameIndex_Remove(&cvar_index, cv->name, cv->hash);
         Z_Free(cv->name);
+    }
     if (cv->string)
         Z_Free(cv->string);
     if (cv->latchedString)
@@ -1204,12 +1182,7 @@ cvar_t *Cvar_Unset(cvar_t *cv)
     if (cv->next)
         cv->next->prev = cv->prev;
 
-    if (cv->hashPrev)
-        cv->hashPrev->hashNext = cv->hashNext;
-    else
-        hashTable[cv->hashIndex] = cv->hashNext;
-    if (cv->hashNext)
-        cv->hashNext->hashPrev = cv->hashPrev;
+    cvar_modificationCount++;
 
     ::memset(cv, '\0', sizeof(*cv));
 
@@ -1446,6 +1419,16 @@ void Cvar_Update(vmCvar_t *vmCvar)
     vmCvar->integer = cv->integer;
 }
 
+/*
+=====================
+Cvar_ModificationCount
+
+changes whenever any cvar is created, changed or unset, so the
+interpreted modules can skip their Cvar_Update pass when nothing moved
+=====================
+*/
+int Cvar_ModificationCount(void) { return cvar_modificationCount; }
+
 /*
 ==================
 Cvar_CompleteCvarName
@@ -1473,7 +1456,7 @@ Reads in all archived cvars
 void Cvar_Init(void)
 {
     ::memset(cvar_indexes, '\0', sizeof(cvar_indexes));
-    ::memset(hashTable, '\0', sizeof(hashTable));
+    NameIndex_Clear(&cvar_index);
 
     cvar_cheats = Cvar_Get("sv_cheats", "1", CVAR_ROM | CVAR_SYSTEMINFO);
 
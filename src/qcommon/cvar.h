@@ -80,9 +80,7 @@ struct cvar_s {
 
     cvar_t *next;
     cvar_t *prev;
-    cvar_t *hashNext;
-    cvar_t *hashPrev;
-    int hashIndex;
+    unsigned int hash;  // NameIndex_Hash( name )
 };
 
 /*
@@ -124,6 +122,9 @@ SO_PUBLIC void Cvar_Register(vmCvar_t *vmCvar, const char *varName, const char *
 SO_PUBLIC void Cvar_Update(vmCvar_t *vmCvar);
 // updates an interpreted modules' version of a cvar
 
+SO_PUBLIC int Cvar_ModificationCount(void);
+// changes whenever any cvar is created, changed or unset
+
 SO_PUBLIC void Cvar_Set(const char *var_name, const char *value);
 // will create the variable with no flags if it doesn't exist
 
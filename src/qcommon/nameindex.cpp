@@ -0,0 +1,179 @@
+/*
+ * This file is part of Tremulous.
+ * Copyright (C) 2015-2018 GrangerHub
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License,  or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not,  see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nameindex.h"
+
+#include "q_shared.h"
+
+#define NAMEINDEX_MIN_SIZE 64
+
+/*
+============
+NameIndex_Hash
+
+FNV-1a over the lower cased name, folding the same way Q_stricmp does
+============
+*/
+unsigned int NameIndex_Hash(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    for (; *name; name++)
+    {
+        int c = *name;
+
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+
+        hash ^= (unsigned char)c;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/*
+============
+NameIndex_Slot
+
+Returns the slot holding name, or the empty slot that ends its probe sequence
+============
+*/
+static int NameIndex_Slot(const nameIndex_t *index, const char *name, unsigned int hash)
+{
+    int mask = index->size - 1;
+    int i = hash & mask;
+
+    while (index->entries[i].name)
+    {
+        if (index->entries[i].hash == hash && !Q_stricmp(index->entries[i].name, name))
+            break;
+
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+/*
+============
+NameIndex_Find
+============
+*/
+void *NameIndex_Find(const nameIndex_t *index, const char *name, unsigned int hash)
+{
+    if (!index->count)
+        return nullptr;
+
+    return index->entries[NameIndex_Slot(index, name, hash)].value;
+}
+
+/*
+============
+NameIndex_Resize
+============
+*/
+static void NameIndex_Resize(nameIndex_t *index, int size)
+{
+    nameIndexEntry_t *old = index->entries;
+    int oldSize = index->size;
+
+    index->entries = new nameIndexEntry_t[size]();
+    index->size = size;
+
+    for (int i = 0; i < oldSize; i++)
+    {
+        if (old[i].name)
+            index->entries[NameIndex_Slot(index, old[i].name, old[i].hash)] = old[i];
+    }
+
+    delete[] old;
+}
+
+/*
+============
+NameIndex_Insert
+
+Replaces the value if the name is already present
+============
+*/
+void NameIndex_Insert(nameIndex_t *index, const char *name, unsigned int hash, void *value)
+{
+    // keep the load factor under 3/4 so probe sequences stay short
+    if ((index->count + 1) * 4 > index->size * 3)
+        NameIndex_Resize(index, index->size ? index->size * 2 : NAMEINDEX_MIN_SIZE);
+
+    nameIndexEntry_t *e = &index->entries[NameIndex_Slot(index, name, hash)];
+
+    if (!e->name)
+        index->count++;
+
+    e->hash = hash;
+    e->name = name;
+    e->value = value;
+}
+
+/*
+============
+NameIndex_Remove
+
+Shifts the rest of the probe sequence back instead of leaving a
+tombstone, so lookups never have to skip over deleted slots
+============
+*/
+void NameIndex_Remove(nameIndex_t *index, const char *name, unsigned int hash)
+{
+    if (!index->count)
+        return;
+
+    int mask = index->size - 1;
+    int i = NameIndex_Slot(index, name, hash);
+
+    if (!index->entries[i].name)
+        return;
+
+    for (int j = (i + 1) & mask; index->entries[j].name; j = (j + 1) & mask)
+    {
+        int home = index->entries[j].hash & mask;
+
+        // the entry at j can fill the hole at i unless its home slot
+        // lies cyclically in (i, j]
+        if (i <= j ? (home <= i || home > j) : (home <= i && home > j))
+        {
+            index->entries[i] = index->entries[j];
+            i = j;
+        }
+    }
+
+    index->entries[i].name = nullptr;
+    index->entries[i].value = nullptr;
+    index->count--;
+}
+
+/*
+============
+NameIndex_Clear
+============
+*/
+void NameIndex_Clear(nameIndex_t *index)
+{
+    delete[] index->entries;
+    index->entries = nullptr;
+    index->size = 0;
+    index->count = 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of Tremulous.
+ * Copyright (C) 2015-2018 GrangerHub
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License,  or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not,  see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QCOMMON_NAMEINDEX_H
+#define QCOMMON_NAMEINDEX_H
+
+/*
+==============================================================
+
+NAME INDEX
+
+Case insensitive open addressing hash from a name to a pointer, used to
+look up cvars and commands.  The index does not copy the names, they
+have to stay valid until the entry is removed.  Callers that look the
+same name up repeatedly can keep the NameIndex_Hash result around and
+skip rehashing it.
+
+==============================================================
+*/
+
+struct nameIndexEntry_t {
+    unsigned int hash;
+    const char *name;  // nullptr for an empty slot
+    void *value;
+};
+
+struct nameIndex_t {
+    nameIndexEntry_t *entries;
+    int size;  // always a power of two
+    int count;
+};
+
+unsigned int NameIndex_Hash(const char *name);
+
+void *NameIndex_Find(const nameIndex_t *index, const char *name, unsigned int hash);
+void NameIndex_Insert(nameIndex_t *index, const char *name, unsigned int hash, void *value);
+void NameIndex_Remove(nameIndex_t *index, const char *name, unsigned int hash);
+void NameIndex_Clear(nameIndex_t *index);
+
+#endif
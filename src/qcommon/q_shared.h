@@ -49,6 +49,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define MAX_MASTER_SERVERS      5 // number of supported master servers
 
 #define DEMOEXT	"dm_"			// standard demo extension
+#define DEMOEXT_INDEXED	"dmi_"		// indexed demo extension
 
 #ifdef _MSC_VER
 
@@ -149,6 +149,7 @@ void		Info_Print( const char *s );
 
 void		Com_BeginRedirect (char *buffer, int buffersize, void (*flush)(char *));
 void		Com_EndRedirect( void );
+void		Com_LogFlush( void );
 
 SO_PUBLIC void Com_Printf( const char *fmt, ... ) __attribute__ ((format (printf, 1, 2)));
 SO_PUBLIC void Com_Error( int code, const char *fmt, ... ) __attribute__ ((noreturn, format(printf, 2, 3)));
@@ -224,7 +225,10 @@ typedef enum {
 	TAG_BOTLIB,
 	TAG_RENDERER,
 	TAG_SMALL,
-	TAG_STATIC
+	TAG_STATIC,
+	TAG_SLAB,		// size class pages, owned by the zone itself
+
+	TAG_MAX
 } memtag_t;
 
 /*
@@ -267,6 +271,13 @@ void Z_FreeTags( int tag );
 int Z_AvailableMemory( void );
 void Z_LogHeap( void );
 
+#ifdef ZONE_DEBUG
+#define Com_FrameAlloc(size)			Com_FrameAllocDebug(size, #size, __FILE__, __LINE__)
+void *Com_FrameAllocDebug( int size, const char *label, const char *file, int line );
+#else
+void *Com_FrameAlloc( int size );		// NOT 0 filled, released at the top of the next Com_Frame
+#endif
+
 void Hunk_Clear( void );
 void Hunk_ClearToMark( void );
 void Hunk_SetMark( void );
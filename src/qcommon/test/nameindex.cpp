@@ -0,0 +1,88 @@
+//
+// Testing NameIndex_*()
+//
+#include "qcommon/nameindex.h"
+#include "qcommon/q_shared.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+void Com_Error( int level, const char *error, ... ) { exit(0); }
+void Com_Printf( const char *msg, ... ) {}
+
+static void *Find(nameIndex_t *index, const char *name)
+{
+    return NameIndex_Find(index, name, NameIndex_Hash(name));
+}
+
+TEST_CASE("validate NameIndex_Hash", "[NameIndex]")
+{
+    REQUIRE(NameIndex_Hash("sv_hostname") == NameIndex_Hash("SV_HostName"));
+    REQUIRE(NameIndex_Hash("sv_hostname") != NameIndex_Hash("sv_hostnam"));
+}
+
+TEST_CASE("validate NameIndex lookups", "[NameIndex]")
+{
+    nameIndex_t index = {};
+    int a, b;
+
+    SECTION("empty index")
+    {
+        REQUIRE(Find(&index, "map") == nullptr);
+        NameIndex_Remove(&index, "map", NameIndex_Hash("map"));
+    }
+
+    SECTION("case insensitive find")
+    {
+        NameIndex_Insert(&index, "map", NameIndex_Hash("map"), &a);
+        NameIndex_Insert(&index, "devmap", NameIndex_Hash("devmap"), &b);
+        REQUIRE(Find(&index, "MAP") == &a);
+        REQUIRE(Find(&index, "DevMap") == &b);
+        REQUIRE(Find(&index, "maps") == nullptr);
+        REQUIRE(index.count == 2);
+    }
+
+    SECTION("insert replaces")
+    {
+        NameIndex_Insert(&index, "map", NameIndex_Hash("map"), &a);
+        NameIndex_Insert(&index, "MAP", NameIndex_Hash("MAP"), &b);
+        REQUIRE(Find(&index, "map") == &b);
+        REQUIRE(index.count == 1);
+    }
+
+    NameIndex_Clear(&index);
+}
+
+TEST_CASE("validate NameIndex growth and removal", "[NameIndex]")
+{
+    nameIndex_t index = {};
+    std::vector<std::string> names;
+
+    for (int i = 0; i < 1000; i++)
+        names.push_back("cvar_" + std::to_string(i));
+
+    for (size_t i = 0; i < names.size(); i++)
+        NameIndex_Insert(&index, names[i].c_str(), NameIndex_Hash(names[i].c_str()), &names[i]);
+
+    REQUIRE(index.count == 1000);
+    REQUIRE(index.size * 3 >= index.count * 4);
+
+    // remove every third name, the rest must still be reachable
+    for (size_t i = 0; i < names.size(); i += 3)
+        NameIndex_Remove(&index, names[i].c_str(), NameIndex_Hash(names[i].c_str()));
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        if (i % 3)
+            REQUIRE(Find(&index, names[i].c_str()) == &names[i]);
+        else
+            REQUIRE(Find(&index, names[i].c_str()) == nullptr);
+    }
+
+    NameIndex_Clear(&index);
+    REQUIRE(Find(&index, "cvar_1") == nullptr);
+}
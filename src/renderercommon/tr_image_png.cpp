@@ -23,7 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "tr_common.h"
 
-#include "qcommon/puff.h"
+#include "zlib.h"
 
 // we could limit the png size to a lower value here
 #ifndef INT_MAX
@@ -503,51 +503,51 @@ static bool FindChunk(struct BufferedFile *BF, uint32_t ChunkType)
 }
 
 /*
- *  Decompress all IDATs
+ *  zlib allocation goes through the renderer allocator
  */
 
-static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
+static voidpf PNG_ZAlloc(voidpf Opaque, uInt Items, uInt Size)
 {
-	uint8_t  *DecompressedData;
-	uint32_t  DecompressedDataLength;
+	return(ri.Malloc(Items * Size));
+}
 
-	uint8_t  *CompressedData;
-	uint8_t  *CompressedDataPtr;
-	uint32_t  CompressedDataLength;
+static void PNG_ZFree(voidpf Opaque, voidpf Address)
+{
+	ri.Free(Address);
+}
 
-	struct PNG_ChunkHeader *CH;
+/*
+ *  The IDAT chunks are inflated as one continuous stream
+ *  straight out of the file buffer, a scanline at a time.
+ */
 
-	uint32_t Length;
-	uint32_t Type;
+struct PNG_IDATStream
+{
+	z_stream ZStream;
+	struct BufferedFile *BF;
+	uint32_t ChunkBytesLeft;
+	bool     Opened;
+};
 
-	int BytesToRewind;
+/*
+ *  Position the stream at the first IDAT and set up inflate.
+ */
 
-	int32_t   puffResult;
-	uint8_t  *puffDest;
-	uint32_t  puffDestLen;
-	uint8_t  *puffSrc;
-	uint32_t  puffSrcLen;
+static bool OpenIDATStream(struct PNG_IDATStream *IS, struct BufferedFile *BF)
+{
+	struct PNG_ChunkHeader *CH;
 
 	/*
 	 *  input verification
 	 */
 
-	if(!(BF && Buffer))
+	if(!(IS && BF))
 	{
-		return(-1);
+		return(false);
 	}
 
-	/*
-	 *  some zeroing
-	 */
-
-	DecompressedData = NULL;
-	*Buffer = DecompressedData;
-
-	CompressedData = NULL;
-	CompressedDataLength = 0;
-
-	BytesToRewind = 0;
+	memset(IS, 0, sizeof(*IS));
+	IS->BF = BF;
 
 	/*
 	 *  Find the first IDAT chunk.
@@ -555,232 +555,150 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 
 	if(!FindChunk(BF, PNG_ChunkType_IDAT))
 	{
-		return(-1);
+		return(false);
 	}
 
-	/*
-	 *  Count the size of the uncompressed data
-	 */
-
-	while(true)
+	CH = (struct PNG_ChunkHeader*)BufferedFileRead(BF, PNG_ChunkHeader_Size);
+	if(!CH)
 	{
-		/*
-		 *  Read chunk header
-		 */
+		return(false);
+	}
 
-		CH = (struct PNG_ChunkHeader*)BufferedFileRead(BF, PNG_ChunkHeader_Size);
-		if(!CH)
-		{
-			/*
-			 *  Rewind to the start of this adventure
-			 *  and return unsuccessfull
-			 */
+	IS->ChunkBytesLeft = BigLong(CH->Length);
 
-			BufferedFileRewind(BF, BytesToRewind);
+	/*
+	 *  Use the largest window so any conforming stream decodes in one pass.
+	 */
 
-			return(-1);
-		}
+	IS->ZStream.zalloc = PNG_ZAlloc;
+	IS->ZStream.zfree  = PNG_ZFree;
+	IS->ZStream.opaque = Z_NULL;
 
-		/*
-		 *  Length and Type of chunk
-		 */
+	if(inflateInit2(&IS->ZStream, MAX_WBITS) != Z_OK)
+	{
+		return(false);
+	}
 
-		Length = BigLong(CH->Length);
-		Type   = BigLong(CH->Type);
+	IS->Opened = true;
 
-		/*
-		 *  We have reached the end of the IDAT chunks
-		 */
+	return(true);
+}
 
-		if(!(Type == PNG_ChunkType_IDAT))
-		{
-			BufferedFileRewind(BF, PNG_ChunkHeader_Size); 
+/*
+ *  Inflate exactly Length bytes into Dest,
+ *  walking on to the next IDAT chunk whenever the current one runs dry.
+ */
 
-			break;
-		}
+static bool ReadIDATStream(struct PNG_IDATStream *IS, uint8_t *Dest, uint32_t Length)
+{
+	struct PNG_ChunkHeader *CH;
+	int ZResult;
 
-		/*
-		 *  Add chunk header to count.
-		 */
+	/*
+	 *  input verification
+	 */
+
+	if(!(IS && IS->Opened && Dest))
+	{
+		return(false);
+	}
 
-		BytesToRewind += PNG_ChunkHeader_Size;
+	IS->ZStream.next_out  = Dest;
+	IS->ZStream.avail_out = Length;
 
+	while(IS->ZStream.avail_out)
+	{
 		/*
-		 *  Skip to next chunk
+		 *  Feed the rest of the current IDAT or move to the next one.
 		 */
 
-		if(Length)
+		if(!IS->ZStream.avail_in)
 		{
-			if(!BufferedFileSkip(BF, Length + PNG_ChunkCRC_Size))
+			while(!IS->ChunkBytesLeft)
 			{
-				BufferedFileRewind(BF, BytesToRewind);
-
-				return(-1);
-			}
-
-			BytesToRewind += Length + PNG_ChunkCRC_Size;
-			CompressedDataLength += Length;
-		} 
-	}
-
-	BufferedFileRewind(BF, BytesToRewind);
+				if(!BufferedFileSkip(IS->BF, PNG_ChunkCRC_Size))
+				{
+					return(false);
+				}
 
-	CompressedData = (uint8_t*)ri.Malloc(CompressedDataLength);
-	if(!CompressedData)
-	{
-		return(-1);
-	}
+				CH = (struct PNG_ChunkHeader*)BufferedFileRead(IS->BF, PNG_ChunkHeader_Size);
+				if(!CH)
+				{
+					return(false);
+				}
 
-	CompressedDataPtr = CompressedData;
+				/*
+				 *  IDATs have to be consecutive, anything else means truncated data.
+				 */
 
-	/*
-	 *  Collect the compressed Data
-	 */
+				if(BigLong(CH->Type) != PNG_ChunkType_IDAT)
+				{
+					return(false);
+				}
 
-	while(true)
-	{
-		/*
-		 *  Read chunk header
-		 */
+				IS->ChunkBytesLeft = BigLong(CH->Length);
+			}
 
-		CH = (struct PNG_ChunkHeader*)BufferedFileRead(BF, PNG_ChunkHeader_Size);
-		if(!CH)
-		{
-			ri.Free(CompressedData); 
+			IS->ZStream.next_in = (Bytef*)BufferedFileRead(IS->BF, IS->ChunkBytesLeft);
+			if(!IS->ZStream.next_in)
+			{
+				return(false);
+			}
 
-			return(-1);
+			IS->ZStream.avail_in = IS->ChunkBytesLeft;
+			IS->ChunkBytesLeft   = 0;
 		}
 
-		/*
-		 *  Length and Type of chunk
-		 */
-
-		Length = BigLong(CH->Length);
-		Type   = BigLong(CH->Type);
+		ZResult = inflate(&IS->ZStream, Z_NO_FLUSH);
 
 		/*
-		 *  We have reached the end of the IDAT chunks
+		 *  The adler32 check value was never verified before,
+		 *  so don't reject images whose pixel data is complete.
 		 */
 
-		if(!(Type == PNG_ChunkType_IDAT))
+		if(ZResult == Z_DATA_ERROR && !IS->ZStream.avail_out)
 		{
-			BufferedFileRewind(BF, PNG_ChunkHeader_Size); 
-
 			break;
 		}
 
-		/*
-		 *  Copy the Data
-		 */
-
-		if(Length)
+		if(ZResult == Z_STREAM_END)
 		{
-			uint8_t *OrigCompressedData;
-
-			OrigCompressedData = (uint8_t*)BufferedFileRead(BF, Length);
-			if(!OrigCompressedData)
-			{
-				ri.Free(CompressedData); 
-
-				return(-1);
-			}
-
-			if(!BufferedFileSkip(BF, PNG_ChunkCRC_Size))
+			if(IS->ZStream.avail_out)
 			{
-				ri.Free(CompressedData); 
-
-				return(-1);
+				return(false);
 			}
 
-			memcpy(CompressedDataPtr, OrigCompressedData, Length);
-			CompressedDataPtr += Length;
-		} 
-	}
-
-	/*
-	 *  Let puff() calculate the decompressed data length.
-	 */
-
-	puffDest    = NULL;
-	puffDestLen = 0;
-
-	/*
-	 *  The zlib header and checkvalue don't belong to the compressed data.
-	 */
-
-	puffSrc    = CompressedData + PNG_ZlibHeader_Size;
-	puffSrcLen = CompressedDataLength - PNG_ZlibHeader_Size - PNG_ZlibCheckValue_Size;
-
-	/*
-	 *  first puff() to calculate the size of the uncompressed data
-	 */
-
-	puffResult = puff(puffDest, &puffDestLen, puffSrc, &puffSrcLen);
-	if(!((puffResult == 0) && (puffDestLen > 0)))
-	{
-		ri.Free(CompressedData);
-
-		return(-1);
-	}
-
-	/*
-	 *  Allocate the buffer for the uncompressed data.
-	 */
-
-	DecompressedData = (uint8_t*)ri.Malloc(puffDestLen);
-	if(!DecompressedData)
-	{
-		ri.Free(CompressedData);
+			break;
+		}
 
-		return(-1);
+		if(ZResult != Z_OK)
+		{
+			return(false);
+		}
 	}
 
-	/*
-	 *  Set the input again in case something was changed by the last puff() .
-	 */
-
-	puffDest   = DecompressedData;
-	puffSrc    = CompressedData + PNG_ZlibHeader_Size;
-	puffSrcLen = CompressedDataLength - PNG_ZlibHeader_Size - PNG_ZlibCheckValue_Size;
-
-	/*
-	 *  decompression puff()
-	 */
-
-	puffResult = puff(puffDest, &puffDestLen, puffSrc, &puffSrcLen);
-
-	/*
-	 *  The compressed data is not needed anymore.
-	 */
-
-	ri.Free(CompressedData);
+	return(true);
+}
 
-	/*
-	 *  Check if the last puff() was successfull.
-	 */
+/*
+ *  Release the inflate state.
+ */
 
-	if(!((puffResult == 0) && (puffDestLen > 0)))
+static void CloseIDATStream(struct PNG_IDATStream *IS)
+{
+	if(IS && IS->Opened)
 	{
-		ri.Free(DecompressedData);
+		inflateEnd(&IS->ZStream);
 
-		return(-1);
+		IS->Opened = false;
 	}
-
-	/*
-	 *  Set the output of this function.
-	 */
-
-	DecompressedDataLength = puffDestLen;
-	*Buffer = DecompressedData;
-
-	return(DecompressedDataLength);
 }
 
 /*
  *  the Paeth predictor
  */
 
-static uint8_t PredictPaeth(uint8_t a, uint8_t b, uint8_t c)
+static inline uint8_t PredictPaeth(uint8_t a, uint8_t b, uint8_t c)
 {
 	/*
 	 *  a == Left
@@ -788,7 +706,6 @@ static uint8_t PredictPaeth(uint8_t a, uint8_t b, uint8_t c)
 	 *  c == UpLeft
 	 */
 
-	uint8_t Pr;
 	int p;
 	int pa, pb, pc;
 
@@ -799,198 +716,103 @@ static uint8_t PredictPaeth(uint8_t a, uint8_t b, uint8_t c)
 
 	if((pa <= pb) && (pa <= pc))
 	{
-		Pr = a;
+		return(a);
 	}
 	else if(pb <= pc)
 	{
-		Pr = b;
-	}
-	else
-	{
-		Pr = c;
+		return(b);
 	}
 
-	return(Pr);
-
+	return(c);
 }
 
 /*
- *  Reverse the filters.
+ *  Reverse the filter of one scanline in place.
+ *
+ *  The filter type is resolved once per scanline and every filter
+ *  gets its own loop without per-byte branching, so the compiler can
+ *  vectorise None/Up completely and the first pixel of Sub/Average/Paeth.
  */
 
-static bool UnfilterImage(uint8_t  *DecompressedData, 
-		uint32_t  ImageHeight,
-		uint32_t  BytesPerScanline, 
-		uint32_t  BytesPerPixel)
+static bool UnfilterScanline(uint8_t        FilterType,
+		uint8_t       *Row,
+		const uint8_t *PrevRow,
+		uint32_t       BytesPerScanline,
+		uint32_t       BytesPerPixel)
 {
-	uint8_t   *DecompPtr;
-	uint8_t   FilterType;
-	uint8_t  *PixelLeft, *PixelUp, *PixelUpLeft;
-	uint32_t  w, h, p;
-
-	/*
-	 *  some zeros for the filters
-	 */
-
-	uint8_t Zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-
-	/*
-	 *  input verification
-	 */
-
-	if(!(DecompressedData && BytesPerPixel))
-	{
-		return(false);
-	}
-
-	/*
-	 *  ImageHeight and BytesPerScanline can be zero in small interlaced images.
-	 */
-
-	if((!ImageHeight) || (!BytesPerScanline))
-	{
-		return(true);
-	}
-
-	/*
-	 *  Set the pointer to the start of the decompressed Data.
-	 */
-
-	DecompPtr = DecompressedData;
-
-	/*
-	 *  Un-filtering is done in place.
-	 */
-
-	/*
-	 *  Go trough all scanlines.
-	 */
+	uint32_t i;
 
-	for(h = 0; h < ImageHeight; h++)
+	switch(FilterType)
 	{
-		/*
-		 *  Every scanline starts with a FilterType byte.
-		 */
-
-		FilterType = *DecompPtr;
-		DecompPtr++;
-
-		/*
-		 *  Left pixel of the first byte in a scanline is zero.
-		 */
-
-		PixelLeft = Zeros;
-
-		/*
-		 *  Set PixelUp to previous line only if we are on the second line or above.
-		 *
-		 *  Plus one byte for the FilterType
-		 */
-
-		if(h > 0)
-		{
-			PixelUp = DecompPtr - (BytesPerScanline + 1);
-		}
-		else
+		case PNG_FilterType_None :
 		{
-			PixelUp = Zeros;
+			break;
 		}
 
-		/*
-		 * The pixel left to the first pixel of the previous scanline is zero too.
-		 */
-
-		PixelUpLeft = Zeros;
-
-		/*
-		 *  Cycle trough all pixels of the scanline.
-		 */
-
-		for(w = 0; w < (BytesPerScanline / BytesPerPixel); w++)
+		case PNG_FilterType_Sub :
 		{
-			/*
-			 *  Cycle trough the bytes of the pixel.
-			 */
-
-			for(p = 0; p < BytesPerPixel; p++)
+			for(i = BytesPerPixel; i < BytesPerScanline; i++)
 			{
-				switch(FilterType)
-				{ 
-					case PNG_FilterType_None :
-					{
-						/*
-						 *  The byte is unfiltered.
-						 */
-
-						break;
-					}
-
-					case PNG_FilterType_Sub :
-					{
-						DecompPtr[p] += PixelLeft[p];
-
-						break;
-					}
-
-					case PNG_FilterType_Up :
-					{
-						DecompPtr[p] += PixelUp[p];
-
-						break;
-					}
+				Row[i] += Row[i - BytesPerPixel];
+			}
 
-					case PNG_FilterType_Average :
-					{
-						DecompPtr[p] += ((uint8_t) ((((uint16_t) PixelLeft[p]) + ((uint16_t) PixelUp[p])) / 2));
+			break;
+		}
 
-						break;
-					}
+		case PNG_FilterType_Up :
+		{
+			for(i = 0; i < BytesPerScanline; i++)
+			{
+				Row[i] += PrevRow[i];
+			}
 
-					case PNG_FilterType_Paeth :
-					{
-						DecompPtr[p] += PredictPaeth(PixelLeft[p], PixelUp[p], PixelUpLeft[p]);
+			break;
+		}
 
-						break;
-					}
+		case PNG_FilterType_Average :
+		{
+			for(i = 0; i < BytesPerPixel && i < BytesPerScanline; i++)
+			{
+				Row[i] += PrevRow[i] >> 1;
+			}
 
-					default :
-					{
-						return(false);
-					}
-				}
+			for(; i < BytesPerScanline; i++)
+			{
+				Row[i] += (uint8_t) ((((uint16_t) Row[i - BytesPerPixel]) + ((uint16_t) PrevRow[i])) >> 1);
 			}
 
-			PixelLeft = DecompPtr;
+			break;
+		}
 
+		case PNG_FilterType_Paeth :
+		{
 			/*
-			 *  We only have an upleft pixel if we are on the second line or above.
+			 *  With Left and UpLeft zero the predictor is always Up.
 			 */
 
-			if(h > 0)
+			for(i = 0; i < BytesPerPixel && i < BytesPerScanline; i++)
 			{
-				PixelUpLeft = DecompPtr - (BytesPerScanline + 1);
+				Row[i] += PrevRow[i];
 			}
 
-			/*
-			 *  Skip to the next pixel.
-			 */
-
-			DecompPtr += BytesPerPixel;
-
-			/*
-			 *  We only have a previous line if we are on the second line and above.
-			 */
-
-			if(h > 0)
+			for(; i < BytesPerScanline; i++)
 			{
-				PixelUp = DecompPtr - (BytesPerScanline + 1);
+				Row[i] += PredictPaeth(Row[i - BytesPerPixel], PrevRow[i], PrevRow[i - BytesPerPixel]);
 			}
+
+			break;
+		}
+
+		default :
+		{
+			return(false);
 		}
 	}
 
 	return(true);
 }
 
+
 /*
  *  Convert a raw input pixel to Quake 3 RGA format.
  */
@@ -1249,173 +1071,47 @@ static bool ConvertPixel(struct PNG_Chunk_IHDR *IHDR,
 	return(true);
 }
 
-
 /*
- *  Decode a non-interlaced image.
+ *  Bytes per pixel for un-filtering and pixels per byte for packed images.
  */
 
-static bool DecodeImageNonInterlaced(struct PNG_Chunk_IHDR *IHDR,
-		byte                  *OutBuffer, 
-		uint8_t               *DecompressedData,
-		uint32_t               DecompressedDataLength,
-		bool               HasTransparentColour,
-		uint8_t               *TransparentColour,
-		uint8_t               *OutPal)
+static bool GetPixelLayout(struct PNG_Chunk_IHDR *IHDR, uint32_t *BytesPerPixel, uint32_t *PixelsPerByte)
 {
-	uint32_t IHDR_Width;
-	uint32_t IHDR_Height;
-	uint32_t BytesPerScanline, BytesPerPixel, PixelsPerByte;
-	uint32_t  w, h, p;
-	byte *OutPtr;
-	uint8_t *DecompPtr;
-
-	/*
-	 *  input verification
-	 */
-
-	if(!(IHDR && OutBuffer && DecompressedData && DecompressedDataLength && TransparentColour && OutPal))
-	{
-		return(false);
-	}
-
-	/*
-	 *  byte swapping
-	 */
-
-	IHDR_Width  = BigLong(IHDR->Width);
-	IHDR_Height = BigLong(IHDR->Height);
-
-	/*
-	 *  information for un-filtering
-	 */
+	uint32_t NumColourComponents;
 
 	switch(IHDR->ColourType)
 	{
 		case PNG_ColourType_Grey :
 		{
-			switch(IHDR->BitDepth)
-			{
-				case PNG_BitDepth_1 :
-				case PNG_BitDepth_2 :
-				case PNG_BitDepth_4 :
-				{
-					BytesPerPixel    = 1;
-					PixelsPerByte    = 8 / IHDR->BitDepth;
-
-					break;
-				}
-
-				case PNG_BitDepth_8  :
-				case PNG_BitDepth_16 :
-				{
-					BytesPerPixel    = (IHDR->BitDepth / 8) * PNG_NumColourComponents_Grey;
-					PixelsPerByte    = 1;
-
-					break;
-				}
-
-				default :
-				{
-					return(false);
-				}
-			}
+			NumColourComponents = PNG_NumColourComponents_Grey;
 
 			break;
 		}
 
 		case PNG_ColourType_True :
 		{
-			switch(IHDR->BitDepth)
-			{
-				case PNG_BitDepth_8  :
-				case PNG_BitDepth_16 :
-				{
-					BytesPerPixel    = (IHDR->BitDepth / 8) * PNG_NumColourComponents_True;
-					PixelsPerByte    = 1;
-
-					break;
-				}
-
-				default :
-				{
-					return(false);
-				}
-			}
+			NumColourComponents = PNG_NumColourComponents_True;
 
 			break;
 		}
 
 		case PNG_ColourType_Indexed :
 		{
-			switch(IHDR->BitDepth)
-			{
-				case PNG_BitDepth_1 :
-				case PNG_BitDepth_2 :
-				case PNG_BitDepth_4 :
-				{
-					BytesPerPixel    = 1;
-					PixelsPerByte    = 8 / IHDR->BitDepth;
-
-					break;
-				}
-
-				case PNG_BitDepth_8 :
-				{
-					BytesPerPixel    = PNG_NumColourComponents_Indexed;
-					PixelsPerByte    = 1;
-
-					break;
-				}
-
-				default :
-				{
-					return(false);
-				}
-			}
+			NumColourComponents = PNG_NumColourComponents_Indexed;
 
 			break;
 		}
 
 		case PNG_ColourType_GreyAlpha :
 		{
-			switch(IHDR->BitDepth)
-			{
-				case PNG_BitDepth_8 :
-				case PNG_BitDepth_16 :
-				{
-					BytesPerPixel    = (IHDR->BitDepth / 8) * PNG_NumColourComponents_GreyAlpha;
-					PixelsPerByte    = 1;
-
-					break;
-				}
-
-				default :
-				{
-					return(false);
-				}
-			}
+			NumColourComponents = PNG_NumColourComponents_GreyAlpha;
 
 			break;
 		}
 
 		case PNG_ColourType_TrueAlpha :
 		{
-			switch(IHDR->BitDepth)
-			{
-				case PNG_BitDepth_8 :
-				case PNG_BitDepth_16 :
-				{
-					BytesPerPixel    = (IHDR->BitDepth / 8) * PNG_NumColourComponents_TrueAlpha;
-					PixelsPerByte    = 1;
-
-					break;
-				}
-
-				default :
-				{
-					return(false);
-				}
-			}
+			NumColourComponents = PNG_NumColourComponents_TrueAlpha;
 
 			break;
 		}
@@ -1426,478 +1122,370 @@ static bool DecodeImageNonInterlaced(struct PNG_Chunk_IHDR *IHDR,
 		}
 	}
 
-	/*
-	 *  Calculate the size of one scanline
-	 */
-
-	BytesPerScanline = (IHDR_Width * BytesPerPixel + (PixelsPerByte - 1)) / PixelsPerByte;
-
-	/*
-	 *  Check if we have enough data for the whole image.
-	 */
-
-	if(!(DecompressedDataLength == ((BytesPerScanline + 1) * IHDR_Height)))
-	{
-		return(false);
-	}
-
-	/*
-	 *  Unfilter the image.
-	 */
-
-	if(!UnfilterImage(DecompressedData, IHDR_Height, BytesPerScanline, BytesPerPixel))
+	switch(IHDR->BitDepth)
 	{
-		return(false);
-	}
-
-	/*
-	 *  Set the working pointers to the beginning of the buffers.
-	 */
-
-	OutPtr = OutBuffer;
-	DecompPtr = DecompressedData;
-
-	/*
-	 *  Create the output image.
-	 */
-
-	for(h = 0; h < IHDR_Height; h++)
-	{
-		/*
-		 *  Count the pixels on the scanline for those multipixel bytes
-		 */
-
-		uint32_t CurrPixel;
-
-		/*
-		 *  skip FilterType
-		 */
-
-		DecompPtr++;
-
-		/*
-		 *  Reset the pixel count.
-		 */
-
-		CurrPixel = 0;
-
-		for(w = 0; w < (BytesPerScanline / BytesPerPixel); w++)
+		case PNG_BitDepth_1 :
+		case PNG_BitDepth_2 :
+		case PNG_BitDepth_4 :
 		{
-			if(PixelsPerByte > 1)
-			{
-				uint8_t  Mask;
-				uint32_t Shift;
-				uint8_t  SinglePixel;
-
-				for(p = 0; p < PixelsPerByte; p++)
-				{
-					if(CurrPixel < IHDR_Width)
-					{
-						Mask  = (1 << IHDR->BitDepth) - 1;
-						Shift = (PixelsPerByte - 1 - p) * IHDR->BitDepth;
-
-						SinglePixel = ((DecompPtr[0] & (Mask << Shift)) >> Shift);
-
-						if(!ConvertPixel(IHDR, OutPtr, &SinglePixel, HasTransparentColour, TransparentColour, OutPal))
-						{
-							return(false);
-						}
-
-						OutPtr += Q3IMAGE_BYTESPERPIXEL;
-						CurrPixel++;
-					}
-				}
+			/*
+			 *  Only Grey and Indexed may pack several pixels into a byte.
+			 */
 
-			}
-			else
+			if(!((IHDR->ColourType == PNG_ColourType_Grey) || (IHDR->ColourType == PNG_ColourType_Indexed)))
 			{
-				if(!ConvertPixel(IHDR, OutPtr, DecompPtr, HasTransparentColour, TransparentColour, OutPal))
-				{
-					return(false);
-				}
-
-
-				OutPtr += Q3IMAGE_BYTESPERPIXEL;
+				return(false);
 			}
 
-			DecompPtr += BytesPerPixel;
-		}
-	}
-
-	return(true);
-}
-
-/*
- *  Decode an interlaced image.
- */
+			*BytesPerPixel = 1;
+			*PixelsPerByte = 8 / IHDR->BitDepth;
 
-static bool DecodeImageInterlaced(struct PNG_Chunk_IHDR *IHDR,
-		byte                  *OutBuffer, 
-		uint8_t               *DecompressedData,
-		uint32_t               DecompressedDataLength,
-		bool               HasTransparentColour,
-		uint8_t               *TransparentColour,
-		uint8_t               *OutPal)
-{
-	uint32_t IHDR_Width;
-	uint32_t IHDR_Height;
-	uint32_t BytesPerScanline[PNG_Adam7_NumPasses], BytesPerPixel, PixelsPerByte;
-	uint32_t PassWidth[PNG_Adam7_NumPasses], PassHeight[PNG_Adam7_NumPasses];
-	uint32_t WSkip[PNG_Adam7_NumPasses], WOffset[PNG_Adam7_NumPasses], HSkip[PNG_Adam7_NumPasses], HOffset[PNG_Adam7_NumPasses];
-	uint32_t w, h, p, a;
-	byte *OutPtr;
-	uint8_t *DecompPtr;
-	uint32_t TargetLength;
-
-	/*
-	 *  input verification
-	 */
-
-	if(!(IHDR && OutBuffer && DecompressedData && DecompressedDataLength && TransparentColour && OutPal))
-	{
-		return(false);
-	}
-
-	/*
-	 *  byte swapping
-	 */
-
-	IHDR_Width  = BigLong(IHDR->Width);
-	IHDR_Height = BigLong(IHDR->Height);
-
-	/*
-	 *  Skip and Offset for the passes.
-	 */
+			break;
+		}
 
-	WSkip[0]   = 8;
-	WOffset[0] = 0;
-	HSkip[0]   = 8;
-	HOffset[0] = 0;
-
-	WSkip[1]   = 8;
-	WOffset[1] = 4;
-	HSkip[1]   = 8;
-	HOffset[1] = 0;
-
-	WSkip[2]   = 4;
-	WOffset[2] = 0;
-	HSkip[2]   = 8;
-	HOffset[2] = 4;
-
-	WSkip[3]   = 4;
-	WOffset[3] = 2;
-	HSkip[3]   = 4;
-	HOffset[3] = 0;
-
-	WSkip[4]   = 2;
-	WOffset[4] = 0;
-	HSkip[4]   = 4;
-	HOffset[4] = 2;
-
-	WSkip[5]   = 2;
-	WOffset[5] = 1;
-	HSkip[5]   = 2;
-	HOffset[5] = 0;
-
-	WSkip[6]   = 1;
-	WOffset[6] = 0;
-	HSkip[6]   = 2;
-	HOffset[6] = 1;
+		case PNG_BitDepth_8 :
+		{
+			*BytesPerPixel = NumColourComponents;
+			*PixelsPerByte = 1;
 
-	/*
-	 *  Calculate the sizes of the passes.
-	 */
+			break;
+		}
 
-	PassWidth[0]  = (IHDR_Width  + 7) / 8;
-	PassHeight[0] = (IHDR_Height + 7) / 8;
+		case PNG_BitDepth_16 :
+		{
+			if(IHDR->ColourType == PNG_ColourType_Indexed)
+			{
+				return(false);
+			}
 
-	PassWidth[1]  = (IHDR_Width  + 3) / 8;
-	PassHeight[1] = (IHDR_Height + 7) / 8;
+			*BytesPerPixel = 2 * NumColourComponents;
+			*PixelsPerByte = 1;
 
-	PassWidth[2]  = (IHDR_Width  + 3) / 4;
-	PassHeight[2] = (IHDR_Height + 3) / 8;
+			break;
+		}
 
-	PassWidth[3]  = (IHDR_Width  + 1) / 4;
-	PassHeight[3] = (IHDR_Height + 3) / 4;
+		default :
+		{
+			return(false);
+		}
+	}
 
-	PassWidth[4]  = (IHDR_Width  + 1) / 2;
-	PassHeight[4] = (IHDR_Height + 1) / 4;
+	return(true);
+}
 
-	PassWidth[5]  = (IHDR_Width  + 0) / 2;
-	PassHeight[5] = (IHDR_Height + 1) / 2;
+/*
+ *  Convert one unfiltered scanline into the output image.
+ *
+ *  OutStep is the distance in bytes between two output pixels,
+ *  which is larger than one pixel for the Adam7 passes.
+ */
 
-	PassWidth[6]  = (IHDR_Width  + 0) / 1;
-	PassHeight[6] = (IHDR_Height + 0) / 2;
+static bool ConvertScanline(struct PNG_Chunk_IHDR *IHDR,
+		byte                  *OutPtr,
+		uint32_t               OutStep,
+		uint8_t               *Row,
+		uint32_t               NumPixels,
+		uint32_t               BytesPerPixel,
+		uint32_t               PixelsPerByte,
+		bool                   HasTransparentColour,
+		uint8_t               *TransparentColour,
+		uint8_t               *OutPal)
+{
+	uint32_t w;
 
 	/*
-	 *  information for un-filtering
+	 *  8 bit images without a transparent colour key are by far the most
+	 *  common ones, handle them a whole scanline at a time.
 	 */
 
-	switch(IHDR->ColourType)
+	if((IHDR->BitDepth == PNG_BitDepth_8) && !HasTransparentColour)
 	{
-		case PNG_ColourType_Grey :
+		switch(IHDR->ColourType)
 		{
-			switch(IHDR->BitDepth)
+			case PNG_ColourType_TrueAlpha :
 			{
-				case PNG_BitDepth_1 :
-				case PNG_BitDepth_2 :
-				case PNG_BitDepth_4 :
+				if(OutStep == Q3IMAGE_BYTESPERPIXEL)
 				{
-					BytesPerPixel    = 1;
-					PixelsPerByte    = 8 / IHDR->BitDepth;
+					memcpy(OutPtr, Row, NumPixels * Q3IMAGE_BYTESPERPIXEL);
 
-					break;
+					return(true);
 				}
 
-				case PNG_BitDepth_8  :
-				case PNG_BitDepth_16 :
+				for(w = 0; w < NumPixels; w++, OutPtr += OutStep, Row += 4)
 				{
-					BytesPerPixel    = (IHDR->BitDepth / 8) * PNG_NumColourComponents_Grey;
-					PixelsPerByte    = 1;
-
-					break;
+					memcpy(OutPtr, Row, 4);
 				}
 
-				default :
-				{
-					return(false);
-				}
+				return(true);
 			}
 
-			break;
-		}
-
-		case PNG_ColourType_True :
-		{
-			switch(IHDR->BitDepth)
+			case PNG_ColourType_True :
 			{
-				case PNG_BitDepth_8  :
-				case PNG_BitDepth_16 :
+				for(w = 0; w < NumPixels; w++, OutPtr += OutStep, Row += 3)
 				{
-					BytesPerPixel    = (IHDR->BitDepth / 8) * PNG_NumColourComponents_True;
-					PixelsPerByte    = 1;
-
-					break;
+					OutPtr[0] = Row[0];
+					OutPtr[1] = Row[1];
+					OutPtr[2] = Row[2];
+					OutPtr[3] = 0xFF;
 				}
 
-				default :
-				{
-					return(false);
-				}
+				return(true);
 			}
 
-			break;
-		}
-
-		case PNG_ColourType_Indexed :
-		{
-			switch(IHDR->BitDepth)
+			case PNG_ColourType_Grey :
 			{
-				case PNG_BitDepth_1 :
-				case PNG_BitDepth_2 :
-				case PNG_BitDepth_4 :
+				for(w = 0; w < NumPixels; w++, OutPtr += OutStep, Row++)
 				{
-					BytesPerPixel    = 1;
-					PixelsPerByte    = 8 / IHDR->BitDepth;
-
-					break;
+					OutPtr[0] = Row[0];
+					OutPtr[1] = Row[0];
+					OutPtr[2] = Row[0];
+					OutPtr[3] = 0xFF;
 				}
 
-				case PNG_BitDepth_8 :
-				{
-					BytesPerPixel    = PNG_NumColourComponents_Indexed;
-					PixelsPerByte    = 1;
-
-					break;
-				}
+				return(true);
+			}
 
-				default :
+			case PNG_ColourType_GreyAlpha :
+			{
+				for(w = 0; w < NumPixels; w++, OutPtr += OutStep, Row += 2)
 				{
-					return(false);
+					OutPtr[0] = Row[0];
+					OutPtr[1] = Row[0];
+					OutPtr[2] = Row[0];
+					OutPtr[3] = Row[1];
 				}
+
+				return(true);
 			}
 
-			break;
+			default :
+			{
+				break;
+			}
 		}
+	}
 
-		case PNG_ColourType_GreyAlpha :
+	/*
+	 *  Indexed images carry their transparency in the palette.
+	 */
+
+	if((IHDR->BitDepth == PNG_BitDepth_8) && (IHDR->ColourType == PNG_ColourType_Indexed))
+	{
+		for(w = 0; w < NumPixels; w++, OutPtr += OutStep, Row++)
 		{
-			switch(IHDR->BitDepth)
-			{
-				case PNG_BitDepth_8 :
-				case PNG_BitDepth_16 :
-				{
-					BytesPerPixel    = (IHDR->BitDepth / 8) * PNG_NumColourComponents_GreyAlpha;
-					PixelsPerByte    = 1;
+			memcpy(OutPtr, &OutPal[Row[0] * Q3IMAGE_BYTESPERPIXEL], Q3IMAGE_BYTESPERPIXEL);
+		}
 
-					break;
-				}
+		return(true);
+	}
 
-				default :
-				{
-					return(false);
-				}
-			}
+	/*
+	 *  Everything else goes through the generic pixel converter.
+	 */
 
-			break;
-		}
+	if(PixelsPerByte > 1)
+	{
+		uint8_t  Mask;
+		uint32_t Shift;
+		uint8_t  SinglePixel;
 
-		case PNG_ColourType_TrueAlpha :
+		Mask = (1 << IHDR->BitDepth) - 1;
+
+		for(w = 0; w < NumPixels; w++, OutPtr += OutStep)
 		{
-			switch(IHDR->BitDepth)
-			{
-				case PNG_BitDepth_8 :
-				case PNG_BitDepth_16 :
-				{
-					BytesPerPixel    = (IHDR->BitDepth / 8) * PNG_NumColourComponents_TrueAlpha;
-					PixelsPerByte    = 1;
+			Shift = (PixelsPerByte - 1 - (w % PixelsPerByte)) * IHDR->BitDepth;
 
-					break;
-				}
+			SinglePixel = ((Row[w / PixelsPerByte] >> Shift) & Mask);
 
-				default :
-				{
-					return(false);
-				}
+			if(!ConvertPixel(IHDR, OutPtr, &SinglePixel, HasTransparentColour, TransparentColour, OutPal))
+			{
+				return(false);
 			}
-
-			break;
 		}
 
-		default :
+		return(true);
+	}
+
+	for(w = 0; w < NumPixels; w++, OutPtr += OutStep, Row += BytesPerPixel)
+	{
+		if(!ConvertPixel(IHDR, OutPtr, Row, HasTransparentColour, TransparentColour, OutPal))
 		{
 			return(false);
 		}
 	}
 
+	return(true);
+}
+
+/*
+ *  Skip and Offset of the Adam7 passes.
+ */
+
+static const uint32_t PNG_Adam7_WSkip[PNG_Adam7_NumPasses]   = { 8, 8, 4, 4, 2, 2, 1 };
+static const uint32_t PNG_Adam7_WOffset[PNG_Adam7_NumPasses] = { 0, 4, 0, 2, 0, 1, 0 };
+static const uint32_t PNG_Adam7_HSkip[PNG_Adam7_NumPasses]   = { 8, 8, 8, 4, 4, 2, 2 };
+static const uint32_t PNG_Adam7_HOffset[PNG_Adam7_NumPasses] = { 0, 0, 4, 0, 2, 0, 1 };
+
+/*
+ *  Number of pixels of a pass along one axis.
+ */
+
+static uint32_t PassSize(uint32_t Size, uint32_t Skip, uint32_t Offset)
+{
+	if(Size <= Offset)
+	{
+		return(0);
+	}
+
+	return((Size - Offset + Skip - 1) / Skip);
+}
+
+/*
+ *  Decode the image.
+ *
+ *  Scanlines are inflated one at a time into a small row buffer,
+ *  unfiltered against the previous row and converted straight into
+ *  OutBuffer, so the decompressed image never exists as a whole.
+ *  A non-interlaced image is simply a single pass covering every pixel.
+ */
+
+static bool DecodeImage(struct PNG_Chunk_IHDR *IHDR,
+		byte                  *OutBuffer,
+		struct PNG_IDATStream *IS,
+		bool                   HasTransparentColour,
+		uint8_t               *TransparentColour,
+		uint8_t               *OutPal)
+{
+	uint32_t IHDR_Width;
+	uint32_t IHDR_Height;
+	uint32_t BytesPerPixel, PixelsPerByte;
+	uint32_t BytesPerScanline, MaxBytesPerScanline;
+	uint32_t NumPasses;
+	uint32_t WSkip, WOffset, HSkip, HOffset;
+	uint32_t PassWidth, PassHeight;
+	uint32_t h, a;
+	uint8_t *RowBuffer;
+	uint8_t *Row, *PrevRow, *Swap;
+	byte *OutPtr;
+
 	/*
-	 *  Calculate the size of the scanlines per pass
+	 *  input verification
 	 */
 
-	for(a = 0; a < PNG_Adam7_NumPasses; a++)
+	if(!(IHDR && OutBuffer && IS && TransparentColour && OutPal))
 	{
-		BytesPerScanline[a] = (PassWidth[a] * BytesPerPixel + (PixelsPerByte - 1)) / PixelsPerByte;
+		return(false);
 	}
 
 	/*
-	 *  Calculate the size of all passes
+	 *  byte swapping
 	 */
 
-	TargetLength = 0;
+	IHDR_Width  = BigLong(IHDR->Width);
+	IHDR_Height = BigLong(IHDR->Height);
 
-	for(a = 0; a < PNG_Adam7_NumPasses; a++)
+	if(!GetPixelLayout(IHDR, &BytesPerPixel, &PixelsPerByte))
 	{
-		TargetLength += ((BytesPerScanline[a] + (BytesPerScanline[a] ? 1 : 0)) * PassHeight[a]);
+		return(false);
 	}
 
 	/*
-	 *  Check if we have enough data for the whole image.
+	 *  The widest scanline belongs to the full image,
+	 *  plus one byte for the FilterType.
 	 */
 
-	if(!(DecompressedDataLength == TargetLength))
+	MaxBytesPerScanline = (IHDR_Width * BytesPerPixel + (PixelsPerByte - 1)) / PixelsPerByte;
+
+	RowBuffer = (uint8_t*)ri.Malloc(2 * (MaxBytesPerScanline + 1));
+	if(!RowBuffer)
 	{
 		return(false);
 	}
 
-	/*
-	 *  Unfilter the image.
-	 */
+	Row     = RowBuffer;
+	PrevRow = RowBuffer + (MaxBytesPerScanline + 1);
 
-	DecompPtr = DecompressedData;
+	NumPasses = (IHDR->InterlaceMethod == PNG_InterlaceMethod_Interlaced) ? PNG_Adam7_NumPasses : 1;
 
-	for(a = 0; a < PNG_Adam7_NumPasses; a++)
+	for(a = 0; a < NumPasses; a++)
 	{
-		if(!UnfilterImage(DecompPtr, PassHeight[a], BytesPerScanline[a], BytesPerPixel))
+		if(NumPasses == 1)
 		{
-			return(false);
+			WSkip   = 1;
+			WOffset = 0;
+			HSkip   = 1;
+			HOffset = 0;
+		}
+		else
+		{
+			WSkip   = PNG_Adam7_WSkip[a];
+			WOffset = PNG_Adam7_WOffset[a];
+			HSkip   = PNG_Adam7_HSkip[a];
+			HOffset = PNG_Adam7_HOffset[a];
 		}
 
-		DecompPtr += ((BytesPerScanline[a] + (BytesPerScanline[a] ? 1 : 0)) * PassHeight[a]);
-	}
-
-	/*
-	 *  Set the working pointers to the beginning of the buffers.
-	 */
-
-	DecompPtr = DecompressedData;
+		PassWidth  = PassSize(IHDR_Width,  WSkip, WOffset);
+		PassHeight = PassSize(IHDR_Height, HSkip, HOffset);
 
-	/*
-	 *  Create the output image.
-	 */
+		/*
+		 *  Empty passes have no scanlines at all, not even FilterType bytes.
+		 */
 
-	for(a = 0; a < PNG_Adam7_NumPasses; a++)
-	{
-		for(h = 0; h < PassHeight[a]; h++)
+		if((!PassWidth) || (!PassHeight))
 		{
-			/*
-			 *  Count the pixels on the scanline for those multipixel bytes
-			 */
+			continue;
+		}
 
-			uint32_t CurrPixel;
+		BytesPerScanline = (PassWidth * BytesPerPixel + (PixelsPerByte - 1)) / PixelsPerByte;
 
-			/*
-			 *  skip FilterType
-			 *  but only when the pass has a width bigger than zero
-			 */
+		/*
+		 *  The scanline above the first one is all zeros.
+		 */
 
-			if(BytesPerScanline[a])
+		memset(PrevRow, 0, BytesPerScanline + 1);
+
+		for(h = 0; h < PassHeight; h++)
+		{
+			if(!ReadIDATStream(IS, Row, BytesPerScanline + 1))
 			{
-				DecompPtr++;
+				ri.Free(RowBuffer);
+
+				return(false);
 			}
 
 			/*
-			 *  Reset the pixel count.
+			 *  Every scanline starts with a FilterType byte.
 			 */
 
-			CurrPixel = 0;
-
-			for(w = 0; w < (BytesPerScanline[a] / BytesPerPixel); w++)
+			if(!UnfilterScanline(Row[0], Row + 1, PrevRow + 1, BytesPerScanline, BytesPerPixel))
 			{
-				if(PixelsPerByte > 1)
-				{
-					uint8_t  Mask;
-					uint32_t Shift;
-					uint8_t  SinglePixel;
-
-					for(p = 0; p < PixelsPerByte; p++)
-					{
-						if(CurrPixel < PassWidth[a])
-						{
-							Mask  = (1 << IHDR->BitDepth) - 1;
-							Shift = (PixelsPerByte - 1 - p) * IHDR->BitDepth;
-
-							SinglePixel = ((DecompPtr[0] & (Mask << Shift)) >> Shift);
-
-							OutPtr = OutBuffer + (((((h * HSkip[a]) + HOffset[a]) * IHDR_Width) + ((CurrPixel * WSkip[a]) + WOffset[a])) * Q3IMAGE_BYTESPERPIXEL);
-
-							if(!ConvertPixel(IHDR, OutPtr, &SinglePixel, HasTransparentColour, TransparentColour, OutPal))
-							{
-								return(false);
-							}
+				ri.Free(RowBuffer);
 
-							CurrPixel++;
-						}
-					}
+				return(false);
+			}
 
-				}
-				else
-				{
-					OutPtr = OutBuffer + (((((h * HSkip[a]) + HOffset[a]) * IHDR_Width) + ((w * WSkip[a]) + WOffset[a])) * Q3IMAGE_BYTESPERPIXEL);
+			OutPtr = OutBuffer + (((((h * HSkip) + HOffset) * IHDR_Width) + WOffset) * Q3IMAGE_BYTESPERPIXEL);
 
-					if(!ConvertPixel(IHDR, OutPtr, DecompPtr, HasTransparentColour, TransparentColour, OutPal))
-					{
-						return(false);
-					}
-				}
+			if(!ConvertScanline(IHDR, OutPtr, WSkip * Q3IMAGE_BYTESPERPIXEL, Row + 1, PassWidth,
+						BytesPerPixel, PixelsPerByte, HasTransparentColour, TransparentColour, OutPal))
+			{
+				ri.Free(RowBuffer);
 
-				DecompPtr += BytesPerPixel;
+				return(false);
 			}
+
+			Swap    = PrevRow;
+			PrevRow = Row;
+			Row     = Swap;
 		}
 	}
 
+	ri.Free(RowBuffer);
+
 	return(true);
 }
 
+
 /*
  *  The PNG loader
  */
@@ -1915,8 +1503,7 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 	uint32_t IHDR_Height;
 	PNG_ChunkCRC *CRC;
 	uint8_t *InPal;
-	uint8_t *DecompressedData;
-	uint32_t DecompressedDataLength;
+	struct PNG_IDATStream IDATStream;
 	uint32_t i;
 
 	/*
@@ -2384,18 +1971,6 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 		return; 
 	}
 
-	/*
-	 *  Decompress all IDAT chunks
-	 */
-
-	DecompressedDataLength = DecompressIDATs(ThePNG, &DecompressedData);
-	if(!(DecompressedDataLength && DecompressedData))
-	{
-		CloseBufferedFile(ThePNG);
-
-		return;
-	}
-
 	/*
 	 *  Allocate output buffer.
 	 */
@@ -2403,56 +1978,35 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 	OutBuffer = (byte*)ri.Malloc(IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL); 
 	if(!OutBuffer)
 	{
-		ri.Free(DecompressedData); 
 		CloseBufferedFile(ThePNG);
 
 		return;  
 	}
 
 	/*
-	 *  Interlaced and Non-interlaced images need to be handled differently.
+	 *  Inflate the IDAT chunks and decode them straight into the output buffer.
 	 */
 
-	switch(IHDR->InterlaceMethod)
+	if(!OpenIDATStream(&IDATStream, ThePNG))
 	{
-		case PNG_InterlaceMethod_NonInterlaced :
-		{
-			if(!DecodeImageNonInterlaced(IHDR, OutBuffer, DecompressedData, DecompressedDataLength, HasTransparentColour, TransparentColour, OutPal))
-			{
-				ri.Free(OutBuffer); 
-				ri.Free(DecompressedData); 
-				CloseBufferedFile(ThePNG);
-
-				return;
-			}
-
-			break;
-		}
-
-		case PNG_InterlaceMethod_Interlaced :
-		{
-			if(!DecodeImageInterlaced(IHDR, OutBuffer, DecompressedData, DecompressedDataLength, HasTransparentColour, TransparentColour, OutPal))
-			{
-				ri.Free(OutBuffer); 
-				ri.Free(DecompressedData); 
-				CloseBufferedFile(ThePNG);
-
-				return;
-			}
+		CloseIDATStream(&IDATStream);
+		ri.Free(OutBuffer); 
+		CloseBufferedFile(ThePNG);
 
-			break;
-		}
+		return;
+	}
 
-		default :
-		{
-			ri.Free(OutBuffer); 
-			ri.Free(DecompressedData); 
-			CloseBufferedFile(ThePNG);
+	if(!DecodeImage(IHDR, OutBuffer, &IDATStream, HasTransparentColour, TransparentColour, OutPal))
+	{
+		CloseIDATStream(&IDATStream);
+		ri.Free(OutBuffer); 
+		CloseBufferedFile(ThePNG);
 
-			return;
-		}
+		return;
 	}
 
+	CloseIDATStream(&IDATStream);
+
 	/*
 	 *  update the pointer to the image data
 	 */
@@ -2473,12 +2027,6 @@ void R_LoadPNG(const char *name, byte **pic, int *width, int *height)
 		*height = IHDR_Height;
 	}
 
-	/*
-	 *  DecompressedData is not needed anymore.
-	 */
-
-	ri.Free(DecompressedData); 
-
 	/*
 	 *  We have all data, so close the file.
 	 */
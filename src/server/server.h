@@ -155,6 +155,9 @@ struct client_t {
     int challenge;
 
     usercmd_t lastUsercmd;
+    usercmd_t thinkCmds[MAX_PACKET_USERCMDS];  // commands of the GAME_CLIENT_THINK_BATCH in progress
+    int numThinkCmds;
+    int thinkCmd;  // the one SV_GetUsercmd returns while the batch runs
     int lastMessageNum;  // for delta compression
     int lastClientCommand;  // reliable client message sequence
     char lastClientCommandString[MAX_STRING_CHARS];
@@ -163,16 +166,17 @@ struct client_t {
 
     // downloading
     char downloadName[MAX_QPATH];  // if not empty string, we are downloading
-    fileHandle_t download;  // file being downloaded
+    struct svDownloadFile_t *download;  // file being downloaded, shared with other clients
     int downloadSize;  // total bytes (can't use EOF because of paks)
-    int downloadCount;  // bytes sent
     int downloadClientBlock;  // last block we sent to the client, awaiting ack
-    int downloadCurrentBlock;  // current block number
     int downloadXmitBlock;  // last block we xmited
-    unsigned char *downloadBlocks[MAX_DOWNLOAD_WINDOW];  // the buffers for the download blocks
-    int downloadBlockSize[MAX_DOWNLOAD_WINDOW];
-    bool downloadEOF;  // We have sent the EOF block
+    int downloadResendBlock;  // blocks below this have been sent before
     int downloadSendTime;  // time we last got an ack from the client
+    int downloadXmitTime[MAX_DOWNLOAD_WINDOW];  // when each block went out, 0 if resent
+    int downloadWindow;  // blocks allowed in flight
+    int downloadWindowAcks;  // acks since the window last grew
+    bool downloadSlowStart;  // grow the window on every ack until a block is lost
+    int downloadRTT;  // smoothed round trip time of download blocks
 
     int deltaMessage;  // frame last client usercmd message
     int nextReliableTime;  // svs.time when another reliable command will be allowed
@@ -208,6 +212,13 @@ struct client_t {
 
     int oldServerTime;
     bool csUpdated[MAX_CONFIGSTRINGS];
+
+    // configstring batches, only for clients with cl_csBatch
+    bool csBatch;
+    bool csQueued[MAX_CONFIGSTRINGS];  // changed this frame, not sent yet
+    int numCsQueued;
+    bool csSynced;  // the client has had a gamestate, csSent is valid
+    char *csSent[MAX_CONFIGSTRINGS];  // what the client has, the base for deltas, NULL if sv.configstrings
 };
 
 //=============================================================================
@@ -280,11 +291,13 @@ extern cvar_t *sv_serverid;
 extern cvar_t *sv_minRate;
 extern cvar_t *sv_maxRate;
 extern cvar_t *sv_dlRate;
+extern cvar_t *sv_dlCacheSize;
 extern cvar_t *sv_minPing;
 extern cvar_t *sv_maxPing;
 extern cvar_t *sv_pure;
 extern cvar_t *sv_lanForceRate;
 extern cvar_t *sv_banFile;
+extern cvar_t *sv_demoAutoRecord;
 
 #ifdef USE_VOIP
 extern cvar_t *sv_voip;
@@ -335,6 +348,10 @@ SO_PUBLIC void SV_SetConfigstring(int index, const char *val);
 SO_PUBLIC void SV_GetConfigstring(int index, char *buffer, int bufferSize);
 SO_PUBLIC void SV_SetConfigstringRestrictions(int index, const clientList_t *clientList);
 void SV_UpdateConfigstrings(client_t *client);
+void SV_SetConfigstringBatching(client_t *client, bool enable);
+void SV_FlushConfigstrings(client_t *client);
+void SV_ConfigstringsSent(client_t *client);
+void SV_FreeConfigstrings(client_t *client);
 
 SO_PUBLIC void SV_SetUserinfo(int index, const char *val);
 SO_PUBLIC void SV_GetUserinfo(int index, char *buffer, int bufferSize);
@@ -378,6 +395,16 @@ void SV_SendMessageToClient(msg_t *msg, client_t *client);
 void SV_SendClientMessages(void);
 void SV_SendClientSnapshot(client_t *client);
 
+//
+// sv_demo.c
+//
+void SV_DemoInit(void);
+void SV_DemoAutoRecord(void);
+void SV_DemoStop(void);
+void SV_DemoWriteFrame(void);
+void SV_DemoConfigstringModified(int index);
+void SV_DemoServerCommand(client_t *cl, const char *cmd);
+
 //
 // sv_game.c
 //
@@ -516,6 +516,7 @@ void SV_FreeClient(client_t *client)
 
 	SV_Netchan_FreeQueue(client);
 	SV_CloseDownload(client);
+	SV_FreeConfigstrings(client);
 }
 
 /*
@@ -658,6 +659,9 @@ static void SV_SendClientGameState( client_t *client ) {
 	// write the checksum feed
 	MSG_WriteLong( &msg, sv.checksumFeed);
 
+	// later configstring deltas are against what this gamestate holds
+	SV_ConfigstringsSent( client );
+
 	// deliver this to the client
 	SV_SendMessageToClient( &msg, client );
 }
@@ -700,6 +704,198 @@ void SV_ClientEnterWorld( client_t *client, usercmd_t *cmd ) {
 /*
 ============================================================
 
+DOWNLOAD BLOCK CACHE
+
+Clients downloading the same file share one file handle and one
+set of cached pages, so a new map pack is read from disk once no
+matter how many clients fetch it.  Blocks are written to the
+client message straight from the cache.  Pages are loaded on
+demand and the least recently used ones are dropped once the
+cache grows past sv_dlCacheSize kilobytes; a dropped page is
+simply read again if a client still needs it.
+
+============================================================
+*/
+
+#define DL_PAGE_BLOCKS	64
+#define DL_PAGE_SIZE	(DL_PAGE_BLOCKS * MAX_DOWNLOAD_BLKSIZE)
+
+#define DL_INITIAL_WINDOW	8
+#define DL_MIN_WINDOW		4
+
+struct svDownloadPage_t {
+	byte		*data;
+	int			lastUsed;
+};
+
+struct svDownloadFile_t {
+	char				name[MAX_QPATH];
+	fileHandle_t		f;
+	int					size;
+	int					refCount;
+	int					numPages;
+	svDownloadPage_t	*pages;
+	svDownloadFile_t	*next;
+};
+
+static svDownloadFile_t *sv_downloadFiles;
+static int sv_downloadCacheBytes;
+
+/*
+==================
+SV_DownloadFileOpen
+
+Returns the shared download of name, opening it if no other client is
+downloading it.  Returns NULL if the file can't be opened.
+==================
+*/
+static svDownloadFile_t *SV_DownloadFileOpen( const char *name ) {
+	svDownloadFile_t *file;
+	fileHandle_t f;
+	int size;
+
+	for ( file = sv_downloadFiles; file; file = file->next ) {
+		if ( !Q_stricmp( file->name, name ) ) {
+			file->refCount++;
+			return file;
+		}
+	}
+
+	size = FS_SV_FOpenFileRead( name, &f );
+	if ( size < 0 ) {
+		if ( f )
+			FS_FCloseFile( f );
+		return NULL;
+	}
+
+	file = (svDownloadFile_t *)Z_Malloc( sizeof( *file ) );
+	Q_strncpyz( file->name, name, sizeof( file->name ) );
+	file->f = f;
+	file->size = size;
+	file->refCount = 1;
+	file->numPages = size / DL_PAGE_SIZE + 1;
+	file->pages = (svDownloadPage_t *)Z_Malloc( file->numPages * sizeof( *file->pages ) );
+	file->next = sv_downloadFiles;
+	sv_downloadFiles = file;
+
+	return file;
+}
+
+/*
+==================
+SV_DownloadFreePage
+==================
+*/
+static void SV_DownloadFreePage( svDownloadFile_t *file, svDownloadPage_t *page ) {
+	int len = file->size - (int)( page - file->pages ) * DL_PAGE_SIZE;
+
+	sv_downloadCacheBytes -= MIN( len, DL_PAGE_SIZE );
+	Z_Free( page->data );
+	page->data = NULL;
+}
+
+/*
+==================
+SV_DownloadFileClose
+
+Drops a reference, the file is closed when the last client is done with it
+==================
+*/
+static void SV_DownloadFileClose( svDownloadFile_t *file ) {
+	svDownloadFile_t **prev;
+	int i;
+
+	if ( --file->refCount > 0 )
+		return;
+
+	for ( i = 0; i < file->numPages; i++ ) {
+		if ( file->pages[i].data )
+			SV_DownloadFreePage( file, &file->pages[i] );
+	}
+
+	for ( prev = &sv_downloadFiles; *prev; prev = &(*prev)->next ) {
+		if ( *prev == file ) {
+			*prev = file->next;
+			break;
+		}
+	}
+
+	FS_FCloseFile( file->f );
+	Z_Free( file->pages );
+	Z_Free( file );
+}
+
+/*
+==================
+SV_DownloadEvictPage
+
+Frees the least recently used page of any file, returns false if nothing is cached
+==================
+*/
+static bool SV_DownloadEvictPage( void ) {
+	svDownloadFile_t *file, *oldestFile = NULL;
+	svDownloadPage_t *oldest = NULL;
+	int i;
+
+	for ( file = sv_downloadFiles; file; file = file->next ) {
+		for ( i = 0; i < file->numPages; i++ ) {
+			if ( file->pages[i].data && ( !oldest || file->pages[i].lastUsed < oldest->lastUsed ) ) {
+				oldest = &file->pages[i];
+				oldestFile = file;
+			}
+		}
+	}
+
+	if ( !oldest )
+		return false;
+
+	SV_DownloadFreePage( oldestFile, oldest );
+	return true;
+}
+
+/*
+==================
+SV_DownloadBlock
+
+Returns block number block of file and sets its length, a zero length
+block past the end of the file marks EOF
+==================
+*/
+static const byte *SV_DownloadBlock( svDownloadFile_t *file, int block, int *len ) {
+	svDownloadPage_t *page;
+	int offset = block * MAX_DOWNLOAD_BLKSIZE;
+	int pageLen;
+
+	if ( offset >= file->size ) {
+		*len = 0;
+		return NULL;
+	}
+	*len = MIN( file->size - offset, MAX_DOWNLOAD_BLKSIZE );
+
+	page = &file->pages[block / DL_PAGE_BLOCKS];
+	page->lastUsed = svs.time;
+
+	if ( !page->data ) {
+		pageLen = MIN( file->size - ( block / DL_PAGE_BLOCKS ) * DL_PAGE_SIZE, DL_PAGE_SIZE );
+
+		while ( sv_downloadCacheBytes + pageLen > sv_dlCacheSize->integer * 1024 ) {
+			if ( !SV_DownloadEvictPage() )
+				break;
+		}
+
+		page->data = (byte *)Z_Malloc( pageLen );
+		sv_downloadCacheBytes += pageLen;
+
+		FS_Seek( file->f, ( block / DL_PAGE_BLOCKS ) * DL_PAGE_SIZE, FS_SEEK_SET );
+		FS_Read( page->data, pageLen, file->f );
+	}
+
+	return page->data + ( block % DL_PAGE_BLOCKS ) * MAX_DOWNLOAD_BLKSIZE;
+}
+
+/*
+============================================================
+
 CLIENT COMMAND EXECUTION
 
 ============================================================
@@ -713,23 +909,12 @@ clear/free any download vars
 ==================
 */
 static void SV_CloseDownload( client_t *cl ) {
-	int i;
-
 	// EOF
 	if (cl->download) {
-		FS_FCloseFile( cl->download );
+		SV_DownloadFileClose( cl->download );
 	}
-	cl->download = 0;
+	cl->download = NULL;
 	*cl->downloadName = 0;
-
-	// Free the temporary buffer space
-	for (i = 0; i < MAX_DOWNLOAD_WINDOW; i++) {
-		if (cl->downloadBlocks[i]) {
-			Z_Free(cl->downloadBlocks[i]);
-			cl->downloadBlocks[i] = NULL;
-		}
-	}
-
 }
 
 /*
@@ -775,15 +960,32 @@ static void SV_NextDownload_f( client_t *cl )
 	int block = atoi( Cmd_Argv(1) );
 
 	if (block == cl->downloadClientBlock) {
+		int xmitTime = cl->downloadXmitTime[block % MAX_DOWNLOAD_WINDOW];
+
 		Com_DPrintf( "clientDownload: %d : client acknowledge of block %d\n", (int) (cl - svs.clients), block );
 
 		// Find out if we are done.  A zero-length block indicates EOF
-		if (cl->downloadBlockSize[cl->downloadClientBlock % MAX_DOWNLOAD_WINDOW] == 0) {
+		if (block * MAX_DOWNLOAD_BLKSIZE >= cl->downloadSize) {
 			Com_Printf( "clientDownload: %d : file \"%s\" completed\n", (int) (cl - svs.clients), cl->downloadName );
 			SV_CloseDownload( cl );
 			return;
 		}
 
+		// only blocks sent once give a usable round trip time
+		if (xmitTime) {
+			if (!cl->downloadRTT)
+				cl->downloadRTT = svs.time - xmitTime;
+			else
+				cl->downloadRTT += (svs.time - xmitTime - cl->downloadRTT) / 8;
+		}
+
+		// open the window by a block per ack until something is lost,
+		// then by a block per window of acks
+		if (cl->downloadSlowStart || ++cl->downloadWindowAcks >= cl->downloadWindow) {
+			cl->downloadWindow = MIN(cl->downloadWindow + 1, MAX_DOWNLOAD_WINDOW);
+			cl->downloadWindowAcks = 0;
+		}
+
 		cl->downloadSendTime = svs.time;
 		cl->downloadClientBlock++;
 		return;
@@ -820,6 +1022,9 @@ Fill up msg with data, return number of download blocks added
 int SV_WriteDownloadToClient(client_t *cl, msg_t *msg)
 {
 	int curindex;
+	int lastBlock, windowEnd, timeout;
+	int blockLen;
+	const byte *blockData;
 	int unreferenced = 1;
 	char errorMessage[1024];
 	char pakbuf[MAX_QPATH], *pakptr;
@@ -859,13 +1064,13 @@ int SV_WriteDownloadToClient(client_t *cl, msg_t *msg)
 			}
 		}
 
-		cl->download = 0;
+		cl->download = NULL;
 
 		// We open the file here
 		if ( !(sv_allowDownload->integer & DLF_ENABLE) ||
 			(sv_allowDownload->integer & DLF_NO_UDP) ||
 			unreferenced ||
-			( cl->downloadSize = FS_SV_FOpenFileRead( cl->downloadName, &cl->download ) ) < 0 ) {
+			!( cl->download = SV_DownloadFileOpen( cl->downloadName ) ) ) {
 			// cannot auto-download file
 			if(unreferenced)
 			{
@@ -899,70 +1104,55 @@ int SV_WriteDownloadToClient(client_t *cl, msg_t *msg)
 
 			*cl->downloadName = 0;
 			
-			if(cl->download)
-				FS_FCloseFile(cl->download);
-			
 			return 1;
 		}
  
 		Com_Printf( "clientDownload: %d : beginning \"%s\"\n", (int) (cl - svs.clients), cl->downloadName );
 		
 		// Init
-		cl->downloadCurrentBlock = cl->downloadClientBlock = cl->downloadXmitBlock = 0;
-		cl->downloadCount = 0;
-		cl->downloadEOF = false;
-	}
-
-	// Perform any reads that we need to
-	while (cl->downloadCurrentBlock - cl->downloadClientBlock < MAX_DOWNLOAD_WINDOW &&
-		cl->downloadSize != cl->downloadCount) {
-
-		curindex = (cl->downloadCurrentBlock % MAX_DOWNLOAD_WINDOW);
-
-		if (!cl->downloadBlocks[curindex])
-			cl->downloadBlocks[curindex] = (unsigned char*)Z_Malloc(MAX_DOWNLOAD_BLKSIZE);
-
-		cl->downloadBlockSize[curindex] = FS_Read( cl->downloadBlocks[curindex], MAX_DOWNLOAD_BLKSIZE, cl->download );
-
-		if (cl->downloadBlockSize[curindex] < 0) {
-			// EOF right now
-			cl->downloadCount = cl->downloadSize;
-			break;
-		}
-
-		cl->downloadCount += cl->downloadBlockSize[curindex];
-
-		// Load in next block
-		cl->downloadCurrentBlock++;
+		cl->downloadSize = cl->download->size;
+		cl->downloadClientBlock = cl->downloadXmitBlock = cl->downloadResendBlock = 0;
+		cl->downloadWindow = DL_INITIAL_WINDOW;
+		cl->downloadWindowAcks = 0;
+		cl->downloadSlowStart = true;
+		cl->downloadRTT = 0;
 	}
 
-	// Check to see if we have eof condition and add the EOF block
-	if (cl->downloadCount == cl->downloadSize
-      && !cl->downloadEOF
-      && cl->downloadCurrentBlock - cl->downloadClientBlock < MAX_DOWNLOAD_WINDOW)
-    {
-		cl->downloadBlockSize[cl->downloadCurrentBlock % MAX_DOWNLOAD_WINDOW] = 0;
-		cl->downloadCurrentBlock++;
+	// the zero length EOF block follows the last block of data
+	lastBlock = (cl->downloadSize + MAX_DOWNLOAD_BLKSIZE - 1) / MAX_DOWNLOAD_BLKSIZE;
+	windowEnd = MIN(cl->downloadClientBlock + cl->downloadWindow, lastBlock + 1);
 
-		cl->downloadEOF = true;  // We have added the EOF block
-	}
-
-	if (cl->downloadClientBlock == cl->downloadCurrentBlock)
+	if (cl->downloadClientBlock > lastBlock)
 		return 0; // Nothing to transmit
 
 	// Write out the next section of the file, if we have already reached our window,
 	// automatically start retransmitting
-	if (cl->downloadXmitBlock == cl->downloadCurrentBlock)
+	if (cl->downloadXmitBlock >= windowEnd)
 	{
+		// Give the acks a couple of round trips before deciding blocks were lost
+		timeout = cl->downloadRTT ? 2 * cl->downloadRTT + 100 : 1000;
+		if (timeout < 200)
+			timeout = 200;
+		else if (timeout > 1000)
+			timeout = 1000;
+
 		// We have transmitted the complete window, should we start resending?
-		if (svs.time - cl->downloadSendTime > 1000)
+		if (svs.time - cl->downloadSendTime > timeout)
+		{
+			cl->downloadResendBlock = MAX(cl->downloadResendBlock, cl->downloadXmitBlock);
 			cl->downloadXmitBlock = cl->downloadClientBlock;
+
+			cl->downloadWindow = MAX(cl->downloadWindow / 2, DL_MIN_WINDOW);
+			cl->downloadWindowAcks = 0;
+			cl->downloadSlowStart = false;
+		}
 		else
 			return 0;
 	}
 
 	// Send current block
 	curindex = (cl->downloadXmitBlock % MAX_DOWNLOAD_WINDOW);
+	blockData = SV_DownloadBlock( cl->download, cl->downloadXmitBlock, &blockLen );
 
 	MSG_WriteByte( msg, svc_download );
 	MSG_WriteShort( msg, cl->downloadXmitBlock );
@@ -971,14 +1161,16 @@ int SV_WriteDownloadToClient(client_t *cl, msg_t *msg)
 	if ( cl->downloadXmitBlock == 0 )
 		MSG_WriteLong( msg, cl->downloadSize );
 
-	MSG_WriteShort( msg, cl->downloadBlockSize[curindex] );
+	MSG_WriteShort( msg, blockLen );
 
 	// Write the block
-	if(cl->downloadBlockSize[curindex])
-		MSG_WriteData(msg, cl->downloadBlocks[curindex], cl->downloadBlockSize[curindex]);
+	if(blockLen)
+		MSG_WriteData(msg, blockData, blockLen);
 
 	Com_DPrintf( "clientDownload: %d : writing block %d\n", (int) (cl - svs.clients), cl->downloadXmitBlock );
 
+	cl->downloadXmitTime[curindex] = cl->downloadXmitBlock < cl->downloadResendBlock ? 0 : svs.time;
+
 	// Move on to the next block
 	// It will get sent with next snap shot.  The rate will keep us in line.
 	cl->downloadXmitBlock++;
@@ -1320,6 +1512,10 @@ void SV_UserinfoChanged( client_t *cl ) {
 	cl->hasVoip = !Q_stricmp( val, "opus" );
 #endif
 
+	// set by clients whose cgame applies csb commands
+	val = Info_ValueForKey( cl->userinfo, "cl_csBatch" );
+	SV_SetConfigstringBatching( cl, atoi( val ) == 1 && cl->netchan.alternateProtocol == 0 );
+
 	// TTimo
 	// maintain the IP information
 	// the banning code relies on this being consistently present
@@ -1530,6 +1726,39 @@ void SV_ClientThink (client_t *cl, usercmd_t *cmd) {
 	sv.gvm->Call(GAME_CLIENT_THINK, cl - svs.clients);
 }
 
+/*
+==================
+SV_ClientThinkBatch
+
+Hands all new commands from a packet to the game in one call, so it can
+share work between them.  Whatever the game doesn't take, e.g. because
+it predates GAME_CLIENT_THINK_BATCH, goes through SV_ClientThink.
+==================
+*/
+static void SV_ClientThinkBatch( client_t *cl, usercmd_t *cmds, int cmdCount ) {
+	int done = 0;
+
+	if ( cmdCount > 1 && cl->state == CS_ACTIVE ) {
+		Com_Memcpy( cl->thinkCmds, cmds, cmdCount * sizeof( *cmds ) );
+		cl->numThinkCmds = cmdCount;
+		cl->thinkCmd = 0;
+
+		done = sv.gvm->Call( GAME_CLIENT_THINK_BATCH, cl - svs.clients, cmdCount );
+
+		cl->numThinkCmds = 0;
+		if ( done < 0 || done > cmdCount ) {
+			done = 0;
+		}
+		if ( done > 0 ) {
+			cl->lastUsercmd = cmds[done - 1];
+		}
+	}
+
+	for ( ; done < cmdCount; done++ ) {
+		SV_ClientThink( cl, &cmds[done] );
+	}
+}
+
 /*
 ==================
 SV_UserMove
@@ -1544,7 +1773,8 @@ each of the backup packets.
 */
 static void SV_UserMove( client_t *cl, msg_t *msg, bool delta ) {
 	int			i, key;
-	int			cmdCount;
+	int			cmdCount, newCount;
+	int			lastTime;
 	usercmd_t	nullcmd;
 	usercmd_t	cmds[MAX_PACKET_USERCMDS];
 	usercmd_t	*cmd, *oldcmd;
@@ -1620,6 +1850,8 @@ static void SV_UserMove( client_t *cl, msg_t *msg, bool delta ) {
 	// usually, the first couple commands will be duplicates
 	// of ones we have previously received, but the servertimes
 	// in the commands will cause them to be immediately discarded
+	lastTime = cl->lastUsercmd.serverTime;
+	newCount = 0;
 	for ( i =  0 ; i < cmdCount ; i++ ) {
 		// if this is a cmd from before a map_restart ignore it
 		if ( cmds[i].serverTime > cmds[cmdCount-1].serverTime ) {
@@ -1631,10 +1863,15 @@ static void SV_UserMove( client_t *cl, msg_t *msg, bool delta ) {
 		//}
 		// don't execute if this is an old cmd which is already executed
 		// these old cmds are included when cl_packetdup > 0
-		if ( cmds[i].serverTime <= cl->lastUsercmd.serverTime ) {
+		if ( cmds[i].serverTime <= lastTime ) {
 			continue;
 		}
-		SV_ClientThink (cl, &cmds[ i ]);
+		lastTime = cmds[i].serverTime;
+		cmds[newCount++] = cmds[i];
+	}
+
+	if ( newCount ) {
+		SV_ClientThinkBatch( cl, cmds, newCount );
 	}
 }
 
@@ -0,0 +1,1215 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+Copyright (C) 2000-2013 Darklegion Development
+Copyright (C) 2015-2018 GrangerHub
+
+This file is part of Tremulous.
+
+Tremulous is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Tremulous is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Tremulous; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+#include "server.h"
+
+/*
+=============================================================================
+
+Server side demos
+
+A server demo records the whole game once per server frame instead of one
+client's view of it, so that any player's point of view can be rebuilt
+afterwards.  The file starts with a header and is followed by blocks:
+
+4	SVDEMO_MAGIC
+4	SVDEMO_VERSION
+4	PROTOCOL_VERSION
+
+4	block length (-1 ends the demo)
+<block>	huffman coded bitstream, first byte is the block type
+
+A gamestate block holds the checksum feed, sv_maxclients, every configstring
+and every baseline.  A frame block holds:
+
+4	serverTime
+<configstrings changed since the last frame>
+<server commands issued since the last frame, with their target client>
+<playerstates of active clients, delta compressed against their last frame>
+<all entities sent to any client, delta compressed against the last frame>
+<visibility flags of entities whose svFlags changed>
+
+The entity stream is encoded once per frame and shared by every client.
+
+=============================================================================
+*/
+
+#define SVDEMO_MAGIC (('M' << 24) | ('D' << 16) | ('V' << 8) | 'S')
+#define SVDEMO_VERSION 1
+#define SVDEMO_EXT "svdm"
+#define SVDEMO_MSGLEN 0x40000
+#define SVDEMO_COMMAND_BYTES 0x4000  // initial size, grows up to SVDEMO_MSGLEN
+
+enum svDemoBlock_t {
+    svdm_gamestate,
+    svdm_frame
+};
+
+#define SVDEMO_VIS_SINGLECLIENT 1
+#define SVDEMO_VIS_NOTSINGLECLIENT 2
+#define SVDEMO_VIS_CLIENTMASK 4
+
+struct svDemoVis_t {
+    int flags;
+    int singleClient;
+    int generic1;
+};
+
+struct svDemo_t {
+    fileHandle_t file;
+    char name[MAX_QPATH];
+    int lastTime;
+    int frames;
+    int bytes;
+
+    bool csDirty[MAX_CONFIGSTRINGS];
+
+    char *commands;  // [target byte] [string] pairs
+    int commandBytes;
+    int commandSize;
+
+    bool psValid[MAX_CLIENTS];
+    playerState_t ps[MAX_CLIENTS];
+
+    bool entValid[MAX_GENTITIES];
+    entityState_t ents[MAX_GENTITIES];
+    svDemoVis_t vis[MAX_GENTITIES];
+};
+
+static svDemo_t *svDemo;
+static byte svDemoMsgBuf[SVDEMO_MSGLEN];
+
+cvar_t *sv_demoAutoRecord;
+
+/*
+==================
+SV_DemoBaseline
+
+Baselines without an entity number are never sent to clients,
+so delta from a null state for those
+==================
+*/
+static entityState_t *SV_DemoBaseline(int num)
+{
+    static entityState_t nullstate;
+
+    if (!sv.svEntities[num].baseline.number)
+    {
+        return &nullstate;
+    }
+    return &sv.svEntities[num].baseline;
+}
+
+/*
+==================
+SV_DemoWriteBlock
+==================
+*/
+static void SV_DemoWriteBlock(msg_t *msg)
+{
+    int len;
+
+    len = LittleLong(msg->cursize);
+    FS_Write(&len, 4, svDemo->file);
+    FS_Write(msg->data, msg->cursize, svDemo->file);
+    svDemo->bytes += msg->cursize + 4;
+}
+
+/*
+==================
+SV_DemoWriteGamestate
+==================
+*/
+static void SV_DemoWriteGamestate(void)
+{
+    msg_t msg;
+    entityState_t nullstate;
+
+    MSG_Init(&msg, svDemoMsgBuf, sizeof(svDemoMsgBuf));
+    MSG_Bitstream(&msg);
+
+    MSG_WriteByte(&msg, svdm_gamestate);
+    MSG_WriteLong(&msg, sv.checksumFeed);
+    MSG_WriteLong(&msg, sv_maxclients->integer);
+
+    for (int i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        if (!sv.configstrings[i].s[0])
+        {
+            continue;
+        }
+        MSG_WriteShort(&msg, i);
+        MSG_WriteBigString(&msg, sv.configstrings[i].s);
+    }
+    MSG_WriteShort(&msg, MAX_CONFIGSTRINGS);
+
+    ::memset(&nullstate, 0, sizeof(nullstate));
+    for (int i = 0; i < MAX_GENTITIES; i++)
+    {
+        entityState_t *base = &sv.svEntities[i].baseline;
+
+        if (!base->number)
+        {
+            continue;
+        }
+        MSG_WriteDeltaEntity(0, &msg, &nullstate, base, true);
+    }
+    MSG_WriteBits(&msg, MAX_GENTITIES - 1, GENTITYNUM_BITS);
+
+    SV_DemoWriteBlock(&msg);
+}
+
+/*
+==================
+SV_DemoStart
+==================
+*/
+static void SV_DemoStart(const char *name)
+{
+    char path[MAX_OSPATH];
+    fileHandle_t f;
+    int header[3];
+
+    SV_DemoStop();
+
+    Com_sprintf(path, sizeof(path), "svdemos/%s.%s", name, SVDEMO_EXT);
+    f = FS_FOpenFileWrite(path);
+    if (!f)
+    {
+        Com_Printf("SV_DemoStart: couldn't open %s\n", path);
+        return;
+    }
+
+    svDemo = (svDemo_t *)Z_Malloc(sizeof(*svDemo));
+    svDemo->file = f;
+    Q_strncpyz(svDemo->name, name, sizeof(svDemo->name));
+    svDemo->lastTime = -1;
+    svDemo->commandSize = SVDEMO_COMMAND_BYTES;
+    svDemo->commands = (char *)Z_Malloc(svDemo->commandSize);
+
+    header[0] = LittleLong(SVDEMO_MAGIC);
+    header[1] = LittleLong(SVDEMO_VERSION);
+    header[2] = LittleLong(PROTOCOL_VERSION);
+    FS_Write(header, sizeof(header), f);
+    svDemo->bytes = sizeof(header);
+
+    SV_DemoWriteGamestate();
+
+    Com_Printf("recording server demo to %s.\n", path);
+}
+
+/*
+==================
+SV_DemoStop
+==================
+*/
+void SV_DemoStop(void)
+{
+    int len;
+
+    if (!svDemo)
+    {
+        return;
+    }
+
+    len = -1;
+    FS_Write(&len, 4, svDemo->file);
+    FS_FCloseFile(svDemo->file);
+
+    Com_Printf("Stopped server demo %s: %d frames, %d KB.\n",
+        svDemo->name, svDemo->frames, svDemo->bytes / 1024);
+
+    Z_Free(svDemo->commands);
+    Z_Free(svDemo);
+    svDemo = NULL;
+}
+
+/*
+==================
+SV_DemoConfigstringModified
+==================
+*/
+void SV_DemoConfigstringModified(int index)
+{
+    if (!svDemo)
+    {
+        return;
+    }
+    svDemo->csDirty[index] = true;
+}
+
+/*
+==================
+SV_DemoServerCommand
+
+Remembers a command sent to one client or, with a NULL client,
+broadcast to all of them
+==================
+*/
+void SV_DemoServerCommand(client_t *cl, const char *cmd)
+{
+    int len;
+
+    if (!svDemo)
+    {
+        return;
+    }
+
+    // configstring updates are recorded through SV_DemoConfigstringModified
+    if (cl && (!strncmp(cmd, "cs ", 3) || !strncmp(cmd, "bcs", 3)))
+    {
+        return;
+    }
+
+    len = strlen(cmd) + 1;
+    if (svDemo->commandBytes + 1 + len > svDemo->commandSize)
+    {
+        int size = svDemo->commandSize;
+        char *commands;
+
+        while (size < svDemo->commandBytes + 1 + len)
+        {
+            size *= 2;
+        }
+
+        // more than that can't be written in one frame anyway
+        if (size > SVDEMO_MSGLEN)
+        {
+            Com_Printf(S_COLOR_YELLOW "WARNING: server demo commands overflowed, stopping\n");
+            SV_DemoStop();
+            return;
+        }
+
+        commands = (char *)Z_Malloc(size);
+        ::memcpy(commands, svDemo->commands, svDemo->commandBytes);
+        Z_Free(svDemo->commands);
+        svDemo->commands = commands;
+        svDemo->commandSize = size;
+    }
+
+    svDemo->commands[svDemo->commandBytes++] = cl ? (byte)(cl - svs.clients) : 0xff;
+    ::memcpy(svDemo->commands + svDemo->commandBytes, cmd, len);
+    svDemo->commandBytes += len;
+}
+
+/*
+==================
+SV_DemoEntityVis
+==================
+*/
+static void SV_DemoEntityVis(sharedEntity_t *ent, svDemoVis_t *vis)
+{
+    vis->flags = 0;
+    if (ent->r.svFlags & SVF_SINGLECLIENT)
+    {
+        vis->flags |= SVDEMO_VIS_SINGLECLIENT;
+    }
+    if (ent->r.svFlags & SVF_NOTSINGLECLIENT)
+    {
+        vis->flags |= SVDEMO_VIS_NOTSINGLECLIENT;
+    }
+    if (ent->r.svFlags & SVF_CLIENTMASK)
+    {
+        vis->flags |= SVDEMO_VIS_CLIENTMASK;
+    }
+    vis->singleClient = vis->flags ? ent->r.singleClient : 0;
+    vis->generic1 = (vis->flags & SVDEMO_VIS_CLIENTMASK) ? ent->r.hack.generic1 : 0;
+}
+
+/*
+==================
+SV_DemoWriteFrame
+
+Encodes the world once for all clients.  Called after the game has run,
+only when the server time advanced.
+==================
+*/
+void SV_DemoWriteFrame(void)
+{
+    msg_t msg;
+
+    if (!svDemo || sv.state != SS_GAME || sv.time == svDemo->lastTime)
+    {
+        return;
+    }
+    svDemo->lastTime = sv.time;
+
+    MSG_Init(&msg, svDemoMsgBuf, sizeof(svDemoMsgBuf));
+    MSG_Bitstream(&msg);
+
+    MSG_WriteByte(&msg, svdm_frame);
+    MSG_WriteLong(&msg, sv.time);
+
+    // configstrings
+    for (int i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        if (!svDemo->csDirty[i])
+        {
+            continue;
+        }
+        svDemo->csDirty[i] = false;
+        MSG_WriteShort(&msg, i);
+        MSG_WriteBigString(&msg, sv.configstrings[i].s);
+    }
+    MSG_WriteShort(&msg, MAX_CONFIGSTRINGS);
+
+    // server commands
+    for (int i = 0; i < svDemo->commandBytes;)
+    {
+        const char *cmd = svDemo->commands + i + 1;
+
+        MSG_WriteByte(&msg, 1);
+        MSG_WriteByte(&msg, (byte)svDemo->commands[i]);
+        MSG_WriteBigString(&msg, cmd);
+        i += 1 + strlen(cmd) + 1;
+    }
+    MSG_WriteByte(&msg, 0);
+    svDemo->commandBytes = 0;
+
+    // playerstates
+    for (int i = 0; i < sv_maxclients->integer; i++)
+    {
+        playerState_t *ps;
+
+        if (svs.clients[i].state != CS_ACTIVE)
+        {
+            if (svDemo->psValid[i])
+            {
+                MSG_WriteBits(&msg, 1, 1);
+                MSG_WriteBits(&msg, 0, 1);
+                svDemo->psValid[i] = false;
+            }
+            else
+            {
+                MSG_WriteBits(&msg, 0, 1);
+            }
+            continue;
+        }
+
+        ps = SV_GameClientNum(i);
+        MSG_WriteBits(&msg, 1, 1);
+        MSG_WriteBits(&msg, 1, 1);
+        MSG_WriteDeltaPlayerstate(0, &msg, svDemo->psValid[i] ? &svDemo->ps[i] : NULL, ps);
+        svDemo->ps[i] = *ps;
+        svDemo->psValid[i] = true;
+    }
+
+    // entities
+    for (int e = 0; e < MAX_GENTITIES - 1; e++)
+    {
+        sharedEntity_t *ent = NULL;
+
+        if (e < sv.num_entities)
+        {
+            ent = SV_GentityNum(e);
+            if (!ent->r.linked || (ent->r.svFlags & SVF_NOCLIENT))
+            {
+                ent = NULL;
+            }
+        }
+
+        if (!ent)
+        {
+            if (svDemo->entValid[e])
+            {
+                MSG_WriteDeltaEntity(0, &msg, &svDemo->ents[e], NULL, true);
+                svDemo->entValid[e] = false;
+                ::memset(&svDemo->vis[e], 0, sizeof(svDemo->vis[e]));
+            }
+            continue;
+        }
+
+        if (ent->s.number != e)
+        {
+            Com_DPrintf("FIXING ENT->S.NUMBER!!!\n");
+            ent->s.number = e;
+        }
+
+        if (svDemo->entValid[e])
+        {
+            MSG_WriteDeltaEntity(0, &msg, &svDemo->ents[e], &ent->s, false);
+        }
+        else
+        {
+            MSG_WriteDeltaEntity(0, &msg, SV_DemoBaseline(e), &ent->s, true);
+        }
+        svDemo->ents[e] = ent->s;
+        svDemo->entValid[e] = true;
+    }
+    MSG_WriteBits(&msg, MAX_GENTITIES - 1, GENTITYNUM_BITS);
+
+    // visibility of entities sent to some clients only
+    for (int e = 0; e < MAX_GENTITIES - 1; e++)
+    {
+        svDemoVis_t vis;
+
+        if (!svDemo->entValid[e])
+        {
+            continue;
+        }
+
+        SV_DemoEntityVis(SV_GentityNum(e), &vis);
+        if (!::memcmp(&vis, &svDemo->vis[e], sizeof(vis)))
+        {
+            continue;
+        }
+        svDemo->vis[e] = vis;
+
+        MSG_WriteBits(&msg, e, GENTITYNUM_BITS);
+        MSG_WriteByte(&msg, vis.flags);
+        MSG_WriteLong(&msg, vis.singleClient);
+        MSG_WriteLong(&msg, vis.generic1);
+    }
+    MSG_WriteBits(&msg, MAX_GENTITIES - 1, GENTITYNUM_BITS);
+
+    if (msg.overflowed)
+    {
+        // the delta state no longer matches what was written
+        Com_Printf(S_COLOR_YELLOW "WARNING: server demo frame overflowed, stopping\n");
+        SV_DemoStop();
+        return;
+    }
+
+    SV_DemoWriteBlock(&msg);
+    svDemo->frames++;
+}
+
+/*
+==================
+SV_DemoStartDated
+
+Names the demo after the current date and map
+==================
+*/
+static void SV_DemoStartDated(void)
+{
+    qtime_t now;
+
+    Com_RealTime(&now);
+    SV_DemoStart(va("%04d%02d%02d-%02d%02d%02d-%s", 1900 + now.tm_year, 1 + now.tm_mon, now.tm_mday,
+        now.tm_hour, now.tm_min, now.tm_sec, sv_mapname->string));
+}
+
+/*
+==================
+SV_DemoAutoRecord
+
+Called when a map has been spawned
+==================
+*/
+void SV_DemoAutoRecord(void)
+{
+    if (sv_demoAutoRecord->integer)
+    {
+        SV_DemoStartDated();
+    }
+}
+
+/*
+==================
+SV_Record_f
+
+svrecord [demoname]
+==================
+*/
+static void SV_Record_f(void)
+{
+    if (!com_sv_running->integer || sv.state != SS_GAME)
+    {
+        Com_Printf("Server is not running.\n");
+        return;
+    }
+
+    if (Cmd_Argc() > 2)
+    {
+        Com_Printf("svrecord [demoname]\n");
+        return;
+    }
+
+    if (Cmd_Argc() == 2)
+    {
+        SV_DemoStart(Cmd_Argv(1));
+    }
+    else
+    {
+        SV_DemoStartDated();
+    }
+}
+
+/*
+==================
+SV_StopRecord_f
+==================
+*/
+static void SV_StopRecord_f(void)
+{
+    if (!svDemo)
+    {
+        Com_Printf("Not recording a server demo.\n");
+        return;
+    }
+    SV_DemoStop();
+}
+
+/*
+=============================================================================
+
+Conversion to a client demo
+
+Replays a server demo and writes the messages the server would have sent to
+one client: the gamestate, then per frame the pending server commands and a
+snapshot delta compressed against the previous one.  The area mask is left
+empty and entities are not PVS culled; when there are more than a snapshot
+can hold the ones nearest to the player are kept.
+
+=============================================================================
+*/
+
+struct svDemoConvert_t {
+    fileHandle_t in;
+    fileHandle_t out;
+    int clientNum;
+    int maxclients;
+    int checksumFeed;
+
+    char *configstrings[MAX_CONFIGSTRINGS];
+    entityState_t baselines[MAX_GENTITIES];
+
+    bool psValid[MAX_CLIENTS];
+    playerState_t ps[MAX_CLIENTS];
+
+    bool entValid[MAX_GENTITIES];
+    entityState_t ents[MAX_GENTITIES];
+    svDemoVis_t vis[MAX_GENTITIES];
+
+    // the last snapshot written to the client demo
+    int snapMessage;
+    playerState_t snapPs;
+    int snapNumEntities;
+    int snapNums[MAX_SNAPSHOT_ENTITIES];
+    entityState_t snapEnts[MAX_GENTITIES];
+
+    int messageNum;
+    int commandSequence;
+    int snapshots;
+};
+
+struct svDemoCandidate_t {
+    int num;
+    float dist;
+};
+
+/*
+==================
+SV_DemoCompareDist
+==================
+*/
+static int SV_DemoCompareDist(const void *a, const void *b)
+{
+    float da = ((const svDemoCandidate_t *)a)->dist;
+    float db = ((const svDemoCandidate_t *)b)->dist;
+
+    return da < db ? -1 : da > db ? 1 : 0;
+}
+
+/*
+==================
+SV_DemoCompareNum
+==================
+*/
+static int SV_DemoCompareNum(const void *a, const void *b)
+{
+    return ((const svDemoCandidate_t *)a)->num - ((const svDemoCandidate_t *)b)->num;
+}
+
+/*
+==================
+SV_DemoReadBlock
+
+Returns false at the end of the demo
+==================
+*/
+static bool SV_DemoReadBlock(svDemoConvert_t *c, msg_t *msg)
+{
+    int len;
+
+    MSG_Init(msg, svDemoMsgBuf, sizeof(svDemoMsgBuf));
+    if (FS_Read(&len, 4, c->in) != 4)
+    {
+        return false;
+    }
+    len = LittleLong(len);
+    if (len < 0)
+    {
+        return false;
+    }
+    if (len > msg->maxsize)
+    {
+        Com_Printf("SV_DemoReadBlock: block length %d > %d\n", len, msg->maxsize);
+        return false;
+    }
+    if (FS_Read(msg->data, len, c->in) != len)
+    {
+        Com_Printf("SV_DemoReadBlock: demo file is truncated\n");
+        return false;
+    }
+
+    msg->cursize = len;
+    MSG_Bitstream(msg);
+    MSG_BeginReading(msg);
+    return true;
+}
+
+/*
+==================
+SV_DemoWriteClientMessage
+==================
+*/
+static void SV_DemoWriteClientMessage(svDemoConvert_t *c, msg_t *msg)
+{
+    int len;
+
+    MSG_WriteByte(msg, svc_EOF);
+
+    len = LittleLong(c->messageNum);
+    FS_Write(&len, 4, c->out);
+    len = LittleLong(msg->cursize);
+    FS_Write(&len, 4, c->out);
+    FS_Write(msg->data, msg->cursize, c->out);
+}
+
+/*
+==================
+SV_DemoBeginClientMessage
+==================
+*/
+static void SV_DemoBeginClientMessage(svDemoConvert_t *c, msg_t *msg, byte *data, int size)
+{
+    MSG_Init(msg, data, size);
+    MSG_Bitstream(msg);
+    c->messageNum++;
+
+    // reliable acknowledge
+    MSG_WriteLong(msg, 0);
+}
+
+/*
+==================
+SV_DemoQueueCommand
+
+Adds a server command, starting a new message if this one is getting full
+==================
+*/
+static void SV_DemoQueueCommand(svDemoConvert_t *c, msg_t *msg, const char *cmd)
+{
+    if (msg->cursize > MAX_MSGLEN / 2)
+    {
+        SV_DemoWriteClientMessage(c, msg);
+        SV_DemoBeginClientMessage(c, msg, msg->data, msg->maxsize);
+    }
+
+    MSG_WriteByte(msg, svc_serverCommand);
+    MSG_WriteLong(msg, ++c->commandSequence);
+    MSG_WriteString(msg, cmd);
+}
+
+/*
+==================
+SV_DemoQueueConfigstring
+
+Same splitting as SV_SendConfigstring
+==================
+*/
+static void SV_DemoQueueConfigstring(svDemoConvert_t *c, msg_t *msg, int index)
+{
+    const char *cs = c->configstrings[index];
+    int maxChunkSize = MAX_STRING_CHARS - 24;
+    int len = strlen(cs);
+    char buf[MAX_STRING_CHARS];
+
+    if (len < maxChunkSize)
+    {
+        SV_DemoQueueCommand(c, msg, va("cs %i \"%s\"\n", index, cs));
+        return;
+    }
+
+    for (int sent = 0, remaining = len; remaining > 0;)
+    {
+        const char *cmd;
+
+        if (sent == 0)
+        {
+            cmd = "bcs0";
+        }
+        else if (remaining < maxChunkSize)
+        {
+            cmd = "bcs2";
+        }
+        else
+        {
+            cmd = "bcs1";
+        }
+        Q_strncpyz(buf, &cs[sent], maxChunkSize);
+        SV_DemoQueueCommand(c, msg, va("%s %i \"%s\"\n", cmd, index, buf));
+
+        sent += maxChunkSize - 1;
+        remaining -= maxChunkSize - 1;
+    }
+}
+
+/*
+==================
+SV_DemoVisibleTo
+==================
+*/
+static bool SV_DemoVisibleTo(const svDemoVis_t *vis, int clientNum)
+{
+    if ((vis->flags & SVDEMO_VIS_SINGLECLIENT) && vis->singleClient != clientNum)
+    {
+        return false;
+    }
+    if ((vis->flags & SVDEMO_VIS_NOTSINGLECLIENT) && vis->singleClient == clientNum)
+    {
+        return false;
+    }
+    if (vis->flags & SVDEMO_VIS_CLIENTMASK)
+    {
+        if (clientNum >= 32)
+        {
+            if (~vis->generic1 & (1 << (clientNum - 32))) return false;
+        }
+        else
+        {
+            if (~vis->singleClient & (1 << clientNum)) return false;
+        }
+    }
+    return true;
+}
+
+/*
+==================
+SV_DemoConvertGamestate
+==================
+*/
+static bool SV_DemoConvertGamestate(svDemoConvert_t *c, msg_t *in)
+{
+    byte bufData[MAX_MSGLEN];
+    msg_t msg;
+    entityState_t nullstate;
+    int i;
+
+    c->checksumFeed = MSG_ReadLong(in);
+    c->maxclients = MSG_ReadLong(in);
+    if (c->maxclients <= 0 || c->maxclients > MAX_CLIENTS)
+    {
+        Com_Printf("SV_DemoConvertGamestate: bad maxclients %d\n", c->maxclients);
+        return false;
+    }
+    if (c->clientNum >= c->maxclients)
+    {
+        Com_Printf("Client %d is out of range, the demo has %d slots.\n", c->clientNum, c->maxclients);
+        return false;
+    }
+
+    while ((i = MSG_ReadShort(in)) != MAX_CONFIGSTRINGS)
+    {
+        if (i < 0 || i >= MAX_CONFIGSTRINGS || in->readcount > in->cursize)
+        {
+            Com_Printf("SV_DemoConvertGamestate: bad configstring %d\n", i);
+            return false;
+        }
+        Z_Free(c->configstrings[i]);
+        c->configstrings[i] = CopyString(MSG_ReadBigString(in));
+    }
+
+    ::memset(&nullstate, 0, sizeof(nullstate));
+    while ((i = MSG_ReadBits(in, GENTITYNUM_BITS)) != MAX_GENTITIES - 1)
+    {
+        if (in->readcount > in->cursize)
+        {
+            Com_Printf("SV_DemoConvertGamestate: truncated baselines\n");
+            return false;
+        }
+        MSG_ReadDeltaEntity(0, in, &nullstate, &c->baselines[i], i);
+    }
+
+    SV_DemoBeginClientMessage(c, &msg, bufData, sizeof(bufData));
+
+    MSG_WriteByte(&msg, svc_gamestate);
+    MSG_WriteLong(&msg, c->commandSequence);
+
+    for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        if (!c->configstrings[i][0])
+        {
+            continue;
+        }
+        MSG_WriteByte(&msg, svc_configstring);
+        MSG_WriteShort(&msg, i);
+        MSG_WriteBigString(&msg, c->configstrings[i]);
+    }
+
+    for (i = 0; i < MAX_GENTITIES; i++)
+    {
+        if (!c->baselines[i].number)
+        {
+            continue;
+        }
+        MSG_WriteByte(&msg, svc_baseline);
+        MSG_WriteDeltaEntity(0, &msg, &nullstate, &c->baselines[i], true);
+    }
+
+    MSG_WriteByte(&msg, svc_EOF);
+    MSG_WriteLong(&msg, c->clientNum);
+    MSG_WriteLong(&msg, c->checksumFeed);
+
+    if (msg.overflowed)
+    {
+        Com_Printf("SV_DemoConvertGamestate: gamestate does not fit in a message\n");
+        return false;
+    }
+
+    SV_DemoWriteClientMessage(c, &msg);
+    return true;
+}
+
+/*
+==================
+SV_DemoWriteSnapshot
+==================
+*/
+static void SV_DemoWriteSnapshot(svDemoConvert_t *c, msg_t *msg, int serverTime)
+{
+    static svDemoCandidate_t candidates[MAX_GENTITIES];
+    playerState_t *ps = &c->ps[c->clientNum];
+    int numCandidates = 0;
+    int lastframe;
+    int oldIndex, newIndex;
+
+    for (int e = 0; e < MAX_GENTITIES - 1; e++)
+    {
+        vec3_t delta;
+
+        if (!c->entValid[e] || e == ps->clientNum || !SV_DemoVisibleTo(&c->vis[e], ps->clientNum))
+        {
+            continue;
+        }
+
+        VectorSubtract(c->ents[e].pos.trBase, ps->origin, delta);
+        candidates[numCandidates].num = e;
+        candidates[numCandidates].dist = VectorLengthSquared(delta);
+        numCandidates++;
+    }
+
+    if (numCandidates > MAX_SNAPSHOT_ENTITIES)
+    {
+        qsort(candidates, numCandidates, sizeof(candidates[0]), SV_DemoCompareDist);
+        numCandidates = MAX_SNAPSHOT_ENTITIES;
+        qsort(candidates, numCandidates, sizeof(candidates[0]), SV_DemoCompareNum);
+    }
+
+    lastframe = c->snapMessage ? c->messageNum - c->snapMessage : 0;
+    if (lastframe >= PACKET_BACKUP)
+    {
+        lastframe = 0;
+    }
+
+    MSG_WriteByte(msg, svc_snapshot);
+    MSG_WriteLong(msg, serverTime);
+    MSG_WriteByte(msg, lastframe);
+    MSG_WriteByte(msg, 0);  // snapFlags
+    MSG_WriteByte(msg, 0);  // areabytes, everything visible
+
+    MSG_WriteDeltaPlayerstate(0, msg, lastframe ? &c->snapPs : NULL, ps);
+
+    // same walk as SV_EmitPacketEntities
+    oldIndex = newIndex = 0;
+    while (newIndex < numCandidates || (lastframe && oldIndex < c->snapNumEntities))
+    {
+        int newnum = newIndex < numCandidates ? candidates[newIndex].num : 9999;
+        int oldnum = (lastframe && oldIndex < c->snapNumEntities) ? c->snapNums[oldIndex] : 9999;
+
+        if (newnum == oldnum)
+        {
+            MSG_WriteDeltaEntity(0, msg, &c->snapEnts[oldnum], &c->ents[newnum], false);
+            oldIndex++;
+            newIndex++;
+        }
+        else if (newnum < oldnum)
+        {
+            MSG_WriteDeltaEntity(0, msg, &c->baselines[newnum], &c->ents[newnum], true);
+            newIndex++;
+        }
+        else
+        {
+            MSG_WriteDeltaEntity(0, msg, &c->snapEnts[oldnum], NULL, true);
+            oldIndex++;
+        }
+    }
+    MSG_WriteBits(msg, MAX_GENTITIES - 1, GENTITYNUM_BITS);
+
+    c->snapMessage = c->messageNum;
+    c->snapPs = *ps;
+    c->snapNumEntities = numCandidates;
+    for (int i = 0; i < numCandidates; i++)
+    {
+        int num = candidates[i].num;
+
+        c->snapNums[i] = num;
+        c->snapEnts[num] = c->ents[num];
+    }
+    c->snapshots++;
+}
+
+/*
+==================
+SV_DemoConvertFrame
+==================
+*/
+static bool SV_DemoConvertFrame(svDemoConvert_t *c, msg_t *in)
+{
+    byte bufData[MAX_MSGLEN];
+    msg_t msg;
+    int serverTime;
+    int i;
+
+    SV_DemoBeginClientMessage(c, &msg, bufData, sizeof(bufData));
+
+    serverTime = MSG_ReadLong(in);
+
+    while ((i = MSG_ReadShort(in)) != MAX_CONFIGSTRINGS)
+    {
+        if (i < 0 || i >= MAX_CONFIGSTRINGS || in->readcount > in->cursize)
+        {
+            Com_Printf("SV_DemoConvertFrame: bad configstring %d\n", i);
+            return false;
+        }
+        Z_Free(c->configstrings[i]);
+        c->configstrings[i] = CopyString(MSG_ReadBigString(in));
+        SV_DemoQueueConfigstring(c, &msg, i);
+    }
+
+    while (MSG_ReadByte(in) == 1)
+    {
+        int target = MSG_ReadByte(in);
+        const char *cmd = MSG_ReadBigString(in);
+
+        if (target == 0xff || target == c->clientNum)
+        {
+            SV_DemoQueueCommand(c, &msg, cmd);
+        }
+    }
+
+    for (i = 0; i < c->maxclients; i++)
+    {
+        if (!MSG_ReadBits(in, 1))
+        {
+            continue;
+        }
+        if (!MSG_ReadBits(in, 1))
+        {
+            c->psValid[i] = false;
+            continue;
+        }
+        MSG_ReadDeltaPlayerstate(in, c->psValid[i] ? &c->ps[i] : NULL, &c->ps[i]);
+        c->psValid[i] = true;
+    }
+
+    while ((i = MSG_ReadBits(in, GENTITYNUM_BITS)) != MAX_GENTITIES - 1)
+    {
+        entityState_t to;
+
+        if (in->readcount > in->cursize)
+        {
+            Com_Printf("SV_DemoConvertFrame: truncated entities\n");
+            return false;
+        }
+        MSG_ReadDeltaEntity(0, in, c->entValid[i] ? &c->ents[i] : &c->baselines[i], &to, i);
+        if (to.number == MAX_GENTITIES - 1)
+        {
+            c->entValid[i] = false;
+            ::memset(&c->vis[i], 0, sizeof(c->vis[i]));
+            continue;
+        }
+        c->ents[i] = to;
+        c->entValid[i] = true;
+    }
+
+    while ((i = MSG_ReadBits(in, GENTITYNUM_BITS)) != MAX_GENTITIES - 1)
+    {
+        if (in->readcount > in->cursize)
+        {
+            Com_Printf("SV_DemoConvertFrame: truncated visibility\n");
+            return false;
+        }
+        c->vis[i].flags = MSG_ReadByte(in);
+        c->vis[i].singleClient = MSG_ReadLong(in);
+        c->vis[i].generic1 = MSG_ReadLong(in);
+    }
+
+    if (c->psValid[c->clientNum])
+    {
+        SV_DemoWriteSnapshot(c, &msg, serverTime);
+    }
+    else if (msg.cursize <= 4)
+    {
+        // nothing for this client, don't use up a message number
+        c->messageNum--;
+        return true;
+    }
+
+    if (msg.overflowed)
+    {
+        Com_Printf("SV_DemoConvertFrame: message overflowed at time %d\n", serverTime);
+        return false;
+    }
+
+    SV_DemoWriteClientMessage(c, &msg);
+    return true;
+}
+
+/*
+==================
+SV_DemoConvert_f
+
+svdemo_convert <svdemo> <clientnum>
+==================
+*/
+static void SV_DemoConvert_f(void)
+{
+    char name[MAX_OSPATH];
+    char base[MAX_QPATH];
+    char outName[MAX_OSPATH];
+    svDemoConvert_t *c;
+    msg_t in;
+    int header[3];
+    bool ok = true;
+    int len;
+
+    if (Cmd_Argc() != 3)
+    {
+        Com_Printf("svdemo_convert <svdemo> <clientnum>\n");
+        return;
+    }
+
+    if (svDemo)
+    {
+        Com_Printf("Can't convert while recording a server demo.\n");
+        return;
+    }
+
+    Com_sprintf(name, sizeof(name), "svdemos/%s", Cmd_Argv(1));
+    COM_DefaultExtension(name, sizeof(name), "." SVDEMO_EXT);
+    COM_StripExtension(COM_SkipPath(name), base, sizeof(base));
+
+    c = (svDemoConvert_t *)Z_Malloc(sizeof(*c));
+    c->clientNum = atoi(Cmd_Argv(2));
+    for (int i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        c->configstrings[i] = CopyString("");
+    }
+
+    if (c->clientNum < 0 || c->clientNum >= MAX_CLIENTS)
+    {
+        Com_Printf("Bad client number %d.\n", c->clientNum);
+        ok = false;
+    }
+    else if (FS_FOpenFileRead(name, &c->in, true) < 0 || !c->in)
+    {
+        Com_Printf("Couldn't open %s.\n", name);
+        c->in = 0;
+        ok = false;
+    }
+    else if (FS_Read(header, sizeof(header), c->in) != sizeof(header) ||
+             LittleLong(header[0]) != SVDEMO_MAGIC ||
+             LittleLong(header[1]) != SVDEMO_VERSION)
+    {
+        Com_Printf("%s is not a server demo.\n", name);
+        ok = false;
+    }
+    else if (!SV_DemoReadBlock(c, &in) || MSG_ReadByte(&in) != svdm_gamestate)
+    {
+        Com_Printf("%s has no gamestate.\n", name);
+        ok = false;
+    }
+    else
+    {
+        Com_sprintf(outName, sizeof(outName), "demos/%s-%d.%s%d",
+            base, c->clientNum, DEMOEXT, LittleLong(header[2]));
+        c->out = FS_FOpenFileWrite(outName);
+        if (!c->out)
+        {
+            Com_Printf("Couldn't open %s for writing.\n", outName);
+            ok = false;
+        }
+    }
+
+    if (ok)
+    {
+        ok = SV_DemoConvertGamestate(c, &in);
+    }
+
+    while (ok && SV_DemoReadBlock(c, &in))
+    {
+        if (MSG_ReadByte(&in) != svdm_frame)
+        {
+            Com_Printf("%s: unexpected block.\n", name);
+            break;
+        }
+        ok = SV_DemoConvertFrame(c, &in);
+    }
+
+    if (c->out)
+    {
+        len = -1;
+        FS_Write(&len, 4, c->out);
+        FS_Write(&len, 4, c->out);
+        FS_FCloseFile(c->out);
+        Com_Printf("Wrote %s: %d snapshots.\n", outName, c->snapshots);
+    }
+    if (c->in)
+    {
+        FS_FCloseFile(c->in);
+    }
+
+    for (int i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        Z_Free(c->configstrings[i]);
+    }
+    Z_Free(c);
+}
+
+/*
+==================
+SV_DemoInit
+==================
+*/
+void SV_DemoInit(void)
+{
+    sv_demoAutoRecord = Cvar_Get("sv_demoAutoRecord", "0", CVAR_ARCHIVE);
+
+    Cmd_AddCommand("svrecord", SV_Record_f);
+    Cmd_AddCommand("svstoprecord", SV_StopRecord_f);
+    Cmd_AddCommand("svdemo_convert", SV_DemoConvert_f);
+}
@@ -286,13 +286,69 @@ void SV_LocateGameData( sharedEntity_t *gEnts, int numGEntities, int sizeofGEnti
 ===============
 SV_GetUsercmd
 
+During a GAME_CLIENT_THINK_BATCH this is the command being run
 ===============
 */
 void SV_GetUsercmd( int clientNum, usercmd_t *cmd ) {
+	client_t *cl;
+
 	if ( clientNum < 0 || clientNum >= sv_maxclients->integer ) {
 		Com_Error( ERR_DROP, "SV_GetUsercmd: bad clientNum:%i", clientNum );
 	}
-	*cmd = svs.clients[clientNum].lastUsercmd;
+	cl = &svs.clients[clientNum];
+
+	if ( cl->numThinkCmds ) {
+		*cmd = cl->thinkCmds[cl->thinkCmd];
+	} else {
+		*cmd = cl->lastUsercmd;
+	}
+}
+
+/*
+===============
+SV_GetUsercmds
+
+Copies the commands of the current GAME_CLIENT_THINK_BATCH, returns how
+many were copied
+===============
+*/
+int SV_GetUsercmds( int clientNum, usercmd_t *cmds, int maxcmds ) {
+	client_t *cl;
+	int count;
+
+	if ( clientNum < 0 || clientNum >= sv_maxclients->integer ) {
+		Com_Error( ERR_DROP, "SV_GetUsercmds: bad clientNum:%i", clientNum );
+	}
+	cl = &svs.clients[clientNum];
+
+	count = cl->numThinkCmds;
+	if ( count > maxcmds ) {
+		count = maxcmds;
+	}
+	Com_Memcpy( cmds, cl->thinkCmds, count * sizeof( *cmds ) );
+	return count;
+}
+
+/*
+===============
+SV_SetThinkCmd
+
+Tells the server which command of the current GAME_CLIENT_THINK_BATCH the
+game is about to run
+===============
+*/
+void SV_SetThinkCmd( int clientNum, int cmdNum ) {
+	client_t *cl;
+
+	if ( clientNum < 0 || clientNum >= sv_maxclients->integer ) {
+		Com_Error( ERR_DROP, "SV_SetThinkCmd: bad clientNum:%i", clientNum );
+	}
+	cl = &svs.clients[clientNum];
+
+	if ( cmdNum < 0 || cmdNum >= cl->numThinkCmds ) {
+		Com_Error( ERR_DROP, "SV_SetThinkCmd: bad cmdNum:%i", cmdNum );
+	}
+	cl->thinkCmd = cmdNum;
 }
 
 //==============================================
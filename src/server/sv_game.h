@@ -39,6 +39,8 @@ SO_PUBLIC bool SV_inPVSIgnorePortals(const vec3_t p1, const vec3_t p2);
 SO_PUBLIC void SV_AdjustAreaPortalState(sharedEntity_t *ent, bool open);
 SO_PUBLIC bool SV_EntityContact(vec3_t mins, vec3_t maxs, const sharedEntity_t *ent, traceType_t type);
 SO_PUBLIC void SV_GetUsercmd(int clientNum, usercmd_t *cmd);
+SO_PUBLIC int SV_GetUsercmds(int clientNum, usercmd_t *cmds, int maxcmds);
+SO_PUBLIC void SV_SetThinkCmd(int clientNum, int cmdNum);
 SO_PUBLIC bool SV_GetEntityToken(char *buffer, int bufferSize);
 
 //SO_PUBLIC void SV_SendClientGameState2(int clientNum)
@@ -30,34 +30,102 @@ char alternateInfos[2][2][BIG_INFO_STRING];
 
 /*
 ===============
-SV_SendConfigstring
+SV_ClientConfigstring
 
-Creates and sends the server command necessary to update the CS index for the
-given client
+The value of configstring i as the given client should see it
 ===============
 */
-static void SV_SendConfigstring(client_t *client, int i)
+static const char *SV_ClientConfigstring(client_t *client, int i)
 {
-    const char *configstring;
-    int maxChunkSize = MAX_STRING_CHARS - 24;
-    int len;
-
     if (sv.configstrings[i].restricted &&
         Com_ClientListContains(&sv.configstrings[i].clientList, client - svs.clients))
     {
         // Send a blank config string for this client if it's listed
-        SV_SendServerCommand(client, "cs %i \"\"\n", i);
-        return;
+        return "";
     }
 
     if (i <= CS_SYSTEMINFO && client->netchan.alternateProtocol != 0)
     {
-        configstring = alternateInfos[i][client->netchan.alternateProtocol - 1];
+        return alternateInfos[i][client->netchan.alternateProtocol - 1];
     }
-    else
+
+    return sv.configstrings[i].s;
+}
+
+// csSent value of configstrings whose value on the client is not known
+static char csUnknown[1];
+
+/*
+===============
+SV_CopyConfigstring
+
+Per client copies come from the main zone, there can be many of them
+===============
+*/
+static char *SV_CopyConfigstring(const char *s)
+{
+    int len = strlen(s) + 1;
+    char *copy = (char *)Z_Malloc(len);
+
+    ::memcpy(copy, s, len);
+    return copy;
+}
+
+/*
+===============
+SV_SentConfigstring
+
+Remembers the value a client has been sent for configstring i.  Only values
+that differ from sv.configstrings are stored.
+===============
+*/
+static void SV_SentConfigstring(client_t *client, int i, const char *value)
+{
+    if (client->csSent[i] && client->csSent[i] != csUnknown)
+    {
+        Z_Free(client->csSent[i]);
+    }
+    client->csSent[i] = NULL;
+
+    if (client->csSynced && strcmp(value, sv.configstrings[i].s))
+    {
+        client->csSent[i] = SV_CopyConfigstring(value);
+    }
+}
+
+/*
+===============
+SV_ConfigstringChanging
+
+Called before sv.configstrings[i] is replaced, so clients that still have
+the old value keep it as their delta base
+===============
+*/
+static void SV_ConfigstringChanging(int i)
+{
+    client_t *client;
+    int c;
+
+    for (c = 0, client = svs.clients; c < sv_maxclients->integer; c++, client++)
     {
-        configstring = sv.configstrings[i].s;
+        if (client->csSynced && !client->csSent[i])
+        {
+            client->csSent[i] = SV_CopyConfigstring(sv.configstrings[i].s);
+        }
     }
+}
+
+/*
+===============
+SV_SendConfigstringCommands
+
+Sends configstring as a cs command, split into bcs commands if it is too long
+===============
+*/
+static void SV_SendConfigstringCommands(client_t *client, int i, const char *configstring)
+{
+    int maxChunkSize = MAX_STRING_CHARS - 24;
+    int len;
 
     len = strlen(configstring);
 
@@ -97,6 +165,229 @@ static void SV_SendConfigstring(client_t *client, int i)
     }
 }
 
+/*
+===============
+SV_SendConfigstring
+
+Creates and sends the server command necessary to update the CS index for the
+given client
+===============
+*/
+static void SV_SendConfigstring(client_t *client, int i)
+{
+    if (client->csBatch)
+    {
+        // goes out with the rest of this frame's changes
+        if (!client->csQueued[i])
+        {
+            client->csQueued[i] = true;
+            client->numCsQueued++;
+        }
+        return;
+    }
+
+    SV_SendConfigstringCommands(client, i, SV_ClientConfigstring(client, i));
+}
+
+/*
+===============
+SV_FlushConfigstrings
+
+Sends the queued configstrings of a client as csb commands:
+
+csb <index> "<string>" <index>:<keep>:<tail> "<middle>" ...
+
+An entry with keep and tail replaces the middle of the string the client
+already has, keeping its first keep and last tail characters.  Strings too
+long for a batch are sent with the regular cs/bcs commands, after the
+entries collected before them so the order is kept.
+===============
+*/
+void SV_FlushConfigstrings(client_t *client)
+{
+    char cmd[MAX_STRING_CHARS];
+    char entry[MAX_STRING_CHARS];
+    int cmdLen, entryLen;
+
+    if (!client->numCsQueued || client->state != CS_ACTIVE)
+    {
+        return;
+    }
+    client->numCsQueued = 0;
+
+    cmdLen = Com_sprintf(cmd, sizeof(cmd), "csb");
+    for (int i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        const char *value;
+        const char *base;
+
+        if (!client->csQueued[i])
+        {
+            continue;
+        }
+        client->csQueued[i] = false;
+
+        value = SV_ClientConfigstring(client, i);
+        base = NULL;
+        if (client->csSynced && client->csSent[i] != csUnknown)
+        {
+            base = client->csSent[i] ? client->csSent[i] : sv.configstrings[i].s;
+        }
+        if (base && !strcmp(base, value))
+        {
+            continue;
+        }
+
+        entryLen = -1;
+        if (strlen(value) < sizeof(entry) - 16)
+        {
+            entryLen = Com_sprintf(entry, sizeof(entry), "%i \"%s\"", i, value);
+        }
+
+        if (base)
+        {
+            int baseLen = strlen(base);
+            int valueLen = strlen(value);
+            int keep = 0, tail = 0;
+
+            while (keep < baseLen && keep < valueLen && base[keep] == value[keep])
+            {
+                keep++;
+            }
+            while (tail < baseLen - keep && tail < valueLen - keep &&
+                   base[baseLen - 1 - tail] == value[valueLen - 1 - tail])
+            {
+                tail++;
+            }
+
+            if (valueLen - keep - tail < (int)sizeof(entry) - 32 &&
+                (entryLen < 0 || valueLen - keep - tail + 16 < entryLen))
+            {
+                entryLen = Com_sprintf(entry, sizeof(entry), "%i:%i:%i \"%.*s\"", i, keep, tail,
+                                       valueLen - keep - tail, value + keep);
+            }
+        }
+
+        if (entryLen < 0 || entryLen >= MAX_STRING_CHARS - 24)
+        {
+            if (cmdLen > 3)
+            {
+                SV_AddServerCommand(client, cmd);
+                cmdLen = Com_sprintf(cmd, sizeof(cmd), "csb");
+            }
+            SV_SendConfigstringCommands(client, i, value);
+        }
+        else
+        {
+            if (cmdLen + 1 + entryLen > 1022)
+            {
+                SV_AddServerCommand(client, cmd);
+                cmdLen = Com_sprintf(cmd, sizeof(cmd), "csb");
+            }
+            cmdLen += Com_sprintf(cmd + cmdLen, sizeof(cmd) - cmdLen, " %s", entry);
+        }
+
+        if (client->state != CS_ACTIVE)
+        {
+            // dropped for overflowing its reliable commands
+            return;
+        }
+
+        SV_SentConfigstring(client, i, value);
+    }
+
+    if (cmdLen > 3)
+    {
+        SV_AddServerCommand(client, cmd);
+    }
+}
+
+/*
+===============
+SV_ConfigstringsSent
+
+Called when a gamestate goes out, the client now has every configstring
+as it is in sv.configstrings
+===============
+*/
+void SV_ConfigstringsSent(client_t *client)
+{
+    if (!client->csBatch)
+    {
+        return;
+    }
+
+    for (int i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        if (client->csSent[i] && client->csSent[i] != csUnknown)
+        {
+            Z_Free(client->csSent[i]);
+        }
+        client->csSent[i] = NULL;
+    }
+    client->csSynced = true;
+}
+
+/*
+===============
+SV_FreeConfigstrings
+===============
+*/
+void SV_FreeConfigstrings(client_t *client)
+{
+    for (int i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        if (client->csSent[i] && client->csSent[i] != csUnknown)
+        {
+            Z_Free(client->csSent[i]);
+        }
+        client->csSent[i] = NULL;
+        client->csQueued[i] = false;
+    }
+    client->numCsQueued = 0;
+    client->csSynced = false;
+}
+
+/*
+===============
+SV_SetConfigstringBatching
+
+Called when the client says whether it understands csb commands
+===============
+*/
+void SV_SetConfigstringBatching(client_t *client, bool enable)
+{
+    if (client->csBatch == enable)
+    {
+        return;
+    }
+
+    SV_FlushConfigstrings(client);
+    SV_FreeConfigstrings(client);
+    client->csBatch = enable;
+
+    if (!enable || client->state < CS_PRIMED)
+    {
+        // the gamestate will tell what the client has
+        return;
+    }
+
+    // so far every change went out as it happened, except those held back
+    // while the client is primed, which are unknown until they are sent
+    client->csSynced = true;
+    for (int i = 0; i < MAX_CONFIGSTRINGS; i++)
+    {
+        if (client->state == CS_PRIMED && client->csUpdated[i])
+        {
+            client->csSent[i] = csUnknown;
+        }
+        else
+        {
+            SV_SentConfigstring(client, i, SV_ClientConfigstring(client, i));
+        }
+    }
+}
+
 /*
 ===============
 SV_UpdateConfigstrings
@@ -180,6 +471,7 @@ void SV_SetConfigstring(int idx, const char *val)
         if (strcmp(val, sv.configstrings[idx].s))
         {
             modified[0] = true;
+            SV_ConfigstringChanging(idx);
             Z_Free(sv.configstrings[idx].s);
             sv.configstrings[idx].s = CopyString(val);
         }
@@ -198,10 +490,13 @@ void SV_SetConfigstring(int idx, const char *val)
         }
 
         // change the string in sv
+        SV_ConfigstringChanging(idx);
         Z_Free(sv.configstrings[idx].s);
         sv.configstrings[idx].s = CopyString(val);
     }
 
+    SV_DemoConfigstringModified(idx);
+
     // send it to all the clients if we aren't
     // spawning a new server
     if (sv.state == SS_GAME || sv.restarting)
@@ -553,6 +848,9 @@ void SV_SpawnServer(char *server)
     char systemInfo[16384];
     const char *p;
 
+    // finish the demo of the previous map
+    SV_DemoStop();
+
     // shut down the existing game if it is running
     SV_ShutdownGameProgs();
 
@@ -604,6 +902,9 @@ void SV_SpawnServer(char *server)
         {
             svs.clients[i].oldServerTime = sv.time;
         }
+
+        // configstring deltas wait for the new gamestate
+        SV_FreeConfigstrings(&svs.clients[i]);
     }
 
     // wipe the entire per-level structure
@@ -751,6 +1052,8 @@ void SV_SpawnServer(char *server)
     // send a heartbeat now so the master will get up to date info
     SV_Heartbeat_f();
 
+    SV_DemoAutoRecord();
+
     Hunk_SetMark();
 
 #ifndef DEDICATED
@@ -787,6 +1090,7 @@ void SV_Init(void)
     sv_minRate = Cvar_Get("sv_minRate", "0", CVAR_ARCHIVE | CVAR_SERVERINFO);
     sv_maxRate = Cvar_Get("sv_maxRate", "0", CVAR_ARCHIVE | CVAR_SERVERINFO);
     sv_dlRate = Cvar_Get("sv_dlRate", "100", CVAR_ARCHIVE | CVAR_SERVERINFO);
+    sv_dlCacheSize = Cvar_Get("sv_dlCacheSize", "4096", CVAR_ARCHIVE);
     sv_minPing = Cvar_Get("sv_minPing", "0", CVAR_ARCHIVE | CVAR_SERVERINFO);
     sv_maxPing = Cvar_Get("sv_maxPing", "0", CVAR_ARCHIVE | CVAR_SERVERINFO);
 
@@ -832,6 +1136,8 @@ void SV_Init(void)
     sv_mapChecksum = Cvar_Get("sv_mapChecksum", "", CVAR_ROM);
     sv_lanForceRate = Cvar_Get("sv_lanForceRate", "1", CVAR_ARCHIVE);
     sv_rsaAuth = Cvar_Get("sv_rsaAuth", "1", CVAR_INIT | CVAR_PROTECTED);
+
+    SV_DemoInit();
 }
 
 /*
@@ -894,6 +1200,7 @@ void SV_Shutdown(const char *finalmsg)
         SV_FinalMessage(finalmsg);
     }
 
+    SV_DemoStop();
     SV_RemoveOperatorCommands();
     SV_MasterShutdown();
     SV_ShutdownGameProgs();
@@ -58,6 +58,7 @@ cvar_t	*sv_serverid;
 cvar_t	*sv_minRate;
 cvar_t	*sv_maxRate;
 cvar_t	*sv_dlRate;
+cvar_t	*sv_dlCacheSize;
 cvar_t	*sv_minPing;
 cvar_t	*sv_maxPing;
 cvar_t	*sv_pure;
@@ -151,6 +152,10 @@ void SV_AddServerCommand( client_t *client, const char *cmd ) {
 	if( client->state < CS_PRIMED )
 		return;
 
+	// configstrings changed before this command must reach the client first
+	if( client->numCsQueued )
+		SV_FlushConfigstrings( client );
+
 	client->reliableSequence++;
 	// if we would be losing an old command that hasn't been acknowledged,
 	// we must drop the connection
@@ -204,6 +209,8 @@ void QDECL SV_SendServerCommand(client_t *cl, const char *fmt, ...) {
 	  return;
 	}
 
+	SV_DemoServerCommand( cl, (char *)message );
+
 	if ( cl != NULL ) {
 		SV_AddServerCommand( cl, (char *)message );
 		return;
@@ -1045,6 +1052,7 @@ happen before SV_Frame is called
 void SV_Frame( int msec ) {
 	int		frameMsec;
 	int		startTime;
+	int		i;
 
 	// the menu kills the server with this cvar
 	if ( sv_killserver->integer ) {
@@ -1135,6 +1143,9 @@ void SV_Frame( int msec ) {
 		sv.gvm->Call(GAME_RUN_FRAME, sv.time);
 	}
 
+	// record the world as the clients will see it
+	SV_DemoWriteFrame();
+
 	if ( com_speeds->integer ) {
 		time_game = Sys_Milliseconds () - startTime;
 	}
@@ -1142,6 +1153,11 @@ void SV_Frame( int msec ) {
 	// check timeouts
 	SV_CheckTimeouts();
 
+	// batch up the configstrings that changed this frame
+	for ( i = 0; i < sv_maxclients->integer; i++ ) {
+		SV_FlushConfigstrings( &svs.clients[i] );
+	}
+
 	// send messages back to the clients
 	SV_SendClientMessages();
 
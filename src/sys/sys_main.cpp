@@ -695,6 +695,7 @@ void Sys_SigHandler( int signal )
         CL_Shutdown(va("Received signal %d", signal), true, true);
 #endif
         SV_Shutdown(msg);
+        Com_LogFlush();
     }
 
     if( signal == SIGTERM || signal == SIGINT )
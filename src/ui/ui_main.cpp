@@ -4523,9 +4523,15 @@ UI_UpdateCvars
 */
 void UI_UpdateCvars(void)
 {
+    static int lastModificationCount = -1;
     size_t i;
     cvarTable_t *cv;
 
+    // nothing to pick up if no cvar changed since the last pass
+    if (Cvar_ModificationCount() == lastModificationCount)
+        return;
+    lastModificationCount = Cvar_ModificationCount();
+
     for (i = 0, cv = cvarTable; i < cvarTableSize; i++, cv++)
         Cvar_Update(cv->vmCvar);
 }